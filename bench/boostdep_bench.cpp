@@ -0,0 +1,438 @@
+// boostdep_bench - benchmarks for boostdep on a synthetic Boost tree
+//
+// Copyright 2026 agent
+//
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt
+
+#include "../src/dependency_scan.hpp"
+#include <cctype>
+
+// generator
+
+struct tree_parameters
+{
+    int modules_;
+    int headers_;
+
+    // #includes per header
+    int fanout_;
+
+    // module dependencies that go against the layering
+    int cycles_;
+
+    // approximate bytes per header
+    int size_;
+
+    unsigned seed_;
+};
+
+static unsigned next_random( unsigned & seed )
+{
+    // a fixed LCG, so that trees are identical across platforms
+    seed = seed * 1103515245u + 12345u;
+    return ( seed >> 16 ) & 0x7FFF;
+}
+
+static std::string synthetic_module( int i )
+{
+    std::ostringstream os;
+    os << "m" << std::setw( 3 ) << std::setfill( '0' ) << i;
+    return os.str();
+}
+
+static std::string synthetic_header( int m, int h )
+{
+    std::ostringstream os;
+    os << "boost/" << synthetic_module( m ) << "/h" << std::setw( 3 ) << std::setfill( '0' ) << h << ".hpp";
+    return os.str();
+}
+
+static void write_synthetic_header( fs::path const & p, std::string const & header, std::vector< std::string > const & includes, int size )
+{
+    fs::ofstream os( p );
+
+    std::string guard = header;
+
+    for( std::string::iterator i = guard.begin(); i != guard.end(); ++i )
+    {
+        *i = std::isalnum( static_cast< unsigned char >( *i ) )? std::toupper( static_cast< unsigned char >( *i ) ): '_';
+    }
+
+    os << "#ifndef " << guard << "_INCLUDED\n#define " << guard << "_INCLUDED\n\n";
+
+    for( std::vector< std::string >::const_iterator i = includes.begin(); i != includes.end(); ++i )
+    {
+        os << "#include <" << *i << ">\n";
+    }
+
+    os << "\nnamespace boost\n{\n\n";
+
+    for( int n = 0; os.tellp() < size; ++n )
+    {
+        os << "// synthetic declaration " << n << "\ntemplate<class T> struct s" << n << " { typedef T type; };\n\n";
+    }
+
+    os << "} // namespace boost\n\n#endif\n";
+}
+
+static void generate_tree( fs::path const & root, tree_parameters const & tp )
+{
+    fs::create_directories( root );
+
+    {
+        fs::ofstream os( root / "Jamroot" );
+        os << "# synthetic Boost tree\n";
+    }
+
+    unsigned seed = tp.seed_;
+
+    // module i depends on modules below it, except for the cycle edges
+
+    std::vector< std::set< int > > module_deps( tp.modules_ );
+
+    for( int i = 1; i < tp.modules_; ++i )
+    {
+        int n = std::min( i, tp.fanout_ );
+
+        for( int k = 0; k < n; ++k )
+        {
+            module_deps[ i ].insert( next_random( seed ) % i );
+        }
+    }
+
+    for( int k = 0; k < tp.cycles_ && tp.modules_ > 1; ++k )
+    {
+        int i = next_random( seed ) % ( tp.modules_ - 1 );
+        int j = i + 1 + next_random( seed ) % ( tp.modules_ - i - 1 );
+
+        module_deps[ i ].insert( j );
+    }
+
+    for( int i = 0; i < tp.modules_; ++i )
+    {
+        std::string module = synthetic_module( i );
+
+        fs::path dir = root / "libs" / module / "include" / "boost" / module;
+        fs::create_directories( dir );
+
+        std::vector< int > deps( module_deps[ i ].begin(), module_deps[ i ].end() );
+
+        for( int h = 0; h < tp.headers_; ++h )
+        {
+            std::vector< std::string > includes;
+
+            for( int k = 0; k < tp.fanout_; ++k )
+            {
+                // half of the #includes stay in the module, going downwards
+                if( ( deps.empty() || next_random( seed ) % 2 == 0 ) && h > 0 )
+                {
+                    includes.push_back( synthetic_header( i, next_random( seed ) % h ) );
+                }
+                else if( !deps.empty() )
+                {
+                    includes.push_back( synthetic_header( deps[ next_random( seed ) % deps.size() ], next_random( seed ) % tp.headers_ ) );
+                }
+            }
+
+            std::string header = synthetic_header( i, h );
+            write_synthetic_header( root / "libs" / module / "include" / header, header, includes, tp.size_ );
+        }
+    }
+}
+
+// harness
+
+struct benchmark
+{
+    char const * name_;
+    void (*function_)();
+};
+
+static double s_min_time = 500; // milliseconds
+
+static void run_benchmark( benchmark const & b )
+{
+    // grow the iteration count until a run takes long enough
+
+    long iterations = 1;
+    double wall, cpu;
+
+    for( ;; )
+    {
+        double w0 = wall_time_ms(), c0 = cpu_time_ms( false );
+
+        for( long i = 0; i < iterations; ++i )
+        {
+            b.function_();
+        }
+
+        wall = wall_time_ms() - w0;
+        cpu = cpu_time_ms( false ) - c0;
+
+        if( wall >= s_min_time || iterations >= 1000000000L / 2 ) break;
+
+        if( wall < s_min_time / 100 )
+        {
+            iterations *= 10;
+        }
+        else
+        {
+            iterations *= 2;
+        }
+    }
+
+    std::cout << std::left << std::setw( 40 ) << b.name_ << std::right << std::fixed << std::setprecision( 3 )
+        << std::setw( 14 ) << wall / iterations << " ms" << std::setw( 14 ) << cpu / iterations << " ms" << std::setw( 12 ) << iterations << std::endl;
+}
+
+// benchmarks
+
+struct null_level_actions: public module_level_actions
+{
+    void begin() {}
+    void end() {}
+    void level_start( int ) {}
+    void level_end( int ) {}
+    void module_start( std::string const & ) {}
+    void module_end( std::string const & ) {}
+    void module2( std::string const &, int ) {}
+};
+
+struct null_secondary_actions: public module_secondary_actions
+{
+    void heading( std::string const & ) {}
+    void module_start( std::string const & ) {}
+    void module_end( std::string const & ) {}
+    void module_adds( std::string const & ) {}
+};
+
+struct null_subset_actions: public module_subset_actions
+{
+    void heading( std::string const & ) {}
+    void module_start( std::string const & ) {}
+    void module_end( std::string const & ) {}
+    void from_path( std::vector<std::string> const & ) {}
+};
+
+// header -> contents
+static std::vector< std::pair< std::string, std::string > > s_header_contents;
+
+static void load_header_contents()
+{
+    for( std::map< std::string, std::string >::const_iterator i = s_context->header_map_.begin(); i != s_context->header_map_.end(); ++i )
+    {
+        fs::ifstream is( root_path( module_include_path( i->second ) / i->first ) );
+
+        std::ostringstream os;
+        os << is.rdbuf();
+
+        s_header_contents.push_back( std::make_pair( i->first, os.str() ) );
+    }
+}
+
+// each run has a context of its own, so that nothing that the previous
+// run has resolved or cached is left
+
+static void bm_build_header_map()
+{
+    context c;
+    c.root_ = s_context->root_;
+
+    context_scope scope( c );
+
+    build_header_map();
+}
+
+static void bm_scan_header_dependencies()
+{
+    scan_result r;
+
+    for( std::vector< std::pair< std::string, std::string > >::const_iterator i = s_header_contents.begin(); i != s_header_contents.end(); ++i )
+    {
+        scan_header_dependencies( i->first, i->second, r );
+    }
+}
+
+static void bm_build_module_dependency_map()
+{
+    // the header map is copied, which takes little time next to the scan
+    context c;
+    c.root_ = s_context->root_;
+
+    c.header_map_ = s_context->header_map_;
+    c.module_headers_ = s_context->module_headers_;
+    c.modules_ = s_context->modules_;
+    c.header_map_complete_ = true;
+
+    context_scope scope( c );
+
+    build_module_dependency_map( false, false );
+}
+
+static void bm_module_secondary_report()
+{
+    null_secondary_actions actions;
+
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        output_module_secondary_report( *i, actions );
+    }
+}
+
+static void bm_module_level_report()
+{
+    null_level_actions actions;
+    output_module_level_report( actions );
+}
+
+static void bm_module_subset_report()
+{
+    // the top module has the largest closure
+    std::string const & module = *s_context->modules_.rbegin();
+
+    null_subset_actions actions;
+    output_module_subset_report_( module, s_context->module_headers_[ module ], s_context->header_includes_, actions );
+}
+
+static benchmark const s_benchmarks[] =
+{
+    { "build_header_map", bm_build_header_map },
+    { "scan_header_dependencies", bm_scan_header_dependencies },
+    { "build_module_dependency_map", bm_build_module_dependency_map },
+    { "output_module_secondary_report", bm_module_secondary_report },
+    { "output_module_level_report", bm_module_level_report },
+    { "output_module_subset_report_", bm_module_subset_report },
+};
+
+int main( int argc, char const* argv[] )
+{
+    tree_parameters tp = { 50, 20, 4, 0, 2000, 1 };
+
+    fs::path root;
+    bool generate_only = false;
+    std::string filter;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        std::string option = argv[ i ];
+
+        if( option == "--generate" && i + 1 < argc )
+        {
+            root = argv[ ++i ];
+            generate_only = true;
+        }
+        else if( option == "--root" && i + 1 < argc )
+        {
+            root = argv[ ++i ];
+        }
+        else if( option == "--modules" && i + 1 < argc )
+        {
+            tp.modules_ = std::atoi( argv[ ++i ] );
+        }
+        else if( option == "--headers" && i + 1 < argc )
+        {
+            tp.headers_ = std::atoi( argv[ ++i ] );
+        }
+        else if( option == "--fanout" && i + 1 < argc )
+        {
+            tp.fanout_ = std::atoi( argv[ ++i ] );
+        }
+        else if( option == "--cycles" && i + 1 < argc )
+        {
+            tp.cycles_ = std::atoi( argv[ ++i ] );
+        }
+        else if( option == "--size" && i + 1 < argc )
+        {
+            tp.size_ = std::atoi( argv[ ++i ] );
+        }
+        else if( option == "--seed" && i + 1 < argc )
+        {
+            tp.seed_ = std::atoi( argv[ ++i ] );
+        }
+        else if( option == "--min-time" && i + 1 < argc )
+        {
+            s_min_time = std::atof( argv[ ++i ] );
+        }
+        else if( option == "--filter" && i + 1 < argc )
+        {
+            filter = argv[ ++i ];
+        }
+        else
+        {
+            std::cerr << "Usage:\n"
+                "\n"
+                "    boostdep_bench [--root <dir>] [--modules <n>] [--headers <n>] [--fanout <n>]\n"
+                "                   [--cycles <n>] [--size <bytes>] [--seed <n>]\n"
+                "                   [--min-time <ms>] [--filter <substring>]\n"
+                "    boostdep_bench --generate <dir> [tree options]\n"
+                "\n"
+                "    Without --root, the tree is generated in a temporary directory.\n";
+
+            return -1;
+        }
+    }
+
+    bool temporary = root.empty();
+
+    context ctx;
+    context_scope cs( ctx );
+
+    if( temporary )
+    {
+        root = fs::temp_directory_path() / fs::unique_path( "boostdep-bench-%%%%-%%%%" );
+    }
+
+    try
+    {
+        if( generate_only || temporary || !fs::exists( root ) )
+        {
+            generate_tree( root, tp );
+        }
+
+        if( generate_only )
+        {
+            return 0;
+        }
+
+        ctx.root_ = fs::absolute( root );
+
+        build_header_map();
+        load_header_contents();
+        build_module_dependency_map( false, false );
+
+        unsigned long bytes = 0;
+
+        for( std::vector< std::pair< std::string, std::string > >::const_iterator i = s_header_contents.begin(); i != s_header_contents.end(); ++i )
+        {
+            bytes += i->second.size();
+        }
+
+        std::cout << "Tree: " << s_context->modules_.size() << " modules, " << s_context->header_map_.size() << " headers, " << bytes << " bytes"
+            << " (fanout " << tp.fanout_ << ", cycles " << tp.cycles_ << ", seed " << tp.seed_ << ")\n\n";
+
+        std::cout << std::left << std::setw( 40 ) << "Benchmark" << std::right << std::setw( 17 ) << "Wall" << std::setw( 17 ) << "CPU" << std::setw( 12 ) << "Iterations" << "\n";
+        std::cout << std::string( 86, '-' ) << "\n";
+
+        for( std::size_t i = 0; i < sizeof( s_benchmarks ) / sizeof( s_benchmarks[ 0 ] ); ++i )
+        {
+            if( std::string( s_benchmarks[ i ].name_ ).find( filter ) != std::string::npos )
+            {
+                run_benchmark( s_benchmarks[ i ] );
+            }
+        }
+    }
+    catch( fs::filesystem_error const & x )
+    {
+        std::cerr << x.what() << std::endl;
+        return -3;
+    }
+
+    if( temporary )
+    {
+        fs::remove_all( root );
+    }
+
+    return 0;
+}
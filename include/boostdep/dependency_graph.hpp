@@ -0,0 +1,84 @@
+#ifndef BOOSTDEP_DEPENDENCY_GRAPH_HPP_INCLUDED
+#define BOOSTDEP_DEPENDENCY_GRAPH_HPP_INCLUDED
+
+// boostdep/dependency_graph.hpp - the dependency graph of a Boost tree
+//
+// Copyright 2026 agent
+//
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+namespace boostdep
+{
+
+// Scans a Boost tree once, then answers queries about it without
+// rescanning. Graphs are independent of each other and may be used
+// from several threads.
+
+class dependency_graph
+{
+private:
+
+    struct impl;
+    impl * pi_;
+
+    dependency_graph( dependency_graph const & );
+    dependency_graph & operator=( dependency_graph const & );
+
+public:
+
+    // module levels that cannot be computed due to cycles
+    static int const unknown_level = -1;
+
+    // scans the Boost tree at `root`; throws std::runtime_error when
+    // `root` is not a Boost root, boost::filesystem::filesystem_error
+    // on I/O errors
+    explicit dependency_graph( std::string const & root, bool track_sources = false, bool track_tests = false, int jobs = 1 );
+
+    ~dependency_graph();
+
+    std::string root() const;
+
+    // modules and headers
+
+    std::set< std::string > modules() const;
+    std::set< std::string > module_headers( std::string const & module ) const;
+
+    // the module that contains `header`, or "" when there isn't one
+    std::string header_module( std::string const & header ) const;
+
+    // headers that `header` includes, and that include `header`
+    std::set< std::string > header_includes( std::string const & header ) const;
+    std::set< std::string > header_included_by( std::string const & header ) const;
+
+    // module dependencies
+
+    // modules that `module` includes headers from (--primary)
+    std::set< std::string > primary( std::string const & module ) const;
+
+    // modules that `module` depends on indirectly, but not directly (--secondary)
+    std::set< std::string > secondary( std::string const & module ) const;
+
+    // modules that include headers from `module` (--reverse)
+    std::set< std::string > reverse( std::string const & module ) const;
+
+    // module -> level, or unknown_level (--module-levels)
+    std::map< std::string, int > levels() const;
+
+    // module -> number of primary and secondary dependencies (--module-weights)
+    std::map< std::string, int > weights() const;
+
+    // module -> include paths from a header of `module` to a header of
+    // that module, at most four per module (--subset)
+    std::map< std::string, std::vector< std::vector< std::string > > > subset( std::string const & module ) const;
+};
+
+} // namespace boostdep
+
+#endif // #ifndef BOOSTDEP_DEPENDENCY_GRAPH_HPP_INCLUDED
@@ -9,421 +9,304 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 
-#include <boost/filesystem.hpp>
-#include <boost/filesystem/fstream.hpp>
-#include <string>
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <map>
-#include <set>
-#include <algorithm>
-#include <climits>
-#include <cstdlib>
-#include <streambuf>
-#include <sstream>
-
-namespace fs = boost::filesystem;
-
-// header -> module
-static std::map< std::string, std::string > s_header_map;
-
-// module -> headers
-static std::map< std::string, std::set<std::string> > s_module_headers;
-
-static std::set< std::string > s_modules;
-
-static void scan_module_headers( fs::path const & path )
+#include "dependency_scan.hpp"
+#include <boost/dynamic_bitset.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <unistd.h>
+# include <fcntl.h>
+# include <sys/wait.h>
+# include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+# include <sys/inotify.h>
+# include <poll.h>
+# include <malloc.h>
+#elif defined(__APPLE__)
+# include <malloc/malloc.h>
+#elif defined(_MSC_VER)
+# include <malloc.h>
+#endif
+
+// --mem-stats
+
+static std::size_t allocation_size( void * p )
 {
-    try
-    {
-        std::string module = path.generic_string().substr( 5 ); // strip "libs/"
+#if defined(__GLIBC__)
 
-        std::replace( module.begin(), module.end(), '/', '~' );
+    return malloc_usable_size( p );
 
-        s_modules.insert( module );
+#elif defined(__APPLE__)
 
-        fs::path dir = path / "include";
-        size_t n = dir.generic_string().size();
+    return malloc_size( p );
 
-        fs::recursive_directory_iterator it( dir ), last;
+#elif defined(_MSC_VER)
 
-        for( ; it != last; ++it )
-        {
-            if( it->status().type() == fs::directory_file )
-            {
-                continue;
-            }
+    return _msize( p );
 
-            std::string p2 = it->path().generic_string();
-            p2 = p2.substr( n+1 );
+#else
 
-            s_header_map[ p2 ] = module;
-            s_module_headers[ module ].insert( p2 );
-        }
-    }
-    catch( fs::filesystem_error const & x )
-    {
-        std::cout << x.what() << std::endl;
-    }
-}
+    (void)p;
+    return 0;
 
-static void scan_submodules( fs::path const & path )
-{
-    fs::directory_iterator it( path ), last;
+#endif
+}
 
-    for( ; it != last; ++it )
-    {
-        fs::directory_entry const & e = *it;
+#if defined(BOOST_NO_CXX11_NOEXCEPT)
+# define BOOSTDEP_THROW_BAD_ALLOC throw( std::bad_alloc )
+#else
+# define BOOSTDEP_THROW_BAD_ALLOC
+#endif
 
-        if( e.status().type() != fs::directory_file )
-        {
-            continue;
-        }
+// the global allocation functions are replaced so that --mem-stats
+// can count allocations; when it's not given, they only forward to
+// malloc and free
 
-        fs::path path = e.path();
+static void count_allocation( long long m )
+{
+    ++s_mem_allocations;
+    s_mem_allocated += m;
 
-        if( fs::exists( path / "include" ) )
-        {
-            scan_module_headers( path );
-        }
+    long long live = s_mem_live += m;
 
-        if( fs::exists( path / "sublibs" ) )
-        {
-            scan_submodules( path );
-        }
-    }
+    raise_mem_peak( live );
 }
 
-static void build_header_map()
+// the blocks allocated before --mem-stats was seen aren't counted, but
+// can't be told apart when freed, so the live size stops at zero
+static void count_deallocation( long long m )
 {
-    scan_submodules( "libs" );
-}
+#if defined(BOOSTDEP_HAS_THREADS)
 
-static void scan_header_dependencies( std::string const & header, std::istream & is, std::map< std::string, std::set< std::string > > & deps, std::map< std::string, std::set< std::string > > & from )
-{
-    std::string line;
+    long long live = s_mem_live.load();
 
-    while( std::getline( is, line ) )
+    while( !s_mem_live.compare_exchange_weak( live, live > m? live - m: 0 ) )
     {
-        while( !line.empty() && ( line[0] == ' ' || line[0] == '\t' ) )
-        {
-            line.erase( 0, 1 );
-        }
-
-        if( line.empty() || line[0] != '#' ) continue;
-
-        line.erase( 0, 1 );
-
-        while( !line.empty() && ( line[0] == ' ' || line[0] == '\t' ) )
-        {
-            line.erase( 0, 1 );
-        }
+    }
 
-        if( line.substr( 0, 7 ) != "include" ) continue;
+#else
 
-        line.erase( 0, 7 );
+    s_mem_live = s_mem_live > m? s_mem_live - m: 0;
 
-        while( !line.empty() && ( line[0] == ' ' || line[0] == '\t' ) )
-        {
-            line.erase( 0, 1 );
-        }
+#endif
+}
 
-        if( line.size() < 2 ) continue;
+static void call_new_handler()
+{
+    std::new_handler h = std::set_new_handler( 0 );
+    std::set_new_handler( h );
 
-        char ch = line[0];
+    if( h == 0 )
+    {
+        throw std::bad_alloc();
+    }
 
-        if( ch != '<' && ch != '"' ) continue;
+    h();
+}
 
-        if( ch == '<' )
-        {
-            ch = '>';
-        }
+void * operator new( std::size_t n ) BOOSTDEP_THROW_BAD_ALLOC
+{
+    void * p;
 
-        line.erase( 0, 1 );
+    while( ( p = std::malloc( n? n: 1 ) ) == 0 )
+    {
+        call_new_handler();
+    }
 
-        std::string::size_type k = line.find_first_of( ch );
+    if( s_mem_stats )
+    {
+        count_allocation( allocation_size( p ) );
+    }
 
-        if( k != std::string::npos )
-        {
-            line.erase( k );
-        }
+    return p;
+}
 
-        std::map< std::string, std::string >::const_iterator i = s_header_map.find( line );
+void * operator new[]( std::size_t n ) BOOSTDEP_THROW_BAD_ALLOC
+{
+    return operator new( n );
+}
 
-        if( i != s_header_map.end() )
-        {
-            deps[ i->second ].insert( line );
-            from[ line ].insert( header );
-        }
-        else if( line.substr( 0, 6 ) == "boost/" )
-        {
-            deps[ "(unknown)" ].insert( line );
-            from[ line ].insert( header );
-        }
+void * operator new( std::size_t n, std::nothrow_t const & ) BOOST_NOEXCEPT_OR_NOTHROW
+{
+    try
+    {
+        return operator new( n );
+    }
+    catch( std::bad_alloc const & )
+    {
+        return 0;
     }
 }
 
-struct module_primary_actions
+void * operator new[]( std::size_t n, std::nothrow_t const & ) BOOST_NOEXCEPT_OR_NOTHROW
 {
-    virtual void heading( std::string const & module ) = 0;
+    return operator new( n, std::nothrow );
+}
 
-    virtual void module_start( std::string const & module ) = 0;
-    virtual void module_end( std::string const & module ) = 0;
+void operator delete( void * p ) BOOST_NOEXCEPT_OR_NOTHROW
+{
+    if( p == 0 ) return;
 
-    virtual void header_start( std::string const & header ) = 0;
-    virtual void header_end( std::string const & header ) = 0;
+    if( s_mem_stats )
+    {
+        count_deallocation( allocation_size( p ) );
+    }
 
-    virtual void from_header( std::string const & header ) = 0;
-};
+    std::free( p );
+}
 
-static fs::path module_include_path( std::string module )
+void operator delete[]( void * p ) BOOST_NOEXCEPT_OR_NOTHROW
 {
-    std::replace( module.begin(), module.end(), '~', '/' );
-    return fs::path( "libs" ) / module / "include";
+    operator delete( p );
 }
 
-static fs::path module_source_path( std::string module )
+void operator delete( void * p, std::nothrow_t const & ) BOOST_NOEXCEPT_OR_NOTHROW
 {
-    std::replace( module.begin(), module.end(), '~', '/' );
-    return fs::path( "libs" ) / module / "src";
+    operator delete( p );
 }
 
-static fs::path module_build_path( std::string module )
+void operator delete[]( void * p, std::nothrow_t const & ) BOOST_NOEXCEPT_OR_NOTHROW
 {
-    std::replace( module.begin(), module.end(), '~', '/' );
-    return fs::path( "libs" ) / module / "build";
+    operator delete( p );
 }
 
-static fs::path module_test_path( std::string module )
+// C++14 sized deallocation; the size is that of the request, not of
+// the block, so the block is still measured
+
+void operator delete( void * p, std::size_t ) BOOST_NOEXCEPT_OR_NOTHROW
 {
-    std::replace( module.begin(), module.end(), '~', '/' );
-    return fs::path( "libs" ) / module / "test";
+    operator delete( p );
 }
 
-static void scan_module_path( fs::path const & dir, bool remove_prefix, std::map< std::string, std::set< std::string > > & deps, std::map< std::string, std::set< std::string > > & from )
+void operator delete[]( void * p, std::size_t ) BOOST_NOEXCEPT_OR_NOTHROW
 {
-    size_t n = dir.generic_string().size();
+    operator delete( p );
+}
 
-    if( fs::exists( dir ) )
-    {
-        fs::recursive_directory_iterator it( dir ), last;
+#if defined(__cpp_aligned_new)
 
-        for( ; it != last; ++it )
-        {
-            if( it->status().type() == fs::directory_file )
-            {
-                continue;
-            }
+// C++17 allocation of over-aligned types
 
-            std::string header = it->path().generic_string();
+static void * aligned_allocate( std::size_t n, std::size_t a )
+{
+#if defined(_MSC_VER)
 
-            if( remove_prefix )
-            {
-                header = header.substr( n+1 );
-            }
+    return _aligned_malloc( n, a );
 
-            fs::ifstream is( it->path() );
+#else
 
-            scan_header_dependencies( header, is, deps, from );
-        }
-    }
+    void * p = 0;
+    return posix_memalign( &p, a < sizeof( void* )? sizeof( void* ): a, n ) == 0? p: 0;
+
+#endif
 }
 
-static void scan_module_dependencies( std::string const & module, module_primary_actions & actions, bool track_sources, bool track_tests, bool include_self )
+static std::size_t aligned_allocation_size( void * p, std::size_t a )
 {
-    // module -> [ header, header... ]
-    std::map< std::string, std::set< std::string > > deps;
-
-    // header -> included from [ header, header... ]
-    std::map< std::string, std::set< std::string > > from;
-
-    scan_module_path( module_include_path( module ), true, deps, from );
-
-    if( track_sources )
-    {
-        scan_module_path( module_source_path( module ), false, deps, from );
-    }
+#if defined(_MSC_VER)
 
-    if( track_tests )
-    {
-        scan_module_path( module_test_path( module ), false, deps, from );
-    }
+    return _aligned_msize( p, a, 0 );
 
-    actions.heading( module );
+#else
 
-    for( std::map< std::string, std::set< std::string > >::iterator i = deps.begin(); i != deps.end(); ++i )
-    {
-        if( i->first == module && !include_self ) continue;
+    (void)a;
+    return allocation_size( p );
 
-        actions.module_start( i->first );
+#endif
+}
 
-        for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
-        {
-            actions.header_start( *j );
+static void aligned_free( void * p )
+{
+#if defined(_MSC_VER)
 
-            std::set< std::string > const & f = from[ *j ];
+    _aligned_free( p );
 
-            for( std::set< std::string >::const_iterator k = f.begin(); k != f.end(); ++k )
-            {
-                actions.from_header( *k );
-            }
+#else
 
-            actions.header_end( *j );
-        }
+    std::free( p );
 
-        actions.module_end( i->first );
-    }
+#endif
 }
 
-// module depends on [ module, module... ]
-static std::map< std::string, std::set< std::string > > s_module_deps;
-
-// header is included by [header, header...]
-static std::map< std::string, std::set< std::string > > s_header_deps;
-
-// [ module, module... ] depend on module
-static std::map< std::string, std::set< std::string > > s_reverse_deps;
-
-// header includes [header, header...]
-static std::map< std::string, std::set< std::string > > s_header_includes;
-
-struct build_mdmap_actions: public module_primary_actions
+void * operator new( std::size_t n, std::align_val_t a )
 {
-    std::string module_;
-    std::string module2_;
-    std::string header_;
-
-    void heading( std::string const & module )
-    {
-        module_ = module;
-    }
-
-    void module_start( std::string const & module )
-    {
-        if( module != module_ )
-        {
-            s_module_deps[ module_ ].insert( module );
-            s_reverse_deps[ module ].insert( module_ );
-        }
-
-        module2_ = module;
-    }
-
-    void module_end( std::string const & /*module*/ )
-    {
-    }
+    void * p;
 
-    void header_start( std::string const & header )
+    while( ( p = aligned_allocate( n? n: 1, static_cast< std::size_t >( a ) ) ) == 0 )
     {
-        header_ = header;
+        call_new_handler();
     }
 
-    void header_end( std::string const & /*header*/ )
+    if( s_mem_stats )
     {
+        count_allocation( aligned_allocation_size( p, static_cast< std::size_t >( a ) ) );
     }
 
-    void from_header( std::string const & header )
-    {
-        if( module_ != module2_ )
-        {
-            s_header_deps[ header_ ].insert( header );
-        }
-
-        s_header_includes[ header ].insert( header_ );
-    }
-};
+    return p;
+}
 
-static void build_module_dependency_map( bool track_sources, bool track_tests )
+void * operator new[]( std::size_t n, std::align_val_t a )
 {
-    for( std::set< std::string >::iterator i = s_modules.begin(); i != s_modules.end(); ++i )
-    {
-        build_mdmap_actions actions;
-        scan_module_dependencies( *i, actions, track_sources, track_tests, true );
-    }
+    return operator new( n, a );
 }
 
-static void output_module_primary_report( std::string const & module, module_primary_actions & actions, bool track_sources, bool track_tests )
+void * operator new( std::size_t n, std::align_val_t a, std::nothrow_t const & ) noexcept
 {
     try
     {
-        scan_module_dependencies( module, actions, track_sources, track_tests, false );
+        return operator new( n, a );
     }
-    catch( fs::filesystem_error const & x )
+    catch( std::bad_alloc const & )
     {
-        std::cout << x.what() << std::endl;
+        return 0;
     }
 }
 
-struct module_secondary_actions
-{
-    virtual void heading( std::string const & module ) = 0;
-
-    virtual void module_start( std::string const & module ) = 0;
-    virtual void module_end( std::string const & module ) = 0;
-
-    virtual void module_adds( std::string const & module ) = 0;
-};
-
-static void exclude( std::set< std::string > & x, std::set< std::string > const & y )
+void * operator new[]( std::size_t n, std::align_val_t a, std::nothrow_t const & ) noexcept
 {
-    for( std::set< std::string >::const_iterator i = y.begin(); i != y.end(); ++i )
-    {
-        x.erase( *i );
-    }
+    return operator new( n, a, std::nothrow );
 }
 
-static void output_module_secondary_report( std::string const & module, std::set< std::string> deps, module_secondary_actions & actions )
+void operator delete( void * p, std::align_val_t a ) noexcept
 {
-    actions.heading( module );
+    if( p == 0 ) return;
 
-    deps.insert( module );
-
-    // build transitive closure
-
-    for( ;; )
+    if( s_mem_stats )
     {
-        std::set< std::string > deps2( deps );
-
-        for( std::set< std::string >::iterator i = deps.begin(); i != deps.end(); ++i )
-        {
-            std::set< std::string > deps3 = s_module_deps[ *i ];
-
-            exclude( deps3, deps );
-
-            if( deps3.empty() )
-            {
-                continue;
-            }
+        count_deallocation( aligned_allocation_size( p, static_cast< std::size_t >( a ) ) );
+    }
 
-            actions.module_start( *i );
+    aligned_free( p );
+}
 
-            for( std::set< std::string >::iterator j = deps3.begin(); j != deps3.end(); ++j )
-            {
-                actions.module_adds( *j );
-            }
+void operator delete[]( void * p, std::align_val_t a ) noexcept
+{
+    operator delete( p, a );
+}
 
-            actions.module_end( *i );
+void operator delete( void * p, std::size_t, std::align_val_t a ) noexcept
+{
+    operator delete( p, a );
+}
 
-            deps2.insert( deps3.begin(), deps3.end() );
-        }
+void operator delete[]( void * p, std::size_t, std::align_val_t a ) noexcept
+{
+    operator delete( p, a );
+}
 
-        if( deps == deps2 )
-        {
-            break;
-        }
-        else
-        {
-            deps = deps2;
-        }
-    }
+void operator delete( void * p, std::align_val_t a, std::nothrow_t const & ) noexcept
+{
+    operator delete( p, a );
 }
 
-static void output_module_secondary_report( std::string const & module, module_secondary_actions & actions )
+void operator delete[]( void * p, std::align_val_t a, std::nothrow_t const & ) noexcept
 {
-    output_module_secondary_report( module, s_module_deps[ module ], actions );
+    operator delete( p, a );
 }
 
+#endif // defined(__cpp_aligned_new)
+
 struct header_inclusion_actions
 {
     virtual void heading( std::string const & header, std::string const & module ) = 0;
@@ -436,11 +319,11 @@ struct header_inclusion_actions
 
 static void output_header_inclusion_report( std::string const & header, header_inclusion_actions & actions )
 {
-    std::string module = s_header_map[ header ];
+    std::string module = s_context->header_map_[ header ];
 
     actions.heading( header, module );
 
-    std::set< std::string > from = s_header_deps[ header ];
+    std::set< std::string > from = s_context->header_deps_[ header ];
 
     // classify 'from' dependencies by module
 
@@ -449,7 +332,7 @@ static void output_header_inclusion_report( std::string const & header, header_i
 
     for( std::set< std::string >::iterator i = from.begin(); i != from.end(); ++i )
     {
-        from2[ s_header_map[ *i ] ].insert( *i );
+        from2[ s_context->header_map_[ *i ] ].insert( *i );
     }
 
     for( std::map< std::string, std::set< std::string > >::iterator i = from2.begin(); i != from2.end(); ++i )
@@ -691,21 +574,21 @@ static void output_module_reverse_report( std::string const & module, module_rev
 {
     actions.heading( module );
 
-    std::set< std::string > const from = s_reverse_deps[ module ];
+    std::set< std::string > const from = s_context->reverse_deps_[ module ];
 
     for( std::set< std::string >::const_iterator i = from.begin(); i != from.end(); ++i )
     {
         actions.module_start( *i );
 
-        for( std::map< std::string, std::set< std::string > >::iterator j = s_header_deps.begin(); j != s_header_deps.end(); ++j )
+        for( std::map< std::string, std::set< std::string > >::iterator j = s_context->header_deps_.begin(); j != s_context->header_deps_.end(); ++j )
         {
-            if( s_header_map[ j->first ] == module )
+            if( s_context->header_map_[ j->first ] == module )
             {
                 bool header_started = false;
 
                 for( std::set< std::string >::iterator k = j->second.begin(); k != j->second.end(); ++k )
                 {
-                    if( s_header_map[ *k ] == *i )
+                    if( s_context->header_map_[ *k ] == *i )
                     {
                         if( !header_started )
                         {
@@ -809,275 +692,69 @@ static void output_module_reverse_report( std::string const & module, bool html
 
 // module_level_report
 
-int const unknown_level = INT_MAX / 2;
-
-struct module_level_actions
+struct module_level_txt_actions: public module_level_actions
 {
-    virtual void begin() = 0;
-    virtual void end() = 0;
-
-    virtual void level_start( int level ) = 0;
-    virtual void level_end( int level ) = 0;
-
-    virtual void module_start( std::string const & module ) = 0;
-    virtual void module_end( std::string const & module ) = 0;
-
-    virtual void module2( std::string const & module, int level ) = 0;
-};
+    int level_;
 
-static void output_module_level_report( module_level_actions & actions )
-{
-    // build module level map
+    void begin()
+    {
+        std::cout << "Module Levels:\n\n";
+    }
 
-    std::map< std::string, int > level_map;
+    void end()
+    {
+    }
 
-    for( std::set< std::string >::iterator i = s_modules.begin(); i != s_modules.end(); ++i )
+    void level_start( int level )
     {
-        if( s_module_deps[ *i ].empty() )
+        if( level >= unknown_level )
         {
-            level_map[ *i ] = 0;
-            // std::cerr << *i << ": " << 0 << std::endl;
+            std::cout << "Level (undetermined):\n";
         }
         else
         {
-            level_map[ *i ] = unknown_level;
+            std::cout << "Level " << level << ":\n";
         }
-    }
 
-    // build transitive closure to see through cycles
+        level_ = level;
+    }
 
-    std::map< std::string, std::set< std::string > > deps2 = s_module_deps;
+    void level_end( int /*level*/ )
+    {
+        std::cout << "\n";
+    }
 
+    void module_start( std::string const & module )
     {
-        bool done;
+        std::cout << "    " << module;
 
-        do
+        if( level_ > 0 )
         {
-            done = true;
-
-            for( std::map< std::string, std::set< std::string > >::iterator i = deps2.begin(); i != deps2.end(); ++i )
-            {
-                std::set< std::string > tmp = i->second;
-
-                for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
-                {
-                    std::set< std::string > tmp2 = deps2[ *j ];
-                    tmp.insert( tmp2.begin(), tmp2.end() );
-                }
-
-                if( tmp.size() != i->second.size() )
-                {
-                    i->second = tmp;
-                    done = false;
-                }
-            }
+            std::cout << " ->";
         }
-        while( !done );
     }
 
-    // compute acyclic levels
+    void module_end( std::string const & /*module*/ )
+    {
+        std::cout << "\n";
+    }
 
-    for( int k = 1, n = s_modules.size(); k < n; ++k )
+    void module2( std::string const & module, int level )
     {
-        for( std::map< std::string, std::set< std::string > >::iterator i = s_module_deps.begin(); i != s_module_deps.end(); ++i )
+        std::cout << " " << module << "(";
+
+        if( level >= unknown_level )
+        {
+            std::cout << "-";
+        }
+        else
         {
-            // i->first depends on i->second
+            std::cout << level;
+        }
 
-            if( level_map[ i->first ] >= unknown_level )
-            {
-                int level = 0;
-
-                for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
-                {
-                    level = std::max( level, level_map[ *j ] + 1 );
-                }
-
-                if( level == k )
-                {
-                    level_map[ i->first ] = level;
-                    // std::cerr << i->first << ": " << level << std::endl;
-                }
-            }
-        }
-    }
-
-    // min_level_map[ M ] == L means the level is unknown, but at least L
-    std::map< std::string, int > min_level_map;
-
-    // initialize min_level_map for acyclic dependencies
-
-    for( std::map< std::string, int >::iterator i = level_map.begin(); i != level_map.end(); ++i )
-    {
-        if( i->second < unknown_level )
-        {
-            min_level_map[ i->first ] = i->second;
-        }
-    }
-
-    // compute levels for cyclic modules
-
-    for( int k = 1, n = s_modules.size(); k < n; ++k )
-    {
-        for( std::map< std::string, std::set< std::string > >::iterator i = s_module_deps.begin(); i != s_module_deps.end(); ++i )
-        {
-            if( level_map[ i->first ] >= unknown_level )
-            {
-                int level = 0;
-
-                for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
-                {
-                    int jl = level_map[ *j ];
-
-                    if( jl < unknown_level )
-                    {
-                        level = std::max( level, jl + 1 );
-                    }
-                    else
-                    {
-                        int ml = min_level_map[ *j ];
-
-                        if( deps2[ *j ].count( i->first ) == 0 )
-                        {
-                            // *j does not depend on i->first, so
-                            // the level of i->first is at least
-                            // 1 + the minimum level of *j
-
-                            ++ml;
-                        }
-
-                        level = std::max( level, ml );
-                    }
-                }
-
-                min_level_map[ i->first ] = level;
-            }
-        }
-    }
-
-    // reverse level map
-
-    std::map< int, std::set< std::string > > reverse_level_map;
-
-    for( std::map< std::string, int >::iterator i = level_map.begin(); i != level_map.end(); ++i )
-    {
-        int level = i->second;
-
-        if( level >= unknown_level )
-        {
-            int min_level = min_level_map[ i->first ];
-
-            if( min_level != 0 )
-            {
-                level = min_level;
-            }
-        }
-
-        reverse_level_map[ level ].insert( i->first );
-    }
-
-    // output report
-
-    actions.begin();
-
-    for( std::map< int, std::set< std::string > >::iterator i = reverse_level_map.begin(); i != reverse_level_map.end(); ++i )
-    {
-        actions.level_start( i->first );
-
-        for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
-        {
-            actions.module_start( *j );
-
-            std::set< std::string > mdeps = s_module_deps[ *j ];
-
-            for( std::set< std::string >::iterator k = mdeps.begin(); k != mdeps.end(); ++k )
-            {
-                int level = level_map[ *k ];
-
-                if( level >= unknown_level )
-                {
-                    int min_level = min_level_map[ *k ];
-
-                    if( min_level != 0 )
-                    {
-                        level = min_level;
-                    }
-                }
-
-                actions.module2( *k, level );
-            }
-
-            actions.module_end( *j );
-        }
-
-        actions.level_end( i->first );
-    }
-
-    actions.end();
-}
-
-struct module_level_txt_actions: public module_level_actions
-{
-    int level_;
-
-    void begin()
-    {
-        std::cout << "Module Levels:\n\n";
-    }
-
-    void end()
-    {
-    }
-
-    void level_start( int level )
-    {
-        if( level >= unknown_level )
-        {
-            std::cout << "Level (undetermined):\n";
-        }
-        else
-        {
-            std::cout << "Level " << level << ":\n";
-        }
-
-        level_ = level;
-    }
-
-    void level_end( int /*level*/ )
-    {
-        std::cout << "\n";
-    }
-
-    void module_start( std::string const & module )
-    {
-        std::cout << "    " << module;
-
-        if( level_ > 0 )
-        {
-            std::cout << " ->";
-        }
-    }
-
-    void module_end( std::string const & /*module*/ )
-    {
-        std::cout << "\n";
-    }
-
-    void module2( std::string const & module, int level )
-    {
-        std::cout << " " << module << "(";
-
-        if( level >= unknown_level )
-        {
-            std::cout << "-";
-        }
-        else
-        {
-            std::cout << level;
-        }
-
-        std::cout << ")";
-    }
-};
+        std::cout << ")";
+    }
+};
 
 struct module_level_html_actions: public module_level_actions
 {
@@ -1173,27 +850,48 @@ struct module_overview_actions
     virtual void module2( std::string const & module ) = 0;
 };
 
-static void output_module_overview_report( module_overview_actions & actions )
+static void output_module_overview_line( std::string const & module, module_overview_actions & actions )
 {
-    actions.begin();
+    actions.module_start( module );
 
-    for( std::set< std::string >::iterator i = s_modules.begin(); i != s_modules.end(); ++i )
+    std::set< std::string > const mdeps = s_context->module_deps_[ module ];
+
+    for( std::set< std::string >::const_iterator j = mdeps.begin(); j != mdeps.end(); ++j )
     {
-        actions.module_start( *i );
+        actions.module2( *j );
+    }
 
-        std::set< std::string > const mdeps = s_module_deps[ *i ];
+    actions.module_end( module );
+}
 
-        for( std::set< std::string >::const_iterator j = mdeps.begin(); j != mdeps.end(); ++j )
-        {
-            actions.module2( *j );
-        }
+static void output_module_overview_report( module_overview_actions & actions )
+{
+    actions.begin();
 
-        actions.module_end( *i );
+    for( std::set< std::string >::iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        output_module_overview_line( *i, actions );
     }
 
     actions.end();
 }
 
+// outputs the line of each module as soon as it has been scanned
+struct module_overview_listener: public module_scan_listener
+{
+    module_overview_actions & actions_;
+
+    explicit module_overview_listener( module_overview_actions & actions ): actions_( actions )
+    {
+    }
+
+    void module_scanned( std::string const & module )
+    {
+        output_module_overview_line( module, actions_ );
+        std::cout << std::flush;
+    }
+};
+
 struct module_overview_txt_actions: public module_overview_actions
 {
     bool deps_;
@@ -1258,17 +956,19 @@ struct module_overview_html_actions: public module_overview_actions
     }
 };
 
-static void output_module_overview_report( bool html )
+static void output_module_overview_report( module_overview_actions & actions, bool & secondary, bool track_sources, bool track_tests );
+
+static void output_module_overview_report( bool html, bool & secondary, bool track_sources, bool track_tests )
 {
     if( html )
     {
         module_overview_html_actions actions;
-        output_module_overview_report( actions );
+        output_module_overview_report( actions, secondary, track_sources, track_tests );
     }
     else
     {
         module_overview_txt_actions actions;
-        output_module_overview_report( actions );
+        output_module_overview_report( actions, secondary, track_sources, track_tests );
     }
 }
 
@@ -1303,10 +1003,10 @@ struct list_dependencies_actions: public module_overview_actions
     }
 };
 
-static void list_dependencies()
+static void list_dependencies( bool & secondary, bool track_sources, bool track_tests )
 {
     list_dependencies_actions actions;
-    output_module_overview_report( actions );
+    output_module_overview_report( actions, secondary, track_sources, track_tests );
 }
 
 //
@@ -1339,13 +1039,15 @@ static void output_html_footer( std::string const & footer )
     std::cout << "</html>\n";
 }
 
-static void enable_secondary( bool & secondary, bool track_sources, bool track_tests )
+static void enable_secondary( bool & secondary, bool track_sources, bool track_tests, module_scan_listener * listener = 0 )
 {
+    enable_header_map();
+
     if( !secondary )
     {
         try
         {
-            build_module_dependency_map( track_sources, track_tests );
+            build_module_dependency_map( track_sources, track_tests, listener );
         }
         catch( fs::filesystem_error const & x )
         {
@@ -1356,9 +1058,29 @@ static void enable_secondary( bool & secondary, bool track_sources, bool track_t
     }
 }
 
+// when the modules haven't been scanned yet, streams the report while
+// scanning them
+static void output_module_overview_report( module_overview_actions & actions, bool & secondary, bool track_sources, bool track_tests )
+{
+    enable_header_map();
+
+    if( secondary )
+    {
+        output_module_overview_report( actions );
+        return;
+    }
+
+    actions.begin();
+
+    module_overview_listener listener( actions );
+    enable_secondary( secondary, track_sources, track_tests, &listener );
+
+    actions.end();
+}
+
 static void list_modules()
 {
-    for( std::set< std::string >::iterator i = s_modules.begin(); i != s_modules.end(); ++i )
+    for( std::set< std::string >::iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
     {
         std::cout << *i << "\n";
     }
@@ -1366,9 +1088,9 @@ static void list_modules()
 
 static void list_buildable()
 {
-    for( std::set< std::string >::iterator i = s_modules.begin(); i != s_modules.end(); ++i )
+    for( std::set< std::string >::iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
     {
-        if( fs::exists( module_build_path( *i ) ) && fs::exists( module_source_path( *i ) ) )
+        if( root_exists( module_build_path( *i ) ) && root_exists( module_source_path( *i ) ) )
         {
             std::cout << *i << "\n";
         }
@@ -1399,53 +1121,16 @@ struct module_weight_actions
 
 static void output_module_weight_report( module_weight_actions & actions )
 {
-    // gather secondary dependencies
-
-    struct build_secondary_deps: public module_secondary_actions
-    {
-        std::map< std::string, std::set< std::string > > * pm_;
-
-        build_secondary_deps( std::map< std::string, std::set< std::string > > * pm ): pm_( pm )
-        {
-        }
-
-        std::string module_;
-
-        void heading( std::string const & module )
-        {
-            module_ = module;
-        }
-
-        void module_start( std::string const & /*module*/ )
-        {
-        }
-
-        void module_end( std::string const & /*module*/ )
-        {
-        }
-
-        void module_adds( std::string const & module )
-        {
-            (*pm_)[ module_ ].insert( module );
-        }
-    };
-
     std::map< std::string, std::set< std::string > > secondary_deps;
-
-    build_secondary_deps bsd( &secondary_deps );
-
-    for( std::set< std::string >::const_iterator i = s_modules.begin(); i != s_modules.end(); ++i )
-    {
-        output_module_secondary_report( *i, bsd );
-    }
+    compute_secondary_dependencies( s_context->modules_, secondary_deps );
 
     // build weight map
 
     std::map< int, std::set< std::string > > modules_by_weight;
 
-    for( std::set< std::string >::const_iterator i = s_modules.begin(); i != s_modules.end(); ++i )
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
     {
-        int w = s_module_deps[ *i ].size() + secondary_deps[ *i ].size();
+        int w = s_context->module_deps_[ *i ].size() + secondary_deps[ *i ].size();
         modules_by_weight[ w ].insert( *i );
     }
 
@@ -1461,13 +1146,13 @@ static void output_module_weight_report( module_weight_actions & actions )
         {
             actions.module_start( *j );
 
-            if( !s_module_deps[ *j ].empty() )
+            if( !s_context->module_deps_[ *j ].empty() )
             {
                 actions.module_primary_start();
 
-                for( std::set< std::string >::const_iterator k = s_module_deps[ *j ].begin(); k != s_module_deps[ *j ].end(); ++k )
+                for( std::set< std::string >::const_iterator k = s_context->module_deps_[ *j ].begin(); k != s_context->module_deps_[ *j ].end(); ++k )
                 {
-                    int w = s_module_deps[ *k ].size() + secondary_deps[ *k ].size();
+                    int w = s_context->module_deps_[ *k ].size() + secondary_deps[ *k ].size();
                     actions.module_primary( *k, w );
                 }
 
@@ -1480,7 +1165,7 @@ static void output_module_weight_report( module_weight_actions & actions )
 
                 for( std::set< std::string >::const_iterator k = secondary_deps[ *j ].begin(); k != secondary_deps[ *j ].end(); ++k )
                 {
-                    int w = s_module_deps[ *k ].size() + secondary_deps[ *k ].size();
+                    int w = s_context->module_deps_[ *k ].size() + secondary_deps[ *k ].size();
                     actions.module_secondary( *k, w );
                 }
 
@@ -1649,1161 +1334,4945 @@ static void output_module_weight_report( bool html )
     }
 }
 
-// output_module_subset_report
+// header_closure
 
-struct module_subset_actions
+// the header graph in a compact form, with its strongly connected
+// components and the headers reachable from each of them
+struct header_closure
 {
-    virtual void heading( std::string const & module ) = 0;
+    std::vector< std::string > headers_;
+    std::map< std::string, int > index_;
 
-    virtual void module_start( std::string const & module ) = 0;
-    virtual void module_end( std::string const & module ) = 0;
+    // header -> [header, header...] it includes
+    std::vector< std::vector< int > > edges_;
 
-    virtual void from_path( std::vector<std::string> const & path ) = 0;
-};
+    // header -> component; components are numbered in reverse
+    // topological order, so a component only reaches lower ones
+    std::vector< int > component_;
 
-static void add_module_headers( fs::path const & dir, std::set<std::string> & headers )
-{
-    if( fs::exists( dir ) )
+    // component -> headers reachable from it, including its own
+    std::vector< boost::dynamic_bitset<> > closure_;
+
+    int header_index( std::string const & header )
     {
-        fs::recursive_directory_iterator it( dir ), last;
+        std::map< std::string, int >::const_iterator i = index_.find( header );
 
-        for( ; it != last; ++it )
+        if( i != index_.end() )
         {
-            if( it->status().type() == fs::directory_file )
-            {
-                continue;
-            }
-
-            headers.insert( it->path().generic_string() );
+            return i->second;
         }
-    }
-}
 
-static void output_module_subset_report_( std::string const & module, std::set<std::string> const & headers, module_subset_actions & actions )
-{
-    // build header closure
+        int k = headers_.size();
 
-    // header -> (header)*
-    std::map< std::string, std::set<std::string> > inc2;
+        headers_.push_back( header );
+        index_[ header ] = k;
 
-    // (header, header) -> path
-    std::map< std::pair<std::string, std::string>, std::vector<std::string> > paths;
+        return k;
+    }
 
-    for( std::set<std::string>::const_iterator i = headers.begin(); i != headers.end(); ++i )
+    boost::dynamic_bitset<> const & reachable( std::string const & header ) const
     {
-        std::set<std::string> & s = inc2[ *i ];
+        return closure_[ component_[ index_.find( header )->second ] ];
+    }
+};
 
-        s = s_header_includes[ *i ];
+// Tarjan's algorithm, with an explicit stack
+static int find_components( std::vector< std::vector< int > > const & edges, std::vector< int > & component )
+{
+    int const n = edges.size();
 
-        for( std::set<std::string>::const_iterator j = s.begin(); j != s.end(); ++j )
-        {
-            std::vector<std::string> & v = paths[ std::make_pair( *i, *j ) ];
+    std::vector< int > index( n, -1 ), low( n );
+    std::vector< int > stack;
+    std::vector< char > on_stack( n );
 
-            v.resize( 0 );
-            v.push_back( *i );
-            v.push_back( *j );
-        }
-    }
+    // (header, next edge)
+    std::vector< std::pair< int, std::size_t > > calls;
 
-    for( ;; )
+    component.assign( n, -1 );
+
+    int m = 0, c = 0;
+
+    for( int r = 0; r < n; ++r )
     {
-        bool r = false;
+        if( index[ r ] >= 0 ) continue;
 
-        for( std::map< std::string, std::set<std::string> >::iterator i = inc2.begin(); i != inc2.end(); ++i )
+        index[ r ] = low[ r ] = m++;
+        stack.push_back( r );
+        on_stack[ r ] = true;
+
+        calls.push_back( std::make_pair( r, 0 ) );
+
+        while( !calls.empty() )
         {
-            std::set<std::string> & s2 = i->second;
+            int v = calls.back().first;
 
-            for( std::set<std::string>::const_iterator j = s2.begin(); j != s2.end(); ++j )
+            if( calls.back().second < edges[ v ].size() )
             {
-                std::set<std::string> const & s = s_header_includes[ *j ];
+                int w = edges[ v ][ calls.back().second++ ];
 
-                for( std::set<std::string>::const_iterator k = s.begin(); k != s.end(); ++k )
+                if( index[ w ] < 0 )
                 {
-                    if( s2.count( *k ) == 0 )
-                    {
-                        s2.insert( *k );
-
-                        std::vector<std::string> const & v1 = paths[ std::make_pair( i->first, *j ) ];
-                        std::vector<std::string> & v2 = paths[ std::make_pair( i->first, *k ) ];
+                    index[ w ] = low[ w ] = m++;
+                    stack.push_back( w );
+                    on_stack[ w ] = true;
 
-                        v2 = v1;
-                        v2.push_back( *k );
-
-                        r = true;
-                    }
+                    calls.push_back( std::make_pair( w, 0 ) );
+                }
+                else if( on_stack[ w ] )
+                {
+                    low[ v ] = std::min( low[ v ], index[ w ] );
                 }
-            }
-        }
 
-        if( !r ) break;
-    }
+                continue;
+            }
 
-    // module -> header -> path [header -> header -> header]
-    std::map< std::string, std::map< std::string, std::vector<std::string> > > subset;
+            if( low[ v ] == index[ v ] )
+            {
+                int w;
 
-    for( std::set<std::string>::const_iterator i = headers.begin(); i != headers.end(); ++i )
-    {
-        std::set<std::string> const & s = inc2[ *i ];
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
 
-        for( std::set<std::string>::const_iterator j = s.begin(); j != s.end(); ++j )
-        {
-            std::string const & m = s_header_map[ *j ];
+                    on_stack[ w ] = false;
+                    component[ w ] = c;
+                }
+                while( w != v );
 
-            if( m.empty() ) continue;
+                ++c;
+            }
 
-            std::vector<std::string> const & path = paths[ std::make_pair( *i, *j ) ];
+            calls.pop_back();
 
-            if( subset.count( m ) == 0 || subset[ m ].count( *i ) == 0 || subset[ m ][ *i ].size() > path.size() )
+            if( !calls.empty() )
             {
-                subset[ m ][ *i ] = path;
+                int u = calls.back().first;
+                low[ u ] = std::min( low[ u ], low[ v ] );
             }
         }
     }
 
-    actions.heading( module );
+    return c;
+}
 
-    for( std::map< std::string, std::map< std::string, std::vector<std::string> > >::const_iterator i = subset.begin(); i != subset.end(); ++i )
-    {
-        if( i->first == module ) continue;
+static void build_header_closure( header_closure & hc )
+{
+    profile_scope ps( "build_header_closure" );
 
-        actions.module_start( i->first );
+    for( std::map< std::string, std::string >::const_iterator i = s_context->header_map_.begin(); i != s_context->header_map_.end(); ++i )
+    {
+        hc.header_index( i->first );
+    }
 
-        int k = 0;
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = s_context->header_includes_.begin(); i != s_context->header_includes_.end(); ++i )
+    {
+        int k = hc.header_index( i->first );
 
-        for( std::map< std::string, std::vector<std::string> >::const_iterator j = i->second.begin(); j != i->second.end() && k < 4; ++j, ++k )
+        for( std::set< std::string >::const_iterator j = i->second.begin(); j != i->second.end(); ++j )
         {
-            actions.from_path( j->second );
-        }
+            int k2 = hc.header_index( *j );
 
-        actions.module_end( i->first );
+            if( hc.edges_.size() < hc.headers_.size() )
+            {
+                hc.edges_.resize( hc.headers_.size() );
+            }
+
+            hc.edges_[ k ].push_back( k2 );
+        }
     }
-}
 
-static void output_module_subset_report( std::string const & module, bool track_sources, bool track_tests, module_subset_actions & actions )
-{
-    std::set<std::string> headers = s_module_headers[ module ];
+    int const n = hc.headers_.size();
 
-    if( track_sources )
-    {
-        add_module_headers( module_source_path( module ), headers );
-    }
+    hc.edges_.resize( n );
 
-    if( track_tests )
-    {
-        add_module_headers( module_test_path( module ), headers );
-    }
+    int const m = find_components( hc.edges_, hc.component_ );
 
-    output_module_subset_report_( module, headers, actions );
-}
+    // component -> [header, header...]
+    std::vector< std::vector< int > > members( m );
 
-struct module_subset_txt_actions: public module_subset_actions
-{
-    void heading( std::string const & module )
+    for( int i = 0; i < n; ++i )
     {
-        std::cout << "Subset dependencies for " << module << ":\n\n";
+        members[ hc.component_[ i ] ].push_back( i );
     }
 
-    void module_start( std::string const & module )
-    {
-        std::cout << module << ":\n";
-    }
+    hc.closure_.assign( m, boost::dynamic_bitset<>( n ) );
 
-    void module_end( std::string const & /*module*/ )
+    for( int c = 0; c < m; ++c )
     {
-        std::cout << "\n";
-    }
+        boost::dynamic_bitset<> & s = hc.closure_[ c ];
 
-    void from_path( std::vector<std::string> const & path )
-    {
-        for( std::vector<std::string>::const_iterator i = path.begin(); i != path.end(); ++i )
+        for( std::vector< int >::const_iterator i = members[ c ].begin(); i != members[ c ].end(); ++i )
         {
-            if( i == path.begin() )
-            {
-                std::cout << "  ";
-            }
-            else
+            s.set( *i );
+
+            for( std::vector< int >::const_iterator j = hc.edges_[ *i ].begin(); j != hc.edges_[ *i ].end(); ++j )
             {
-                std::cout << " -> ";
-            }
+                int c2 = hc.component_[ *j ];
 
-            std::cout << *i;
+                if( c2 != c )
+                {
+                    s |= hc.closure_[ c2 ];
+                }
+            }
         }
-
-        std::cout << "\n";
     }
-};
+}
 
-struct module_subset_html_actions: public module_subset_actions
+// closure -> total size of the headers in it
+static file_size closure_size( header_closure const & hc, boost::dynamic_bitset<> const & closure )
 {
-    void heading( std::string const & module )
-    {
-        std::cout << "\n\n<h1 id=\"subset-dependencies\">Subset dependencies for <em>" << module << "</em></h1>\n";
-    }
+    file_size r = { 0, 0 };
 
-    void module_start( std::string const & module )
+    for( std::size_t i = closure.find_first(); i != closure.npos; i = closure.find_next( i ) )
     {
-        std::cout << "  <h2 id=\"subset-" << module << "\"><a href=\"" << module << ".html\"><em>" << module << "</em></a></h2><ul>\n";
-    }
+        std::map< std::string, file_size >::const_iterator j = s_context->file_sizes_.find( hc.headers_[ i ] );
 
-    void module_end( std::string const & /*module*/ )
-    {
-        std::cout << "</ul>\n";
+        if( j != s_context->file_sizes_.end() )
+        {
+            r.bytes += j->second.bytes;
+            r.lines += j->second.lines;
+        }
     }
 
-    void from_path( std::vector<std::string> const & path )
-    {
-        std::cout << "    <li>";
+    return r;
+}
 
-        for( std::vector<std::string>::const_iterator i = path.begin(); i != path.end(); ++i )
-        {
-            if( i != path.begin() )
-            {
-                std::cout << " &#8674; ";
-            }
+// --header-cost
 
-            std::cout << "<code>" << *i << "</code>";
-        }
+struct header_cost_actions
+{
+    virtual void begin() = 0;
+    virtual void end() = 0;
 
-        std::cout << "</li>\n";
-    }
+    virtual void section_start( std::string const & title ) = 0;
+    virtual void section_end() = 0;
+
+    virtual void module( std::string const & module, int headers, file_size const & average, std::string const & worst_header, file_size const & worst ) = 0;
 };
 
-static void output_module_subset_report( std::string const & module, bool track_sources, bool track_tests, bool html )
+struct module_header_cost
 {
-    if( html )
-    {
-        module_subset_html_actions actions;
-        output_module_subset_report( module, track_sources, track_tests, actions );
-    }
-    else
-    {
-        module_subset_txt_actions actions;
-        output_module_subset_report( module, track_sources, track_tests, actions );
-    }
+    std::string module;
+    int headers;
+
+    file_size average;
+
+    std::string worst_header;
+    file_size worst;
+};
+
+static bool greater_average_cost( module_header_cost const & m1, module_header_cost const & m2 )
+{
+    return m1.average.bytes > m2.average.bytes || ( m1.average.bytes == m2.average.bytes && m1.module < m2.module );
 }
 
-// --list-exceptions
+static bool greater_worst_cost( module_header_cost const & m1, module_header_cost const & m2 )
+{
+    return m1.worst.bytes > m2.worst.bytes || ( m1.worst.bytes == m2.worst.bytes && m1.module < m2.module );
+}
 
-static void list_exceptions()
+static void output_header_cost_report( header_cost_actions & actions )
 {
-    std::string lm;
+    header_closure hc;
+    build_header_closure( hc );
 
-    for( std::map< std::string, std::set<std::string> >::const_iterator i = s_module_headers.begin(); i != s_module_headers.end(); ++i )
+    std::vector< module_header_cost > costs;
+
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = s_context->module_headers_.begin(); i != s_context->module_headers_.end(); ++i )
     {
-        std::string module = i->first;
+        if( i->second.empty() ) continue;
 
-        std::replace( module.begin(), module.end(), '~', '/' );
+        module_header_cost mc;
 
-        std::string const prefix = "boost/" + module;
-        size_t const n = prefix.size();
+        mc.module = i->first;
+        mc.headers = i->second.size();
+
+        mc.worst.bytes = mc.worst.lines = 0;
+
+        double bytes = 0, lines = 0;
 
         for( std::set< std::string >::const_iterator j = i->second.begin(); j != i->second.end(); ++j )
         {
-            std::string const & header = *j;
+            file_size sz = closure_size( hc, hc.reachable( *j ) );
 
-            if( header.substr( 0, n+1 ) != prefix + '/' && header != prefix + ".hpp" )
-            {
-                if( lm != module )
-                {
-                    std::cout << module << ":\n";
-                    lm = module;
-                }
+            bytes += sz.bytes;
+            lines += sz.lines;
 
-                std::cout << "  " << header << '\n';
+            if( mc.worst_header.empty() || sz.bytes > mc.worst.bytes )
+            {
+                mc.worst_header = *j;
+                mc.worst = sz;
             }
         }
+
+        mc.average.bytes = static_cast< unsigned long >( bytes / mc.headers + 0.5 );
+        mc.average.lines = static_cast< unsigned long >( lines / mc.headers + 0.5 );
+
+        costs.push_back( mc );
     }
-}
 
-// --test
+    actions.begin();
 
-struct module_test_primary_actions: public module_primary_actions
-{
-    std::set< std::string > & m_;
+    actions.section_start( "By average header cost" );
 
-    module_test_primary_actions( std::set< std::string > & m ): m_( m )
+    std::sort( costs.begin(), costs.end(), greater_average_cost );
+
+    for( std::vector< module_header_cost >::const_iterator i = costs.begin(); i != costs.end(); ++i )
     {
+        actions.module( i->module, i->headers, i->average, i->worst_header, i->worst );
     }
 
-    void heading( std::string const & module )
+    actions.section_end();
+
+    actions.section_start( "By worst header cost" );
+
+    std::sort( costs.begin(), costs.end(), greater_worst_cost );
+
+    for( std::vector< module_header_cost >::const_iterator i = costs.begin(); i != costs.end(); ++i )
     {
-        std::cout << "Test dependencies for " << module << ":\n\n";
+        actions.module( i->module, i->headers, i->average, i->worst_header, i->worst );
     }
 
-    void module_start( std::string const & module )
+    actions.section_end();
+
+    actions.end();
+}
+
+struct header_cost_txt_actions: public header_cost_actions
+{
+    void begin()
     {
-        std::cout << module << "\n";
-        m_.insert( module );
+        std::cout << "Header Costs:\n\n";
     }
 
-    void module_end( std::string const & /*module*/ )
+    void end()
     {
     }
 
-    void header_start( std::string const & /*header*/ )
+    void section_start( std::string const & title )
     {
+        std::cout << title << ":\n";
     }
 
-    void header_end( std::string const & /*header*/ )
+    void section_end()
     {
+        std::cout << "\n";
     }
 
-    void from_header( std::string const & /*header*/ )
+    void module( std::string const & module, int headers, file_size const & average, std::string const & worst_header, file_size const & worst )
     {
+        std::cout << "    " << module << " (" << headers << " headers): average " << average.bytes << " bytes, " << average.lines << " lines; worst <" << worst_header << "> " << worst.bytes << " bytes, " << worst.lines << " lines\n";
     }
 };
 
-struct module_test_secondary_actions: public module_secondary_actions
+struct header_cost_html_actions: public header_cost_actions
 {
-    std::set< std::string > & m_;
-    std::string m2_;
-
-    module_test_secondary_actions( std::set< std::string > & m ): m_( m )
+    void begin()
     {
+        std::cout << "<div id='header-costs'><h1>Header Costs</h1>\n";
     }
 
-    void heading( std::string const & /*module*/ )
+    void end()
     {
+        std::cout << "</div>\n";
     }
 
-    void module_start( std::string const & module )
+    void section_start( std::string const & title )
     {
-        m2_ = module;
+        std::cout << "  <h2>" << title << "</h2>\n  <table>\n    <tr><th>Module</th><th>Headers</th><th>Average bytes</th><th>Average lines</th><th>Worst header</th><th>Bytes</th><th>Lines</th></tr>\n";
     }
 
-    void module_end( std::string const & /*module*/ )
+    void section_end()
     {
+        std::cout << "  </table>\n";
     }
 
-    void module_adds( std::string const & module )
+    void module( std::string const & module, int headers, file_size const & average, std::string const & worst_header, file_size const & worst )
     {
-        if( m_.count( module ) == 0 )
-        {
-            std::cout << module << " (from " << m2_ << ")\n";
-            m_.insert( module );
-        }
+        std::cout << "    <tr><td><a href=\"" << module << ".html\"><em>" << module << "</em></a></td><td>" << headers << "</td><td>" << average.bytes << "</td><td>" << average.lines << "</td><td><code>&lt;" << worst_header << "&gt;</code></td><td>" << worst.bytes << "</td><td>" << worst.lines << "</td></tr>\n";
     }
 };
 
-static void output_module_test_report( std::string const & module )
+static void output_header_cost_report( bool html )
 {
-    std::set< std::string > m;
-
-    module_test_primary_actions a1( m );
-    output_module_primary_report( module, a1, true, true );
+    if( html )
+    {
+        header_cost_html_actions actions;
+        output_header_cost_report( actions );
+    }
+    else
+    {
+        header_cost_txt_actions actions;
+        output_header_cost_report( actions );
+    }
+}
 
-    std::cout << "\n";
+// --redundant-includes
 
-    bool secondary = false;
-    enable_secondary( secondary, true, false );
+struct redundant_include_actions
+{
+    virtual void begin() = 0;
+    virtual void end( int redundant, int unguarded ) = 0;
 
-    std::set< std::string > m2( m );
-    m2.insert( module );
+    virtual void module_start( std::string const & module ) = 0;
+    virtual void module_end( std::string const & module ) = 0;
 
-    module_test_secondary_actions a2( m2 );
+    // `header` includes `include` directly, and also through `via`
+    virtual void redundant( std::string const & header, std::string const & include, std::string const & via, bool guarded ) = 0;
 
-    output_module_secondary_report( module, m, a2 );
-}
+    virtual void unguarded_start() = 0;
+    virtual void unguarded_end() = 0;
 
-// --cmake
+    virtual void unguarded( std::string const & header, std::string const & module, file_size const & size ) = 0;
+};
 
-struct collect_primary_dependencies: public module_primary_actions
+static void output_redundant_include_report( redundant_include_actions & actions )
 {
-    std::set< std::string > set_;
+    header_closure hc;
+    build_header_closure( hc );
 
-    void heading( std::string const & )
+    std::set< std::string > const & unguarded = s_context->unguarded_files_;
+
+    int redundant = 0;
+
+    actions.begin();
+
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = s_context->module_headers_.begin(); i != s_context->module_headers_.end(); ++i )
     {
+        bool started = false;
+
+        for( std::set< std::string >::const_iterator j = i->second.begin(); j != i->second.end(); ++j )
+        {
+            std::map< std::string, std::set< std::string > >::const_iterator k = s_context->header_includes_.find( *j );
+
+            if( k == s_context->header_includes_.end() ) continue;
+
+            std::set< std::string > const & includes = k->second;
+
+            int const c = hc.component_[ hc.index_[ *j ] ];
+
+            for( std::set< std::string >::const_iterator m = includes.begin(); m != includes.end(); ++m )
+            {
+                int const d = hc.index_[ *m ];
+
+                for( std::set< std::string >::const_iterator m2 = includes.begin(); m2 != includes.end(); ++m2 )
+                {
+                    int const d2 = hc.index_[ *m2 ];
+
+                    // headers in a cycle reach each other, and only
+                    // one of them can go
+                    if( hc.component_[ d2 ] == hc.component_[ d ] ) continue;
+
+                    // a header in a cycle with the includer reaches
+                    // everything the includer does, through it
+                    if( hc.component_[ d2 ] == c ) continue;
+
+                    if( hc.closure_[ hc.component_[ d2 ] ].test( d ) )
+                    {
+                        if( !started )
+                        {
+                            actions.module_start( i->first );
+                            started = true;
+                        }
+
+                        actions.redundant( *j, *m, *m2, unguarded.count( *m ) == 0 );
+                        ++redundant;
+
+                        break;
+                    }
+                }
+            }
+        }
+
+        if( started )
+        {
+            actions.module_end( i->first );
+        }
     }
 
-    void module_start( std::string const & module )
+    actions.unguarded_start();
+
+    int n = 0;
+
+    for( std::set< std::string >::const_iterator i = unguarded.begin(); i != unguarded.end(); ++i )
     {
-        if( module == "(unknown)" ) return;
+        std::map< std::string, std::string >::const_iterator j = s_context->header_map_.find( *i );
 
-        set_.insert( module );
+        if( j == s_context->header_map_.end() ) continue;
+
+        actions.unguarded( *i, j->second, s_context->file_sizes_[ *i ] );
+        ++n;
     }
 
-    void module_end( std::string const & /*module*/ )
+    actions.unguarded_end();
+
+    actions.end( redundant, n );
+}
+
+struct redundant_include_txt_actions: public redundant_include_actions
+{
+    void begin()
     {
+        std::cout << "Redundant Includes:\n\n";
     }
 
-    void header_start( std::string const & /*header*/ )
+    void end( int redundant, int unguarded )
     {
+        std::cout << redundant << " redundant #includes, " << unguarded << " headers without include guards\n";
     }
 
-    void header_end( std::string const & /*header*/ )
+    void module_start( std::string const & module )
     {
+        std::cout << module << ":\n";
     }
 
-    void from_header( std::string const & /*header*/ )
+    void module_end( std::string const & /*module*/ )
     {
+        std::cout << "\n";
     }
-};
 
-static std::string module_cmake_name( std::string module )
-{
-    std::replace( module.begin(), module.end(), '~', '_' );
-    return module;
-}
+    void redundant( std::string const & header, std::string const & include, std::string const & via, bool guarded )
+    {
+        std::cout << "    <" << header << "> includes <" << include << ">, already included by <" << via << ">";
 
-static void output_module_cmake_report( std::string module )
-{
-    std::cout << "# Generated by `boostdep --cmake " << module << "`\n\n";
-
-    std::replace( module.begin(), module.end(), '/', '~' );
-
-    collect_primary_dependencies a1;
-    output_module_primary_report( module, a1, false, false );
-
-    if( !fs::exists( module_source_path( module ) ) )
-    {
-        for( std::set< std::string >::const_iterator i = a1.set_.begin(); i != a1.set_.end(); ++i )
+        if( !guarded )
         {
-            std::cout << "boost_declare_dependency(INTERFACE " << module_cmake_name( *i ) << ")\n";
+            std::cout << " (unguarded)";
         }
+
+        std::cout << "\n";
     }
-    else
-    {
-        collect_primary_dependencies a2;
-        output_module_primary_report( module, a2, true, false );
 
-        for( std::set< std::string >::const_iterator i = a1.set_.begin(); i != a1.set_.end(); ++i )
-        {
-            a2.set_.erase( *i );
-            std::cout << "boost_declare_dependency(PUBLIC " << module_cmake_name( *i ) << ")\n";
-        }
+    void unguarded_start()
+    {
+        std::cout << "Headers without include guards or #pragma once:\n";
+    }
 
+    void unguarded_end()
+    {
         std::cout << "\n";
-
-        for( std::set< std::string >::const_iterator i = a2.set_.begin(); i != a2.set_.end(); ++i )
-        {
-            std::cout << "boost_declare_dependency(PRIVATE " << module_cmake_name( *i ) << ")\n";
-        }
     }
-}
 
-// --list-missing-headers
+    void unguarded( std::string const & header, std::string const & module, file_size const & size )
+    {
+        std::cout << "    <" << header << "> (" << module << "): " << size.bytes << " bytes, " << size.lines << " lines\n";
+    }
+};
 
-struct missing_header_actions: public module_primary_actions
+struct redundant_include_html_actions: public redundant_include_actions
 {
-    std::string module_, module2_;
+    void begin()
+    {
+        std::cout << "<div id='redundant-includes'><h1>Redundant Includes</h1>\n";
+    }
 
-    void heading( std::string const & module )
+    void end( int redundant, int unguarded )
     {
-        module_ = module;
+        std::cout << "  <p>" << redundant << " redundant #includes, " << unguarded << " headers without include guards</p>\n</div>\n";
     }
 
     void module_start( std::string const & module )
     {
-        module2_ = module;
+        std::cout << "  <h2><a href=\"" << module << ".html\"><em>" << module << "</em></a></h2>\n  <table>\n    <tr><th>Header</th><th>Includes</th><th>Already included by</th><th>Guarded</th></tr>\n";
     }
 
     void module_end( std::string const & /*module*/ )
     {
+        std::cout << "  </table>\n";
     }
 
-    void header_start( std::string const & header )
+    void redundant( std::string const & header, std::string const & include, std::string const & via, bool guarded )
     {
-        if( module2_ == "(unknown)" )
-        {
-            if( !module_.empty() )
-            {
-                std::cout << module_ << ":\n";
-                module_.clear();
-            }
+        std::cout << "    <tr><td><code>&lt;" << header << "&gt;</code></td><td><code>&lt;" << include << "&gt;</code></td><td><code>&lt;" << via << "&gt;</code></td><td>" << ( guarded? "yes": "no" ) << "</td></tr>\n";
+    }
 
-            std::cout << "    <" << header << ">\n";
-        }
+    void unguarded_start()
+    {
+        std::cout << "  <h2>Headers without include guards or #pragma once</h2>\n  <table>\n    <tr><th>Header</th><th>Module</th><th>Bytes</th><th>Lines</th></tr>\n";
     }
 
-    void header_end( std::string const & /*header*/ )
+    void unguarded_end()
     {
+        std::cout << "  </table>\n";
     }
 
-    void from_header( std::string const & header )
+    void unguarded( std::string const & header, std::string const & module, file_size const & size )
     {
-        if( module2_ == "(unknown)" )
-        {
-            std::cout << "        from <" << header << ">\n";
-        }
+        std::cout << "    <tr><td><code>&lt;" << header << "&gt;</code></td><td><a href=\"" << module << ".html\"><em>" << module << "</em></a></td><td>" << size.bytes << "</td><td>" << size.lines << "</td></tr>\n";
     }
 };
 
-static void list_missing_headers( std::string const & module )
-{
-    missing_header_actions a;
-    output_module_primary_report( module, a, false, false );
-}
-
-static void list_missing_headers()
+static void output_redundant_include_report( bool html )
 {
-    for( std::set< std::string >::const_iterator i = s_modules.begin(); i != s_modules.end(); ++i )
+    if( html )
     {
-        list_missing_headers( *i );
+        redundant_include_html_actions actions;
+        output_redundant_include_report( actions );
+    }
+    else
+    {
+        redundant_include_txt_actions actions;
+        output_redundant_include_report( actions );
     }
 }
 
-// --pkgconfig
+// --profile-headers
 
-struct primary_pkgconfig_actions: public module_primary_actions
+struct header_profile
 {
-    std::string version_;
-    std::string list_;
+    std::string header;
 
-    void heading( std::string const & )
-    {
-    }
+    bool ok;
 
-    void module_start( std::string const & module )
-    {
-        if( module == "(unknown)" ) return;
+    // milliseconds, kilobytes
+    double time;
+    long rss;
 
-        std::string m2( module );
-        std::replace( m2.begin(), m2.end(), '~', '_' );
+    // module headers actually included by the compiler
+    int headers;
+    unsigned long bytes;
 
-        if( !list_.empty() )
-        {
-            list_ += ", ";
-        }
+    // module headers included according to the header graph
+    int static_headers;
+    unsigned long static_bytes;
 
-        list_ += "boost_" + m2 + " = " + version_;
-    }
+    std::string flag;
+};
 
-    void module_end( std::string const & )
-    {
-    }
+struct profile_headers_actions
+{
+    virtual void begin( std::string const & compiler ) = 0;
+    virtual void end() = 0;
 
-    void header_start( std::string const & )
+    virtual void header( header_profile const & hp ) = 0;
+};
+
+static std::vector< std::string > split_command_line( char const * s )
+{
+    std::vector< std::string > r;
+
+    std::istringstream is( s? s: "" );
+
+    std::string w;
+
+    while( is >> w )
     {
+        r.push_back( w );
     }
 
-    void header_end( std::string const & )
+    return r;
+}
+
+// maps a path printed by the compiler back to a header name
+static std::string included_header_name( std::string const & path, std::string const & root )
+{
+    std::string::size_type k = path.find( "/include/boost/" );
+
+    if( k != std::string::npos )
     {
+        return path.substr( k + 9 );
     }
 
-    void from_header( std::string const & )
+    if( path.compare( 0, root.size() + 7, root + "/boost/" ) == 0 )
     {
+        return path.substr( root.size() + 1 );
     }
-};
 
-static void output_requires( std::string const & section, std::string const & version, std::set< std::string > const & s )
+    return std::string();
+}
+
+// reads the include tree printed by -H
+static void read_include_tree( fs::path const & p, std::string const & root, header_profile & hp )
 {
-    bool first = true;
+    std::set< std::string > headers;
 
-    for( std::set< std::string >::const_iterator i = s.begin(); i != s.end(); ++i )
+    fs::ifstream is( p );
+    std::string line;
+
+    while( std::getline( is, line ) )
     {
-        if( first )
-        {
-            std::cout << section << ": ";
-            first = false;
-        }
-        else
+        std::string::size_type k = line.find_first_not_of( '.' );
+
+        if( k == 0 || k == std::string::npos || line[ k ] != ' ' ) continue;
+
+        std::string header = included_header_name( line.substr( k + 1 ), root );
+
+        if( s_context->header_map_.count( header ) )
         {
-            std::cout << ", ";
+            headers.insert( header );
         }
+    }
 
-        std::string m2( *i );
-        std::replace( m2.begin(), m2.end(), '~', '_' );
+    hp.headers = headers.size();
+    hp.bytes = 0;
 
-        std::cout << "boost_" << m2 << " = " << version;
+    for( std::set< std::string >::const_iterator i = headers.begin(); i != headers.end(); ++i )
+    {
+        hp.bytes += s_context->file_sizes_[ *i ].bytes;
     }
 }
 
-static void output_pkgconfig( std::string const & module, std::string const & version, int argc, char const* argv[] )
+#if defined(__unix__) || defined(__APPLE__)
+
+struct profile_job
 {
-    for( int i = 0; i < argc; ++i )
-    {
-        std::cout << argv[ i ] << '\n';
-    }
+    std::size_t index_;
+    double start_;
 
-    std::cout << '\n';
+    fs::path source_;
+    fs::path output_;
+    fs::path rss_;
+};
 
-    std::string m2( module );
-    std::replace( m2.begin(), m2.end(), '/', '_' );
+#if defined(__linux__)
 
-    std::string m3( module );
-    std::replace( m3.begin(), m3.end(), '/', '~' );
+// Linux carries the peak memory of a process over fork and exec, so the
+// ru_maxrss of a compiler forked from boostdep is at least that of
+// boostdep. Instead, the child execs boostdep anew as a small process,
+// which runs the compiler and writes down its peak memory:
+//
+//     boostdep --exec-maxrss <file> <command>...
 
-    std::cout << "Name: boost_" << module << '\n';
-    std::cout << "Description: Boost C++ library '" << module << "'\n";
-    std::cout << "Version: " << version << '\n';
-    std::cout << "URL: http://www.boost.org/libs/" << module << '\n';
-    std::cout << "Cflags: -I${includedir}\n";
+static int exec_maxrss( char const * file, char * argv[] )
+{
+    pid_t pid = fork();
 
-    if( fs::exists( module_build_path( module ) ) && fs::exists( module_source_path( module ) ) )
+    if( pid == 0 )
     {
-        std::cout << "Libs: -L${libdir} -lboost_" << m2 << "\n";
+        execvp( argv[ 0 ], argv );
+        _exit( 127 );
     }
 
-    collect_primary_dependencies a1;
-    output_module_primary_report( m3, a1, false, false );
-
-    if( !a1.set_.empty() )
+    if( pid < 0 )
     {
-        output_requires( "Requires", version, a1.set_ );
-        std::cout << std::endl;
+        return 127;
     }
 
-    collect_primary_dependencies a2;
-    output_module_primary_report( m3, a2, true, false );
+    int status = 0;
+    rusage ru;
 
-    for( std::set< std::string >::const_iterator i = a1.set_.begin(); i != a1.set_.end(); ++i )
+    if( wait4( pid, &status, 0, &ru ) < 0 )
     {
-        a2.set_.erase( *i );
+        return 127;
     }
 
-    if( !a2.set_.empty() )
     {
-        output_requires( "Requires.private", version, a2.set_ );
-        std::cout << std::endl;
+        std::ofstream os( file );
+        os << ru.ru_maxrss << std::endl;
     }
+
+    return WIFEXITED( status )? WEXITSTATUS( status ): 127;
 }
 
-// --subset-for
+#endif
 
-static void output_directory_subset_report( std::string const & module, std::set<std::string> const & headers, bool html )
+// compiles a one-line translation unit for each header, keeping up to
+// 'jobs' compiler processes running at once
+static void run_profile_jobs( std::vector< header_profile > & profiles, std::vector< std::string > const & command, fs::path const & dir, std::string const & root, int jobs )
 {
-    for( std::set<std::string>::const_iterator i = headers.begin(); i != headers.end(); ++i )
-    {
-        std::map< std::string, std::set< std::string > > deps;
-        std::map< std::string, std::set< std::string > > from;
+    std::map< pid_t, profile_job > running;
 
-        std::ifstream is( i->c_str() );
-        scan_header_dependencies( *i, is, deps, from );
+    std::size_t next = 0;
 
-        for( std::map< std::string, std::set< std::string > >::const_iterator j = from.begin(); j != from.end(); ++j )
+    while( next < profiles.size() || !running.empty() )
+    {
+        while( next < profiles.size() && static_cast< int >( running.size() ) < jobs )
         {
-            for( std::set<std::string>::const_iterator k = j->second.begin(); k != j->second.end(); ++k )
+            std::ostringstream os;
+            os << next;
+
+            profile_job job;
+
+            job.index_ = next++;
+            job.source_ = dir / ( "tu" + os.str() + ".cpp" );
+            job.output_ = dir / ( "tu" + os.str() + ".txt" );
+            job.rss_ = dir / ( "tu" + os.str() + ".rss" );
+
             {
-                s_header_includes[ *k ].insert( j->first );
+                fs::ofstream tu( job.source_ );
+                tu << "#include <" << profiles[ job.index_ ].header << ">\n";
             }
-        }
-    }
 
-    if( html )
-    {
-        module_subset_html_actions actions;
-        output_module_subset_report_( module, headers, actions );
-    }
-    else
-    {
-        module_subset_txt_actions actions;
-        output_module_subset_report_( module, headers, actions );
-    }
-}
+            std::vector< std::string > args;
 
-// list_buildable_dependencies
+#if defined(__linux__)
 
-struct list_buildable_dependencies_actions: public module_overview_actions
-{
-    std::set< std::string > buildable_;
+            args.push_back( "/proc/self/exe" );
+            args.push_back( "--exec-maxrss" );
+            args.push_back( job.rss_.string() );
 
-    std::set< std::string > deps_;
-    bool headers_;
+#endif
 
-    list_buildable_dependencies_actions(): headers_()
-    {
-    }
+            args.insert( args.end(), command.begin(), command.end() );
+            args.push_back( job.source_.string() );
 
-    void begin()
-    {
-        std::cout << "# Generated by `boostdep --list-buildable-dependencies`\n\n";
-    }
+            std::vector< char* > argv;
 
-    void end()
-    {
-    }
+            for( std::size_t i = 0; i < args.size(); ++i )
+            {
+                argv.push_back( &args[ i ][ 0 ] );
+            }
 
-    void module_start( std::string const & module )
-    {
-        deps_.clear();
-        headers_ = false;
+            argv.push_back( 0 );
 
-        if( buildable_.count( module ) )
-        {
-            std::cout << module << " =";
-        }
-    }
+            std::string const output = job.output_.string();
 
-    void module_end( std::string const & module )
-    {
-        if( buildable_.count( module ) )
-        {
-            if( headers_ )
+            job.start_ = wall_time_ms();
+
+            pid_t pid = fork();
+
+            if( pid == 0 )
             {
-                std::cout << " headers";
+                int fd = open( output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+                int fd2 = open( "/dev/null", O_WRONLY );
+
+                dup2( fd, 2 );
+                dup2( fd2, 1 );
+
+                execvp( argv[ 0 ], &argv[ 0 ] );
+                _exit( 127 );
             }
 
-            for( std::set< std::string >::iterator i = deps_.begin(); i != deps_.end(); ++i )
+            if( pid < 0 )
             {
-                std::cout << " " << *i;
+                std::cerr << "boostdep: could not start '" << command[ 0 ] << "'.\n";
+                profiles[ job.index_ ].ok = false;
+                continue;
             }
 
-            std::cout << " ;\n";
+            running[ pid ] = job;
         }
-    }
 
-    void module2( std::string const & module )
-    {
-        if( module == "(unknown)" ) return;
+        int status = 0;
+        rusage ru;
 
-        if( buildable_.count( module ) == 0 )
-        {
-            headers_ = true;
-        }
-        else
+        pid_t pid = wait4( -1, &status, 0, &ru );
+
+        if( pid < 0 )
         {
-            deps_.insert( module );
+            break;
         }
-    }
-};
 
-static void list_buildable_dependencies()
-{
-    list_buildable_dependencies_actions actions;
+        std::map< pid_t, profile_job >::iterator i = running.find( pid );
+
+        if( i == running.end() ) continue;
+
+        profile_job const & job = i->second;
+        header_profile & hp = profiles[ job.index_ ];
+
+        hp.time = wall_time_ms() - job.start_;
+
+#if defined(__linux__)
 
-    for( std::set< std::string >::iterator i = s_modules.begin(); i != s_modules.end(); ++i )
-    {
-        if( fs::exists( module_build_path( *i ) ) && fs::exists( module_source_path( *i ) ) )
         {
-            actions.buildable_.insert( *i );
+            hp.rss = 0;
+
+            fs::ifstream is( job.rss_ );
+            is >> hp.rss;
         }
-    }
 
-    output_module_overview_report( actions );
-}
+        fs::remove( job.rss_ );
 
-//
+#elif defined(__APPLE__)
 
-static bool find_boost_root()
-{
-    for( int i = 0; i < 32; ++i )
-    {
-        if( fs::exists( "Jamroot" ) )
-        {
-            return true;
-        }
+        hp.rss = ru.ru_maxrss / 1024;
 
-        fs::path p = fs::current_path();
+#else
 
-        if( p == p.root_path() )
-        {
-            return false;
-        }
+        hp.rss = ru.ru_maxrss;
+
+#endif
 
-        fs::current_path( p.parent_path() );
+        hp.ok = WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+
+        read_include_tree( job.output_, root, hp );
+
+        fs::remove( job.source_ );
+        fs::remove( job.output_ );
+
+        running.erase( i );
     }
+}
 
-    return false;
+#else
+
+static void run_profile_jobs( std::vector< header_profile > & profiles, std::vector< std::string > const & /*command*/, fs::path const & /*dir*/, std::string const & /*root*/, int /*jobs*/ )
+{
+    std::cerr << "'--profile-headers': not supported on this platform.\n";
+
+    for( std::size_t i = 0; i < profiles.size(); ++i )
+    {
+        profiles[ i ].ok = false;
+    }
 }
 
-static bool is_boost_root( fs::path const & p )
+#endif
+
+static int default_job_count()
 {
-    return fs::exists( p / "Jamroot" );
+#if defined(_SC_NPROCESSORS_ONLN)
+
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+    return n > 0? n: 1;
+
+#else
+
+    return 1;
+
+#endif
 }
 
-// teebuf
+static bool greater_profile_time( header_profile const & p1, header_profile const & p2 )
+{
+    return p1.time > p2.time;
+}
 
-class teebuf: public std::streambuf
+static void output_profile_headers_report( std::set< std::string > const & headers, int jobs, profile_headers_actions & actions )
 {
-private:
+    std::string const root = fs::absolute( s_context->root_ ).generic_string();
 
-    std::streambuf * sb1_;
-    std::streambuf * sb2_;
+    // compiler command line
 
-public:
+    char const * cxx = std::getenv( "CXX" );
+
+    std::vector< std::string > command = split_command_line( cxx? cxx: "c++" );
+
+    command.push_back( "-fsyntax-only" );
+    command.push_back( "-H" );
 
-    teebuf( std::streambuf * sb1, std::streambuf * sb2 ): sb1_( sb1 ), sb2_( sb2 )
     {
+        std::vector< std::string > flags = split_command_line( std::getenv( "CXXFLAGS" ) );
+        command.insert( command.end(), flags.begin(), flags.end() );
     }
 
-private:
+    if( fs::exists( root_path( "boost" ) ) )
+    {
+        command.push_back( "-I" + root );
+    }
+    else
+    {
+        for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+        {
+            command.push_back( "-I" + root + "/" + module_include_path( *i ).generic_string() );
+        }
+    }
 
-    virtual int overflow( int c )
+    // static estimates
+
+    header_closure hc;
+    build_header_closure( hc );
+
+    std::vector< header_profile > profiles;
+
+    for( std::set< std::string >::const_iterator i = headers.begin(); i != headers.end(); ++i )
     {
-        int r1 = sb1_->sputc( c );
-        int r2 = sb2_->sputc( c );
+        header_profile hp;
 
-        return r1 == EOF || r2 == EOF? EOF : c;
+        hp.header = *i;
+        hp.ok = false;
+        hp.time = 0;
+        hp.rss = 0;
+        hp.headers = 0;
+        hp.bytes = 0;
+
+        boost::dynamic_bitset<> const & r = hc.reachable( *i );
+
+        hp.static_headers = 0;
+
+        for( std::size_t j = r.find_first(); j != r.npos; j = r.find_next( j ) )
+        {
+            hp.static_headers += s_context->header_map_.count( hc.headers_[ j ] );
+        }
+
+        hp.static_bytes = closure_size( hc, r ).bytes;
+
+        profiles.push_back( hp );
     }
 
-    virtual int sync()
+    // measure
+
+    fs::path dir = fs::temp_directory_path() / fs::unique_path( "boostdep-%%%%-%%%%" );
+    fs::create_directories( dir );
+
+    run_profile_jobs( profiles, command, dir, root, jobs > 0? jobs: default_job_count() );
+
+    fs::remove_all( dir );
+
+    // flag the headers whose compile time per statically estimated byte,
+    // or whose actual include set, differs considerably from the rest
+
+    std::vector< double > rates;
+
+    for( std::vector< header_profile >::const_iterator i = profiles.begin(); i != profiles.end(); ++i )
     {
-        int r1 = sb1_->pubsync();
-        int r2 = sb2_->pubsync();
+        if( i->ok )
+        {
+            rates.push_back( i->time / ( i->static_bytes + 1 ) );
+        }
+    }
 
-        return r1 == 0 && r2 == 0? 0 : -1;
+    double median = 0;
+
+    if( !rates.empty() )
+    {
+        std::nth_element( rates.begin(), rates.begin() + rates.size() / 2, rates.end() );
+        median = rates[ rates.size() / 2 ];
     }
-};
 
-// save_cout_rdbuf
+    for( std::vector< header_profile >::iterator i = profiles.begin(); i != profiles.end(); ++i )
+    {
+        if( !i->ok )
+        {
+            i->flag = "does not compile";
+        }
+        else if( i->bytes * 2 < i->static_bytes )
+        {
+            i->flag = "includes much less than the graph says";
+        }
+        else if( i->bytes > 2 * i->static_bytes )
+        {
+            i->flag = "includes much more than the graph says";
+        }
+        else if( i->time / ( i->static_bytes + 1 ) > 3 * median )
+        {
+            i->flag = "slow for its size";
+        }
+        else if( i->time / ( i->static_bytes + 1 ) * 3 < median )
+        {
+            i->flag = "fast for its size";
+        }
+    }
 
-class save_cout_rdbuf
-{
-private:
+    std::sort( profiles.begin(), profiles.end(), greater_profile_time );
 
-    std::streambuf * sb_;
+    // output report
 
-public:
+    std::string compiler;
 
-    save_cout_rdbuf(): sb_( std::cout.rdbuf() )
+    for( std::vector< std::string >::const_iterator i = command.begin(); i != command.end() && i->compare( 0, 2, "-I" ) != 0; ++i )
     {
+        if( !compiler.empty() )
+        {
+            compiler += ' ';
+        }
+
+        compiler += *i;
     }
 
-    ~save_cout_rdbuf()
+    actions.begin( compiler );
+
+    for( std::vector< header_profile >::const_iterator i = profiles.begin(); i != profiles.end(); ++i )
     {
-        std::cout.rdbuf( sb_ );
+        actions.header( *i );
     }
-};
 
-// main
+    actions.end();
+}
 
-int main( int argc, char const* argv[] )
+struct profile_headers_txt_actions: public profile_headers_actions
 {
-    if( argc < 2 )
+    void begin( std::string const & compiler )
     {
-        std::cout <<
-
-            "Usage:\n"
-            "\n"
-            "    boostdep --list-modules\n"
-            "    boostdep --list-buildable\n"
-            "    boostdep [--track-sources] [--track-tests] --list-dependencies\n"
-            "    boostdep --list-exceptions\n"
-            "    boostdep --list-missing-headers\n"
-            "    boostdep --list-buildable-dependencies\n"
-            "\n"
-            "    boostdep [options] --module-overview\n"
-            "    boostdep [options] --module-levels\n"
-            "    boostdep [options] --module-weights\n"
-            "\n"
-            "    boostdep [options] [--primary] <module>\n"
-            "    boostdep [options] --secondary <module>\n"
-            "    boostdep [options] --reverse <module>\n"
-            "    boostdep [options] --subset <module>\n"
-            "    boostdep [options] [--header] <header>\n"
-            "    boostdep --test <module>\n"
-            "    boostdep --cmake <module>\n"
-            "    boostdep --pkgconfig <module> <version> [<var>=<value>] [<var>=<value>]...\n"
-            "    boostdep [options] --subset-for <directory>\n"
-            "\n"
-            "    [options]: [--boost-root <path-to-boost>]\n"
-            "               [--[no-]track-sources] [--[no-]track-tests]\n"
-            "               [--html-title <title>] [--html-footer <footer>]\n"
-            "               [--html-stylesheet <stylesheet>] [--html-prefix <prefix>]\n"
-            "               [--html]\n";
-
-        return -1;
+        std::cout << "Header Profile (" << compiler << "):\n\n";
     }
 
-    bool root_set = false;
+    void end()
+    {
+        std::cout << "\n";
+    }
 
-    for( int i = 0; i < argc; ++i )
+    void header( header_profile const & hp )
     {
-        std::string option = argv[ i ];
+        std::cout << "    <" << hp.header << ">: " << static_cast< long >( hp.time ) << " ms, " << hp.rss << " KB; " << hp.headers << " headers, " << hp.bytes << " bytes (graph: " << hp.static_headers << " headers, " << hp.static_bytes << " bytes)";
 
-        if( option == "--boost-root" )
+        if( !hp.flag.empty() )
         {
-            if( i + 1 < argc )
-            {
-                fs::path p( argv[ ++i ] );
-
-                if( is_boost_root( p ) )
-                {
-                    fs::current_path( p );
-                    root_set = true;
-                }
-                else
-                {
-                    std::cerr << "'" << p.string() << "': not a valid Boost root.\n";
-                    return -2;
-                }
-            }
-            else
-            {
-                std::cerr << "'" << option << "': missing argument.\n";
-                return -2;
-            }
+            std::cout << " <- " << hp.flag;
         }
+
+        std::cout << "\n";
     }
+};
 
-    if( !root_set && !find_boost_root() )
+struct profile_headers_html_actions: public profile_headers_actions
+{
+    void begin( std::string const & compiler )
     {
-        char const * env_root = std::getenv( "BOOST_ROOT" );
+        std::cout << "<div id='header-profile'><h1>Header Profile (<code>" << compiler << "</code>)</h1>\n  <table>\n    <tr><th>Header</th><th>ms</th><th>KB</th><th>Headers</th><th>Bytes</th><th>Graph headers</th><th>Graph bytes</th><th></th></tr>\n";
+    }
 
-        if( env_root && is_boost_root( env_root ) )
+    void end()
+    {
+        std::cout << "  </table>\n</div>\n";
+    }
+
+    void header( header_profile const & hp )
+    {
+        std::cout << "    <tr><td><code>&lt;" << hp.header << "&gt;</code></td><td>" << static_cast< long >( hp.time ) << "</td><td>" << hp.rss << "</td><td>" << hp.headers << "</td><td>" << hp.bytes << "</td><td>" << hp.static_headers << "</td><td>" << hp.static_bytes << "</td><td>";
+
+        if( !hp.flag.empty() )
         {
-            fs::current_path( env_root );
+            std::cout << "<strong>" << hp.flag << "</strong>";
         }
-        else
+
+        std::cout << "</td></tr>\n";
+    }
+};
+
+static void output_profile_headers_report( std::string const & what, int jobs, bool html )
+{
+    std::set< std::string > headers;
+
+    if( what == "all" )
+    {
+        for( std::map< std::string, std::set< std::string > >::const_iterator i = s_context->module_headers_.begin(); i != s_context->module_headers_.end(); ++i )
         {
-            std::cerr << "boostdep: Could not find Boost root.\n";
-            return -2;
+            headers.insert( i->second.begin(), i->second.end() );
         }
     }
+    else if( s_context->modules_.count( what ) )
+    {
+        headers = s_context->module_headers_[ what ];
+    }
+    else if( s_context->header_map_.count( what ) )
+    {
+        headers.insert( what );
+    }
+    else
+    {
+        std::cerr << "'" << what << "': not a module or header.\n";
+        return;
+    }
 
     try
     {
-        build_header_map();
+        if( html )
+        {
+            profile_headers_html_actions actions;
+            output_profile_headers_report( headers, jobs, actions );
+        }
+        else
+        {
+            profile_headers_txt_actions actions;
+            output_profile_headers_report( headers, jobs, actions );
+        }
     }
     catch( fs::filesystem_error const & x )
     {
         std::cerr << x.what() << std::endl;
     }
+}
 
-    bool html = false;
-    bool secondary = false;
-    bool track_sources = false;
-    bool track_tests = false;
+// output_module_subset_report
 
-    std::string html_title = "Boost Dependency Report";
-    std::string html_footer;
-    std::string html_stylesheet;
-    std::string html_prefix;
+static void output_module_subset_report( std::string const & module, bool track_sources, bool track_tests, module_subset_actions & actions )
+{
+    enable_module_headers( module );
 
-    std::ostringstream captured_output;
-    teebuf tsb( std::cout.rdbuf(), captured_output.rdbuf() );
+    std::set<std::string> headers = s_context->module_headers_[ module ];
 
-    save_cout_rdbuf scrdb;
+    if( track_sources )
+    {
+        add_module_headers( module_source_path( module ), headers );
+    }
 
-    for( int i = 1; i < argc; ++i )
+    if( track_tests )
     {
-        std::string option = argv[ i ];
+        add_module_headers( module_test_path( module ), headers );
+    }
 
-        if( option == "--boost-root" )
-        {
-            ++i;
-        }
-        else if( option == "--list-modules" )
-        {
-            list_modules();
-        }
-        else if( option == "--list-buildable" )
-        {
-            list_buildable();
-        }
-        else if( option == "--title" || option == "--html-title" )
+    if( !s_context->complete_ )
+    {
+        scan_reachable_files( headers );
+    }
+
+    output_module_subset_report_( module, headers, s_context->header_includes_, actions );
+}
+
+struct module_subset_txt_actions: public module_subset_actions
+{
+    void heading( std::string const & module )
+    {
+        std::cout << "Subset dependencies for " << module << ":\n\n";
+    }
+
+    void module_start( std::string const & module )
+    {
+        std::cout << module << ":\n";
+    }
+
+    void module_end( std::string const & /*module*/ )
+    {
+        std::cout << "\n";
+    }
+
+    void from_path( std::vector<std::string> const & path )
+    {
+        for( std::vector<std::string>::const_iterator i = path.begin(); i != path.end(); ++i )
         {
-            if( i + 1 < argc )
+            if( i == path.begin() )
             {
-                html_title = argv[ ++i ];
+                std::cout << "  ";
             }
-        }
-        else if( option == "--footer" || option == "--html-footer" )
-        {
-            if( i + 1 < argc )
+            else
             {
-                html_footer = argv[ ++i ];
+                std::cout << " -> ";
+            }
+
+            std::cout << *i;
+        }
+
+        std::cout << "\n";
+    }
+};
+
+struct module_subset_html_actions: public module_subset_actions
+{
+    void heading( std::string const & module )
+    {
+        std::cout << "\n\n<h1 id=\"subset-dependencies\">Subset dependencies for <em>" << module << "</em></h1>\n";
+    }
+
+    void module_start( std::string const & module )
+    {
+        std::cout << "  <h2 id=\"subset-" << module << "\"><a href=\"" << module << ".html\"><em>" << module << "</em></a></h2><ul>\n";
+    }
+
+    void module_end( std::string const & /*module*/ )
+    {
+        std::cout << "</ul>\n";
+    }
+
+    void from_path( std::vector<std::string> const & path )
+    {
+        std::cout << "    <li>";
+
+        for( std::vector<std::string>::const_iterator i = path.begin(); i != path.end(); ++i )
+        {
+            if( i != path.begin() )
+            {
+                std::cout << " &#8674; ";
+            }
+
+            std::cout << "<code>" << *i << "</code>";
+        }
+
+        std::cout << "</li>\n";
+    }
+};
+
+static void output_module_subset_report( std::string const & module, bool track_sources, bool track_tests, bool html )
+{
+    if( html )
+    {
+        module_subset_html_actions actions;
+        output_module_subset_report( module, track_sources, track_tests, actions );
+    }
+    else
+    {
+        module_subset_txt_actions actions;
+        output_module_subset_report( module, track_sources, track_tests, actions );
+    }
+}
+
+// --why
+
+struct why_actions
+{
+    virtual void heading( std::string const & from, std::string const & to ) = 0;
+    virtual void end() = 0;
+
+    virtual void path( std::vector<std::string> const & path ) = 0;
+};
+
+static bool is_known_header( std::string const & header )
+{
+    return s_context->header_map_.count( header ) || s_context->header_includes_.count( header ) || s_context->header_included_by_.count( header );
+}
+
+static void why_endpoint_headers( std::string const & name, bool track_sources, bool track_tests, std::set<std::string> & headers )
+{
+    if( s_context->modules_.count( name ) )
+    {
+        headers = s_context->module_headers_[ name ];
+
+        if( track_sources )
+        {
+            add_module_headers( module_source_path( name ), headers );
+        }
+
+        if( track_tests )
+        {
+            add_module_headers( module_test_path( name ), headers );
+        }
+    }
+    else if( is_known_header( name ) )
+    {
+        headers.insert( name );
+    }
+}
+
+// walks the parent links from header to the root of one search side
+static void append_search_path( std::map< std::string, std::string > const & parent, std::string header, std::vector<std::string> & path )
+{
+    while( !header.empty() )
+    {
+        path.push_back( header );
+        header = parent.find( header )->second;
+    }
+}
+
+// bidirectional breadth-first search over the header graph given by
+// includes and included_by; headers in 'blocked' and edges in
+// 'blocked_edges' are not traversed
+static bool find_shortest_include_chain( std::set<std::string> const & from, std::set<std::string> const & to, std::map< std::string, std::set< std::string > > const & includes, std::map< std::string, std::set< std::string > > const & included_by, std::set<std::string> const & blocked, std::set< std::pair<std::string, std::string> > const & blocked_edges, std::vector<std::string> & path )
+{
+    // header -> the header it has been reached from ("" for a start point)
+    std::map< std::string, std::string > fwd, bwd;
+
+    std::vector<std::string> ff( from.begin(), from.end() ), bf( to.begin(), to.end() );
+
+    for( std::set<std::string>::const_iterator i = from.begin(); i != from.end(); ++i )
+    {
+        fwd[ *i ];
+    }
+
+    for( std::set<std::string>::const_iterator i = to.begin(); i != to.end(); ++i )
+    {
+        bwd[ *i ];
+
+        if( fwd.count( *i ) )
+        {
+            path.assign( 1, *i );
+            return true;
+        }
+    }
+
+    while( !ff.empty() && !bf.empty() )
+    {
+        // expand the smaller frontier by one full level
+
+        bool forward = ff.size() <= bf.size();
+
+        std::vector<std::string> & frontier = forward? ff: bf;
+        std::map< std::string, std::string > & seen = forward? fwd: bwd;
+        std::map< std::string, std::string > const & other = forward? bwd: fwd;
+        std::map< std::string, std::set< std::string > > const & edges = forward? includes: included_by;
+
+        std::vector<std::string> next;
+        std::vector<std::string> best;
+
+        for( std::vector<std::string>::const_iterator i = frontier.begin(); i != frontier.end(); ++i )
+        {
+            std::map< std::string, std::set< std::string > >::const_iterator j = edges.find( *i );
+
+            if( j == edges.end() ) continue;
+
+            for( std::set<std::string>::const_iterator k = j->second.begin(); k != j->second.end(); ++k )
+            {
+                if( seen.count( *k ) || blocked.count( *k ) ) continue;
+
+                if( blocked_edges.count( forward? std::make_pair( *i, *k ): std::make_pair( *k, *i ) ) ) continue;
+
+                seen[ *k ] = *i;
+                next.push_back( *k );
+
+                if( other.count( *k ) )
+                {
+                    std::vector<std::string> p;
+
+                    append_search_path( fwd, *k, p );
+                    std::reverse( p.begin(), p.end() );
+                    p.pop_back();
+                    append_search_path( bwd, *k, p );
+
+                    if( best.empty() || p.size() < best.size() )
+                    {
+                        best.swap( p );
+                    }
+                }
+            }
+        }
+
+        if( !best.empty() )
+        {
+            path.swap( best );
+            return true;
+        }
+
+        frontier.swap( next );
+    }
+
+    return false;
+}
+
+static void output_why_report( std::string const & from, std::string const & to, int count, bool track_sources, bool track_tests, why_actions & actions )
+{
+    std::set<std::string> h1, h2;
+
+    why_endpoint_headers( from, track_sources, track_tests, h1 );
+    why_endpoint_headers( to, false, false, h2 );
+
+    if( !s_context->complete_ )
+    {
+        scan_reachable_files( h1 );
+    }
+
+    // the chains only pass through the files reachable from h1, so the
+    // search back from h2 is kept to those
+
+    std::map< std::string, std::set< std::string > > const & includes = s_context->header_includes_;
+    std::map< std::string, std::set< std::string > > included_by;
+
+    {
+        std::set<std::string> visited( h1 );
+        std::vector<std::string> stack( h1.begin(), h1.end() );
+
+        while( !stack.empty() )
+        {
+            std::string file = stack.back();
+            stack.pop_back();
+
+            std::map< std::string, std::set< std::string > >::const_iterator i = includes.find( file );
+
+            if( i == includes.end() ) continue;
+
+            for( std::set<std::string>::const_iterator j = i->second.begin(); j != i->second.end(); ++j )
+            {
+                included_by[ *j ].insert( file );
+
+                if( visited.insert( *j ).second )
+                {
+                    stack.push_back( *j );
+                }
+            }
+        }
+    }
+
+    actions.heading( from, to );
+
+    std::set<std::string> blocked;
+    std::set< std::pair<std::string, std::string> > blocked_edges;
+
+    for( int k = 0; k < count; ++k )
+    {
+        std::vector<std::string> path;
+
+        if( !find_shortest_include_chain( h1, h2, includes, included_by, blocked, blocked_edges, path ) ) break;
+
+        actions.path( path );
+
+        // make the next chain disjoint from this one
+
+        if( path.size() < 3 )
+        {
+            if( path.size() < 2 ) break;
+
+            blocked_edges.insert( std::make_pair( path[0], path[1] ) );
+        }
+        else
+        {
+            blocked.insert( path.begin() + 1, path.end() - 1 );
+        }
+    }
+
+    actions.end();
+}
+
+struct why_txt_actions: public why_actions
+{
+    bool found_;
+
+    void heading( std::string const & from, std::string const & to )
+    {
+        std::cout << "Include chains from " << from << " to " << to << ":\n\n";
+        found_ = false;
+    }
+
+    void end()
+    {
+        if( !found_ )
+        {
+            std::cout << "  (none)\n";
+        }
+
+        std::cout << "\n";
+    }
+
+    void path( std::vector<std::string> const & path )
+    {
+        for( std::vector<std::string>::const_iterator i = path.begin(); i != path.end(); ++i )
+        {
+            if( i == path.begin() )
+            {
+                std::cout << "  ";
+            }
+            else
+            {
+                std::cout << " -> ";
+            }
+
+            std::cout << *i;
+        }
+
+        std::cout << "\n";
+        found_ = true;
+    }
+};
+
+struct why_html_actions: public why_actions
+{
+    bool found_;
+
+    void heading( std::string const & from, std::string const & to )
+    {
+        std::cout << "\n\n<h1 id=\"why\">Include chains from <em>" << from << "</em> to <em>" << to << "</em></h1><ul>\n";
+        found_ = false;
+    }
+
+    void end()
+    {
+        if( !found_ )
+        {
+            std::cout << "    <li><em>none</em></li>\n";
+        }
+
+        std::cout << "</ul>\n";
+    }
+
+    void path( std::vector<std::string> const & path )
+    {
+        std::cout << "    <li>";
+
+        for( std::vector<std::string>::const_iterator i = path.begin(); i != path.end(); ++i )
+        {
+            if( i != path.begin() )
+            {
+                std::cout << " &#8674; ";
+            }
+
+            std::cout << "<code>" << *i << "</code>";
+        }
+
+        std::cout << "</li>\n";
+        found_ = true;
+    }
+};
+
+static void output_why_report( std::string const & from, std::string const & to, int count, bool track_sources, bool track_tests, bool html )
+{
+    if( html )
+    {
+        why_html_actions actions;
+        output_why_report( from, to, count, track_sources, track_tests, actions );
+    }
+    else
+    {
+        why_txt_actions actions;
+        output_why_report( from, to, count, track_sources, track_tests, actions );
+    }
+}
+
+// --list-exceptions
+
+static void list_exceptions()
+{
+    std::string lm;
+
+    for( std::map< std::string, std::set<std::string> >::const_iterator i = s_context->module_headers_.begin(); i != s_context->module_headers_.end(); ++i )
+    {
+        std::string module = i->first;
+
+        std::replace( module.begin(), module.end(), '~', '/' );
+
+        std::string const prefix = "boost/" + module;
+        size_t const n = prefix.size();
+
+        for( std::set< std::string >::const_iterator j = i->second.begin(); j != i->second.end(); ++j )
+        {
+            std::string const & header = *j;
+
+            if( header.substr( 0, n+1 ) != prefix + '/' && header != prefix + ".hpp" )
+            {
+                if( lm != module )
+                {
+                    std::cout << module << ":\n";
+                    lm = module;
+                }
+
+                std::cout << "  " << header << '\n';
+            }
+        }
+    }
+}
+
+// --test
+
+struct module_test_primary_actions: public module_primary_actions
+{
+    std::set< std::string > & m_;
+
+    module_test_primary_actions( std::set< std::string > & m ): m_( m )
+    {
+    }
+
+    void heading( std::string const & module )
+    {
+        std::cout << "Test dependencies for " << module << ":\n\n";
+    }
+
+    void module_start( std::string const & module )
+    {
+        std::cout << module << "\n";
+        m_.insert( module );
+    }
+
+    void module_end( std::string const & /*module*/ )
+    {
+    }
+
+    void header_start( std::string const & /*header*/ )
+    {
+    }
+
+    void header_end( std::string const & /*header*/ )
+    {
+    }
+
+    void from_header( std::string const & /*header*/ )
+    {
+    }
+};
+
+struct module_test_secondary_actions: public module_secondary_actions
+{
+    std::set< std::string > & m_;
+    std::string m2_;
+
+    module_test_secondary_actions( std::set< std::string > & m ): m_( m )
+    {
+    }
+
+    void heading( std::string const & /*module*/ )
+    {
+    }
+
+    void module_start( std::string const & module )
+    {
+        m2_ = module;
+    }
+
+    void module_end( std::string const & /*module*/ )
+    {
+    }
+
+    void module_adds( std::string const & module )
+    {
+        if( m_.count( module ) == 0 )
+        {
+            std::cout << module << " (from " << m2_ << ")\n";
+            m_.insert( module );
+        }
+    }
+};
+
+static void output_module_test_report( std::string const & module )
+{
+    std::set< std::string > m;
+
+    module_test_primary_actions a1( m );
+    output_module_primary_report( module, a1, true, true );
+
+    std::cout << "\n";
+
+    bool secondary = false;
+    enable_secondary( secondary, true, false );
+
+    std::set< std::string > m2( m );
+    m2.insert( module );
+
+    module_test_secondary_actions a2( m2 );
+
+    output_module_secondary_report( module, m, a2 );
+}
+
+// --cmake
+
+struct collect_primary_dependencies: public module_primary_actions
+{
+    std::set< std::string > set_;
+
+    void heading( std::string const & )
+    {
+    }
+
+    void module_start( std::string const & module )
+    {
+        if( module == "(unknown)" ) return;
+
+        set_.insert( module );
+    }
+
+    void module_end( std::string const & /*module*/ )
+    {
+    }
+
+    void header_start( std::string const & /*header*/ )
+    {
+    }
+
+    void header_end( std::string const & /*header*/ )
+    {
+    }
+
+    void from_header( std::string const & /*header*/ )
+    {
+    }
+};
+
+static std::string module_cmake_name( std::string module )
+{
+    std::replace( module.begin(), module.end(), '~', '_' );
+    return module;
+}
+
+static void output_module_cmake_report( std::string module )
+{
+    std::cout << "# Generated by `boostdep --cmake " << module << "`\n\n";
+
+    std::replace( module.begin(), module.end(), '/', '~' );
+
+    collect_primary_dependencies a1;
+    output_module_primary_report( module, a1, false, false );
+
+    if( !root_exists( module_source_path( module ) ) )
+    {
+        for( std::set< std::string >::const_iterator i = a1.set_.begin(); i != a1.set_.end(); ++i )
+        {
+            std::cout << "boost_declare_dependency(INTERFACE " << module_cmake_name( *i ) << ")\n";
+        }
+    }
+    else
+    {
+        collect_primary_dependencies a2;
+        output_module_primary_report( module, a2, true, false );
+
+        for( std::set< std::string >::const_iterator i = a1.set_.begin(); i != a1.set_.end(); ++i )
+        {
+            a2.set_.erase( *i );
+            std::cout << "boost_declare_dependency(PUBLIC " << module_cmake_name( *i ) << ")\n";
+        }
+
+        std::cout << "\n";
+
+        for( std::set< std::string >::const_iterator i = a2.set_.begin(); i != a2.set_.end(); ++i )
+        {
+            std::cout << "boost_declare_dependency(PRIVATE " << module_cmake_name( *i ) << ")\n";
+        }
+    }
+}
+
+// --list-missing-headers
+
+struct missing_header_actions: public module_primary_actions
+{
+    std::string module_, module2_;
+
+    void heading( std::string const & module )
+    {
+        module_ = module;
+    }
+
+    void module_start( std::string const & module )
+    {
+        module2_ = module;
+    }
+
+    void module_end( std::string const & /*module*/ )
+    {
+    }
+
+    void header_start( std::string const & header )
+    {
+        if( module2_ == "(unknown)" )
+        {
+            if( !module_.empty() )
+            {
+                std::cout << module_ << ":\n";
+                module_.clear();
+            }
+
+            std::cout << "    <" << header << ">\n";
+        }
+    }
+
+    void header_end( std::string const & /*header*/ )
+    {
+    }
+
+    void from_header( std::string const & header )
+    {
+        if( module2_ == "(unknown)" )
+        {
+            std::cout << "        from <" << header << ">\n";
+        }
+    }
+};
+
+static void list_missing_headers( std::string const & module )
+{
+    missing_header_actions a;
+    output_module_primary_report( module, a, false, false );
+}
+
+static void list_missing_headers()
+{
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        list_missing_headers( *i );
+    }
+}
+
+// --pkgconfig
+
+struct primary_pkgconfig_actions: public module_primary_actions
+{
+    std::string version_;
+    std::string list_;
+
+    void heading( std::string const & )
+    {
+    }
+
+    void module_start( std::string const & module )
+    {
+        if( module == "(unknown)" ) return;
+
+        std::string m2( module );
+        std::replace( m2.begin(), m2.end(), '~', '_' );
+
+        if( !list_.empty() )
+        {
+            list_ += ", ";
+        }
+
+        list_ += "boost_" + m2 + " = " + version_;
+    }
+
+    void module_end( std::string const & )
+    {
+    }
+
+    void header_start( std::string const & )
+    {
+    }
+
+    void header_end( std::string const & )
+    {
+    }
+
+    void from_header( std::string const & )
+    {
+    }
+};
+
+static void output_requires( std::string const & section, std::string const & version, std::set< std::string > const & s )
+{
+    bool first = true;
+
+    for( std::set< std::string >::const_iterator i = s.begin(); i != s.end(); ++i )
+    {
+        if( first )
+        {
+            std::cout << section << ": ";
+            first = false;
+        }
+        else
+        {
+            std::cout << ", ";
+        }
+
+        std::string m2( *i );
+        std::replace( m2.begin(), m2.end(), '~', '_' );
+
+        std::cout << "boost_" << m2 << " = " << version;
+    }
+}
+
+static void output_pkgconfig( std::string const & module, std::string const & version, int argc, char const* argv[] )
+{
+    for( int i = 0; i < argc; ++i )
+    {
+        std::cout << argv[ i ] << '\n';
+    }
+
+    std::cout << '\n';
+
+    std::string m2( module );
+    std::replace( m2.begin(), m2.end(), '/', '_' );
+
+    std::string m3( module );
+    std::replace( m3.begin(), m3.end(), '/', '~' );
+
+    std::cout << "Name: boost_" << module << '\n';
+    std::cout << "Description: Boost C++ library '" << module << "'\n";
+    std::cout << "Version: " << version << '\n';
+    std::cout << "URL: http://www.boost.org/libs/" << module << '\n';
+    std::cout << "Cflags: -I${includedir}\n";
+
+    if( root_exists( module_build_path( module ) ) && root_exists( module_source_path( module ) ) )
+    {
+        std::cout << "Libs: -L${libdir} -lboost_" << m2 << "\n";
+    }
+
+    collect_primary_dependencies a1;
+    output_module_primary_report( m3, a1, false, false );
+
+    if( !a1.set_.empty() )
+    {
+        output_requires( "Requires", version, a1.set_ );
+        std::cout << std::endl;
+    }
+
+    collect_primary_dependencies a2;
+    output_module_primary_report( m3, a2, true, false );
+
+    for( std::set< std::string >::const_iterator i = a1.set_.begin(); i != a1.set_.end(); ++i )
+    {
+        a2.set_.erase( *i );
+    }
+
+    if( !a2.set_.empty() )
+    {
+        output_requires( "Requires.private", version, a2.set_ );
+        std::cout << std::endl;
+    }
+}
+
+// --subset-for
+
+static void output_directory_subset_report( std::string const & module, std::set<std::string> const & headers, bool html )
+{
+    // the files of the directory are not part of the graph, so their
+    // #includes are kept apart
+    std::map< std::string, std::set<std::string> > includes;
+
+    for( std::set<std::string>::const_iterator i = headers.begin(); i != headers.end(); ++i )
+    {
+        scan_result r;
+
+        scan_file( *i, *i, r );
+        merge_scan_result( r );
+
+        for( std::map< std::string, std::set< std::string > >::const_iterator j = r.from.begin(); j != r.from.end(); ++j )
+        {
+            for( std::set<std::string>::const_iterator k = j->second.begin(); k != j->second.end(); ++k )
+            {
+                includes[ *k ].insert( j->first );
+            }
+        }
+    }
+
+    if( !s_context->complete_ )
+    {
+        std::set< std::string > reachable;
+
+        for( std::map< std::string, std::set<std::string> >::const_iterator i = includes.begin(); i != includes.end(); ++i )
+        {
+            reachable.insert( i->second.begin(), i->second.end() );
+        }
+
+        scan_reachable_files( reachable );
+    }
+
+    if( html )
+    {
+        module_subset_html_actions actions;
+        output_module_subset_report_( module, headers, includes, actions );
+    }
+    else
+    {
+        module_subset_txt_actions actions;
+        output_module_subset_report_( module, headers, includes, actions );
+    }
+}
+
+// --pch-candidates
+
+struct pch_candidate_actions
+{
+    virtual void begin( int units, unsigned long long bytes, unsigned long long budget ) = 0;
+    virtual void end( int headers, unsigned long long size, unsigned long long saved, unsigned long long bytes ) = 0;
+
+    // `header` is reached from `units` translation units, and adds `size`
+    // bytes to the precompiled header
+    virtual void header( std::string const & header, int units, unsigned long long size, unsigned long long saved ) = 0;
+};
+
+static int percentage( unsigned long long part, unsigned long long whole )
+{
+    return whole == 0? 0: static_cast< int >( 100.0 * part / whole + 0.5 );
+}
+
+// the gain of adding a header to the precompiled header, as of round
+struct pch_gain
+{
+    int header;
+    int round;
+
+    unsigned long long saved;
+    unsigned long long size;
+
+    // by bytes saved per byte added, then by bytes saved
+    bool operator<( pch_gain const & g ) const
+    {
+        double const r1 = static_cast< double >( saved ) * g.size;
+        double const r2 = static_cast< double >( g.saved ) * size;
+
+        if( r1 != r2 ) return r1 < r2;
+        if( saved != g.saved ) return saved < g.saved;
+
+        return header > g.header;
+    }
+};
+
+// the bytes that the headers reachable from g.header, and not yet in pch,
+// would save and add
+static void update_pch_gain( header_closure const & hc, boost::dynamic_bitset<> const & pch, std::vector< unsigned long long > const & weight, std::vector< unsigned long long > const & bytes, pch_gain & g )
+{
+    boost::dynamic_bitset<> const & s = hc.closure_[ hc.component_[ g.header ] ];
+
+    g.saved = 0;
+    g.size = 0;
+
+    for( std::size_t i = s.find_first(); i != s.npos; i = s.find_next( i ) )
+    {
+        if( !pch.test( i ) )
+        {
+            g.saved += weight[ i ];
+            g.size += bytes[ i ];
+        }
+    }
+}
+
+static bool is_source_file( std::string const & file )
+{
+    std::string const ext = fs::path( file ).extension().string();
+    return ext == ".c" || ext == ".cc" || ext == ".cpp" || ext == ".cxx";
+}
+
+// [component, component...] -> translation units; the translation units of
+// dir are its source files, or all of its files when it has none, and reach
+// the Boost headers that they, or the files of dir they include, include
+static int pch_translation_units( std::string const & dir, header_closure & hc, std::map< std::vector< int >, int > & units )
+{
+    std::set< std::string > files;
+    add_module_headers( dir, files );
+
+    // file -> the components of the Boost headers, and the files of dir,
+    // it includes
+    std::map< std::string, std::set< int > > boost_includes;
+    std::map< std::string, std::set< std::string > > local_includes;
+
+    for( std::set< std::string >::const_iterator i = files.begin(); i != files.end(); ++i )
+    {
+        file_includes f;
+        scan_file_includes( *i, f );
+
+        scan_result r;
+        add_header_dependencies( *i, f, r );
+
+        for( std::map< std::string, std::set< std::string > >::const_iterator j = r.from.begin(); j != r.from.end(); ++j )
+        {
+            std::map< std::string, int >::const_iterator k = hc.index_.find( j->first );
+
+            if( k != hc.index_.end() )
+            {
+                boost_includes[ *i ].insert( hc.component_[ k->second ] );
+            }
+        }
+
+        // relative to the file, then to dir
+        fs::path const base = fs::path( *i ).parent_path();
+
+        for( std::vector< std::string >::const_iterator j = f.includes.begin(); j != f.includes.end(); ++j )
+        {
+            std::string const p1 = ( base / *j ).lexically_normal().generic_string();
+            std::string const p2 = ( fs::path( dir ) / *j ).lexically_normal().generic_string();
+
+            if( files.count( p1 ) )
+            {
+                local_includes[ *i ].insert( p1 );
+            }
+            else if( files.count( p2 ) )
+            {
+                local_includes[ *i ].insert( p2 );
+            }
+        }
+    }
+
+    bool sources = false;
+
+    for( std::set< std::string >::const_iterator i = files.begin(); i != files.end() && !sources; ++i )
+    {
+        sources = is_source_file( *i );
+    }
+
+    int n = 0;
+
+    for( std::set< std::string >::const_iterator i = files.begin(); i != files.end(); ++i )
+    {
+        if( sources && !is_source_file( *i ) ) continue;
+
+        std::set< std::string > visited;
+        std::vector< std::string > stack( 1, *i );
+
+        std::set< int > components;
+
+        while( !stack.empty() )
+        {
+            std::string file = stack.back();
+            stack.pop_back();
+
+            if( !visited.insert( file ).second ) continue;
+
+            std::set< int > const & c = boost_includes[ file ];
+            components.insert( c.begin(), c.end() );
+
+            std::set< std::string > const & inc = local_includes[ file ];
+            stack.insert( stack.end(), inc.begin(), inc.end() );
+        }
+
+        ++units[ std::vector< int >( components.begin(), components.end() ) ];
+        ++n;
+    }
+
+    return n;
+}
+
+// the translation units are those of dir or, when dir is empty, every
+// module header on its own
+static void output_pch_candidate_report( std::string const & dir, unsigned long long budget, pch_candidate_actions & actions )
+{
+    if( !dir.empty() && !root_exists( dir ) )
+    {
+        std::cerr << "'" << dir << "': could not find directory.\n";
+        return;
+    }
+
+    header_closure hc;
+    build_header_closure( hc );
+
+    int const n = hc.headers_.size();
+
+    // translation units that reach the same components share their closure
+    std::map< std::vector< int >, int > units;
+
+    int unit_count = 0;
+
+    if( dir.empty() )
+    {
+        for( std::map< std::string, std::string >::const_iterator i = s_context->header_map_.begin(); i != s_context->header_map_.end(); ++i )
+        {
+            ++units[ std::vector< int >( 1, hc.component_[ hc.index_[ i->first ] ] ) ];
+            ++unit_count;
+        }
+    }
+    else
+    {
+        unit_count = pch_translation_units( dir, hc, units );
+    }
+
+    // header -> translation units that reach it
+    std::vector< int > count( n );
+
+    unsigned long long total = 0;
+
+    for( std::map< std::vector< int >, int >::const_iterator i = units.begin(); i != units.end(); ++i )
+    {
+        boost::dynamic_bitset<> s( n );
+
+        for( std::vector< int >::const_iterator j = i->first.begin(); j != i->first.end(); ++j )
+        {
+            s |= hc.closure_[ *j ];
+        }
+
+        for( std::size_t j = s.find_first(); j != s.npos; j = s.find_next( j ) )
+        {
+            count[ j ] += i->second;
+        }
+
+        total += static_cast< unsigned long long >( closure_size( hc, s ).bytes ) * i->second;
+    }
+
+    // header -> its size, and its size across the translation units
+    std::vector< unsigned long long > bytes( n ), weight( n );
+
+    for( int i = 0; i < n; ++i )
+    {
+        std::map< std::string, file_size >::const_iterator j = s_context->file_sizes_.find( hc.headers_[ i ] );
+
+        if( j != s_context->file_sizes_.end() )
+        {
+            bytes[ i ] = j->second.bytes;
+            weight[ i ] = static_cast< unsigned long long >( j->second.bytes ) * count[ i ];
+        }
+    }
+
+    // greedy selection by bytes saved per byte added; a gain is recomputed
+    // when it reaches the top of the queue, and the header is picked when
+    // its gain there is current
+    boost::dynamic_bitset<> pch( n );
+    std::priority_queue< pch_gain > queue;
+
+    for( int i = 0; i < n; ++i )
+    {
+        if( count[ i ] == 0 || !s_context->header_map_.count( hc.headers_[ i ] ) ) continue;
+
+        pch_gain g;
+
+        g.header = i;
+        g.round = 0;
+
+        update_pch_gain( hc, pch, weight, bytes, g );
+
+        if( g.saved > 0 )
+        {
+            queue.push( g );
+        }
+    }
+
+    actions.begin( unit_count, total, budget );
+
+    int round = 0;
+    unsigned long long pch_size = 0, saved = 0;
+
+    // headers too large for what remained of the budget
+    std::vector< pch_gain > rejected;
+
+    while( !queue.empty() )
+    {
+        pch_gain g = queue.top();
+        queue.pop();
+
+        if( g.round != round )
+        {
+            update_pch_gain( hc, pch, weight, bytes, g );
+            g.round = round;
+
+            if( g.saved > 0 )
+            {
+                queue.push( g );
+            }
+
+            continue;
+        }
+
+        // too large for what remains of the budget; smaller headers
+        // may still fit, and this one is reconsidered after each of them
+        if( pch_size + g.size > budget )
+        {
+            rejected.push_back( g );
+            continue;
+        }
+
+        pch |= hc.closure_[ hc.component_[ g.header ] ];
+
+        pch_size += g.size;
+        saved += g.saved;
+
+        ++round;
+
+        // what a rejected header adds shrinks by at most g.size; those
+        // that may fit now go back to the queue, where their gains are
+        // recomputed, and the others wait for the next pick
+        std::vector< pch_gain > waiting;
+
+        for( std::vector< pch_gain >::const_iterator i = rejected.begin(); i != rejected.end(); ++i )
+        {
+            pch_gain r = *i;
+            r.size = r.size > g.size? r.size - g.size: 0;
+
+            if( pch_size + r.size > budget )
+            {
+                waiting.push_back( r );
+            }
+            else
+            {
+                queue.push( r );
+            }
+        }
+
+        rejected.swap( waiting );
+
+        actions.header( hc.headers_[ g.header ], count[ g.header ], g.size, g.saved );
+    }
+
+    actions.end( round, pch_size, saved, total );
+}
+
+struct pch_candidate_txt_actions: public pch_candidate_actions
+{
+    void begin( int units, unsigned long long bytes, unsigned long long budget )
+    {
+        std::cout << "PCH Candidates:\n\n" << units << " translation units include " << bytes << " bytes of headers; the budget is " << budget << " bytes\n\n";
+    }
+
+    void end( int headers, unsigned long long size, unsigned long long saved, unsigned long long bytes )
+    {
+        std::cout << "\n" << headers << " headers, " << size << " bytes, save " << saved << " of " << bytes << " bytes (" << percentage( saved, bytes ) << "%)\n";
+    }
+
+    void header( std::string const & header, int units, unsigned long long size, unsigned long long saved )
+    {
+        std::cout << "    <" << header << "> (" << units << " translation units): adds " << size << " bytes, saves " << saved << " bytes\n";
+    }
+};
+
+struct pch_candidate_html_actions: public pch_candidate_actions
+{
+    void begin( int units, unsigned long long bytes, unsigned long long budget )
+    {
+        std::cout << "<div id='pch-candidates'><h1>PCH Candidates</h1>\n  <p>" << units << " translation units include " << bytes << " bytes of headers; the budget is " << budget << " bytes</p>\n"
+            "  <table>\n    <tr><th>Header</th><th>Translation units</th><th>Bytes added</th><th>Bytes saved</th></tr>\n";
+    }
+
+    void end( int headers, unsigned long long size, unsigned long long saved, unsigned long long bytes )
+    {
+        std::cout << "  </table>\n  <p>" << headers << " headers, " << size << " bytes, save " << saved << " of " << bytes << " bytes (" << percentage( saved, bytes ) << "%)</p>\n</div>\n";
+    }
+
+    void header( std::string const & header, int units, unsigned long long size, unsigned long long saved )
+    {
+        std::cout << "    <tr><td><code>&lt;" << header << "&gt;</code></td><td>" << units << "</td><td>" << size << "</td><td>" << saved << "</td></tr>\n";
+    }
+};
+
+static void output_pch_candidate_report( std::string const & dir, unsigned long long budget, bool html )
+{
+    if( html )
+    {
+        pch_candidate_html_actions actions;
+        output_pch_candidate_report( dir, budget, actions );
+    }
+    else
+    {
+        pch_candidate_txt_actions actions;
+        output_pch_candidate_report( dir, budget, actions );
+    }
+}
+
+// list_buildable_dependencies
+
+struct list_buildable_dependencies_actions: public module_overview_actions
+{
+    std::set< std::string > buildable_;
+
+    std::set< std::string > deps_;
+    bool headers_;
+
+    list_buildable_dependencies_actions(): headers_()
+    {
+    }
+
+    void begin()
+    {
+        std::cout << "# Generated by `boostdep --list-buildable-dependencies`\n\n";
+    }
+
+    void end()
+    {
+    }
+
+    void module_start( std::string const & module )
+    {
+        deps_.clear();
+        headers_ = false;
+
+        if( buildable_.count( module ) )
+        {
+            std::cout << module << " =";
+        }
+    }
+
+    void module_end( std::string const & module )
+    {
+        if( buildable_.count( module ) )
+        {
+            if( headers_ )
+            {
+                std::cout << " headers";
+            }
+
+            for( std::set< std::string >::iterator i = deps_.begin(); i != deps_.end(); ++i )
+            {
+                std::cout << " " << *i;
+            }
+
+            std::cout << " ;\n";
+        }
+    }
+
+    void module2( std::string const & module )
+    {
+        if( module == "(unknown)" ) return;
+
+        if( buildable_.count( module ) == 0 )
+        {
+            headers_ = true;
+        }
+        else
+        {
+            deps_.insert( module );
+        }
+    }
+};
+
+static void list_buildable_dependencies( bool & secondary )
+{
+    list_buildable_dependencies_actions actions;
+
+    for( std::set< std::string >::iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        if( root_exists( module_build_path( *i ) ) && root_exists( module_source_path( *i ) ) )
+        {
+            actions.buildable_.insert( *i );
+        }
+    }
+
+    output_module_overview_report( actions, secondary, true, false );
+}
+
+// --use-config
+
+// makes configuration k (-1 for all) the one the dependency maps are
+// built for; returns whether the maps are complete afterwards
+static bool use_configuration( int k )
+{
+    s_context->active_config_ = k;
+
+    if( !s_context->complete_ ) return false;
+
+    // with --preprocess, the scans themselves depend on the configuration
+    bool kept = !s_context->preprocess_;
+
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); kept && i != s_context->modules_.end(); ++i )
+    {
+        kept = s_context->module_scans_.count( *i ) != 0;
+    }
+
+    s_context->module_deps_.clear();
+    s_context->header_deps_.clear();
+    s_context->reverse_deps_.clear();
+    s_context->header_includes_.clear();
+    s_context->header_included_by_.clear();
+
+    if( !kept )
+    {
+        // the maps weren't built from kept scans; rebuild them on demand
+        s_context->complete_ = false;
+        s_context->module_scans_.clear();
+        return false;
+    }
+
+    for( std::map< std::string, scan_result >::const_iterator i = s_context->module_scans_.begin(); i != s_context->module_scans_.end(); ++i )
+    {
+        scan_result r( i->second );
+
+        build_mdmap_actions actions;
+        report_module_dependencies( i->first, r, actions, true );
+    }
+
+    return true;
+}
+
+// --watch
+
+#if defined(__linux__)
+
+static void add_watch( watched_directory wd )
+{
+    uint32_t const mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF;
+
+    int w = inotify_add_watch( s_context->watch_fd_, root_path( wd.path_ ).string().c_str(), mask );
+
+    if( w < 0 )
+    {
+        std::cerr << "boostdep: could not watch '" << wd.path_.string() << "'.\n";
+        return;
+    }
+
+    s_context->watched_dirs_[ w ] = wd;
+
+    fs::directory_iterator it( root_path( wd.path_ ) ), last;
+
+    fs::path const path = wd.path_;
+
+    for( ; it != last; ++it )
+    {
+        if( it->status().type() == fs::directory_file )
+        {
+            wd.path_ = path / it->path().filename();
+            add_watch( wd );
+        }
+    }
+}
+
+static void add_module_watch( std::string const & module, fs::path const & root, bool include )
+{
+    if( !fs::exists( root_path( root ) ) ) return;
+
+    watched_directory wd;
+
+    wd.module_ = module;
+    wd.root_ = root;
+    wd.include_ = include;
+    wd.path_ = root;
+
+    add_watch( wd );
+}
+
+static void add_module_watches( std::string const & module, bool track_sources, bool track_tests )
+{
+    add_module_watch( module, module_include_path( module ), true );
+
+    if( track_sources )
+    {
+        add_module_watch( module, module_source_path( module ), false );
+    }
+
+    if( track_tests )
+    {
+        add_module_watch( module, module_test_path( module ), false );
+    }
+}
+
+static void add_module_watches( bool track_sources, bool track_tests )
+{
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        add_module_watches( *i, track_sources, track_tests );
+    }
+}
+
+static void add_tree_watch( fs::path const & path )
+{
+    uint32_t const mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+
+    int w = inotify_add_watch( s_context->watch_fd_, root_path( path ).string().c_str(), mask );
+
+    if( w < 0 )
+    {
+        std::cerr << "boostdep: could not watch '" << path.string() << "'.\n";
+        return;
+    }
+
+    watched_directory wd;
+
+    wd.tree_ = true;
+    wd.path_ = path;
+
+    s_context->watched_dirs_[ w ] = wd;
+}
+
+// watches libs/ for new modules, and the directories under it for new
+// include, src and test directories
+static void add_tree_watches()
+{
+    fs::path const libs( "libs" );
+
+    add_tree_watch( libs );
+
+    fs::directory_iterator it( root_path( libs ) ), last;
+
+    for( ; it != last; ++it )
+    {
+        if( it->status().type() == fs::directory_file )
+        {
+            add_tree_watch( libs / it->path().filename() );
+        }
+    }
+}
+
+static bool start_watch( bool track_sources, bool track_tests )
+{
+    s_context->watch_fd_ = inotify_init();
+
+    if( s_context->watch_fd_ < 0 )
+    {
+        std::cerr << "'--watch': could not initialize inotify.\n";
+        return false;
+    }
+
+    try
+    {
+        add_tree_watches();
+        add_module_watches( track_sources, track_tests );
+    }
+    catch( fs::filesystem_error const & x )
+    {
+        std::cerr << x.what() << std::endl;
+    }
+
+    return true;
+}
+
+// whether a directory of this name, created or removed in a module
+// directory, changes the modules or their files
+static bool is_module_directory( std::string const & name )
+{
+    return name == "include" || name == "sublibs" || name == "src" || name == "test";
+}
+
+// what --watch has seen change since the maps were last updated
+struct watch_changes
+{
+    // file -> the directory it's in
+    std::map< std::string, watched_directory > files_;
+
+    // the directories under libs/ of the modules that have appeared, or
+    // have gained an include, src or test directory
+    std::set< std::string > dirs_;
+
+    // a directory has been created or removed, or events have been lost
+    bool rebuild_;
+
+    // events have been lost, so the directories are all watched again
+    bool overflow_;
+
+    watch_changes(): rebuild_( false ), overflow_( false )
+    {
+    }
+};
+
+// reads the pending inotify events into changes
+static void read_watch_events( watch_changes & changes )
+{
+    char buffer[ 16384 ];
+
+    ssize_t n = read( s_context->watch_fd_, buffer, sizeof( buffer ) );
+
+    for( ssize_t k = 0; k > -1 && k < n; )
+    {
+        inotify_event const * e = reinterpret_cast< inotify_event const * >( buffer + k );
+        k += sizeof( inotify_event ) + e->len;
+
+        if( e->mask & IN_Q_OVERFLOW )
+        {
+            // the queue was full and events have been dropped, so only
+            // a rescan of everything is certain to be up to date
+            changes.rebuild_ = true;
+            changes.overflow_ = true;
+            continue;
+        }
+
+        std::map< int, watched_directory >::const_iterator i = s_context->watched_dirs_.find( e->wd );
+
+        if( e->mask & IN_IGNORED )
+        {
+            s_context->watched_dirs_.erase( e->wd );
+            continue;
+        }
+
+        if( i == s_context->watched_dirs_.end() || e->len == 0 ) continue;
+
+        watched_directory wd = i->second;
+        wd.path_ /= e->name;
+
+        if( wd.tree_ )
+        {
+            if( !( e->mask & IN_ISDIR ) ) continue;
+
+            if( i->second.path_ == "libs" )
+            {
+                // a module has been added or removed
+                if( e->mask & ( IN_CREATE | IN_MOVED_TO ) )
+                {
+                    add_tree_watch( wd.path_ );
+                    changes.dirs_.insert( e->name );
+                }
+
+                changes.rebuild_ = true;
+            }
+            else if( is_module_directory( e->name ) )
+            {
+                if( e->mask & ( IN_CREATE | IN_MOVED_TO ) )
+                {
+                    changes.dirs_.insert( i->second.path_.filename().string() );
+                }
+
+                changes.rebuild_ = true;
+            }
+        }
+        else if( e->mask & IN_ISDIR )
+        {
+            if( e->mask & ( IN_CREATE | IN_MOVED_TO ) )
+            {
+                try
+                {
+                    add_watch( wd );
+                }
+                catch( fs::filesystem_error const & x )
+                {
+                    // removed again before it could be watched
+                    std::cerr << x.what() << std::endl;
+                }
+            }
+
+            changes.rebuild_ = true;
+        }
+        else
+        {
+            changes.files_[ wd.path_.generic_string() ] = wd;
+        }
+    }
+}
+
+// adds the watches of the modules under the directories of libs/ in dirs
+static void add_new_module_watches( std::set< std::string > const & dirs, bool track_sources, bool track_tests )
+{
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        // libs/m holds the module m and its sublibraries m~s
+        std::string const dir = i->substr( 0, i->find( '~' ) );
+
+        if( dirs.count( dir ) )
+        {
+            add_module_watches( *i, track_sources, track_tests );
+        }
+    }
+}
+
+// waits for files to change, then updates the dependency maps
+static bool wait_for_changes( bool & secondary, bool track_sources, bool track_tests )
+{
+    watch_changes changes;
+
+    pollfd pfd = { s_context->watch_fd_, POLLIN, 0 };
+
+    if( poll( &pfd, 1, -1 ) < 0 )
+    {
+        return false;
+    }
+
+    double t0 = wall_time_ms();
+
+    // editors tend to save in several steps, so coalesce the events
+    // that arrive within a few milliseconds of each other
+
+    do
+    {
+        read_watch_events( changes );
+    }
+    while( poll( &pfd, 1, 10 ) > 0 );
+
+    bool rebuild = changes.rebuild_;
+
+    std::set< std::string > modules;
+
+    for( std::map< std::string, watched_directory >::const_iterator i = changes.files_.begin(); i != changes.files_.end() && !rebuild; ++i )
+    {
+        watched_directory const & wd = i->second;
+
+        std::string header = i->first;
+        bool exists = fs::is_regular_file( root_path( wd.path_ ) );
+
+        if( wd.include_ )
+        {
+            header = header.substr( wd.root_.generic_string().size() + 1 );
+
+            if( exists != ( s_context->header_map_.count( header ) != 0 ) )
+            {
+                // a header has been added or removed; includes that used to
+                // be resolved (or unresolved) may have changed meaning
+                rebuild = true;
+                break;
+            }
+        }
+
+        update_header_dependencies( wd.module_, header, wd.path_ );
+        modules.insert( wd.module_ );
+    }
+
+    try
+    {
+        if( rebuild )
+        {
+            // the modules of --overlay-root are not under libs/, so the
+            // header map wouldn't find them again
+            std::map< std::string, fs::path > module_dirs;
+            module_dirs.swap( s_context->module_dirs_ );
+
+            reset_dependency_maps();
+
+            s_context->module_dirs_.swap( module_dirs );
+
+            build_header_map();
+
+            for( std::map< std::string, fs::path >::const_iterator i = s_context->module_dirs_.begin(); i != s_context->module_dirs_.end(); ++i )
+            {
+                map_module_headers( i->first );
+            }
+
+            secondary = false;
+            enable_secondary( secondary, track_sources, track_tests );
+
+            // the directories that already were watched still are, and
+            // those created under them are watched as they appear
+            if( changes.overflow_ )
+            {
+                add_tree_watches();
+                add_module_watches( track_sources, track_tests );
+            }
+            else
+            {
+                add_new_module_watches( changes.dirs_, track_sources, track_tests );
+            }
+        }
+        else
+        {
+            for( std::set< std::string >::const_iterator i = modules.begin(); i != modules.end(); ++i )
+            {
+                update_module_dependencies( *i, track_sources, track_tests );
+            }
+        }
+    }
+    catch( fs::filesystem_error const & x )
+    {
+        std::cerr << x.what() << std::endl;
+    }
+
+    std::cerr << "boostdep: " << changes.files_.size() << " file(s) changed, " << ( rebuild? "rescanned": "updated" ) << " in " << static_cast<int>( wall_time_ms() - t0 ) << " ms\n";
+
+    return true;
+}
+
+#else
+
+static bool start_watch( bool /*track_sources*/, bool /*track_tests*/ )
+{
+    std::cerr << "'--watch': not supported on this platform.\n";
+    return false;
+}
+
+static bool wait_for_changes( bool & /*secondary*/, bool /*track_sources*/, bool /*track_tests*/ )
+{
+    return false;
+}
+
+#endif
+
+// --what-if
+
+struct what_if_actions
+{
+    virtual void heading( std::string const & file ) = 0;
+    virtual void end() = 0;
+
+    virtual void section_start( std::string const & title ) = 0;
+    virtual void section_end() = 0;
+
+    virtual void module_dependency( std::string const & module, std::string const & module2, bool added ) = 0;
+    virtual void module_level( std::string const & module, int level1, int level2 ) = 0;
+    virtual void module_weight( std::string const & module, int weight1, int weight2 ) = 0;
+};
+
+// the module a scanned file belongs to
+static std::string file_module( std::string const & header )
+{
+    std::map< std::string, std::string >::const_iterator i = s_context->header_map_.find( header );
+
+    if( i != s_context->header_map_.end() )
+    {
+        return i->second;
+    }
+
+    std::string module;
+
+    for( std::set< std::string >::const_iterator j = s_context->modules_.begin(); j != s_context->modules_.end(); ++j )
+    {
+        std::string m2 = *j;
+        std::replace( m2.begin(), m2.end(), '~', '/' );
+
+        std::string const prefix = "libs/" + m2 + "/";
+
+        if( header.compare( 0, prefix.size(), prefix ) == 0 && j->size() > module.size() )
+        {
+            module = *j;
+        }
+    }
+
+    return module;
+}
+
+static std::string header_module( std::string const & header )
+{
+    std::map< std::string, std::string >::const_iterator i = s_context->header_map_.find( header );
+    return i != s_context->header_map_.end()? i->second: "(unknown)";
+}
+
+static void apply_header_edge( std::string const & header, std::string const & header2, bool add )
+{
+    bool cross = header_module( header ) != header_module( header2 );
+
+    if( add )
+    {
+        s_context->header_includes_[ header ].insert( header2 );
+        s_context->header_included_by_[ header2 ].insert( header );
+
+        if( cross )
+        {
+            s_context->header_deps_[ header2 ].insert( header );
+        }
+    }
+    else
+    {
+        s_context->header_includes_[ header ].erase( header2 );
+        s_context->header_included_by_[ header2 ].erase( header );
+        s_context->header_deps_[ header2 ].erase( header );
+    }
+}
+
+// modules whose closure can contain one of modules, plus modules themselves
+static std::set< std::string > reverse_closure( std::set< std::string > const & modules )
+{
+    std::set< std::string > r( modules );
+    std::vector< std::string > todo( modules.begin(), modules.end() );
+
+    while( !todo.empty() )
+    {
+        std::string m = todo.back();
+        todo.pop_back();
+
+        std::set< std::string > const & rd = s_context->reverse_deps_[ m ];
+
+        for( std::set< std::string >::const_iterator i = rd.begin(); i != rd.end(); ++i )
+        {
+            if( r.insert( *i ).second )
+            {
+                todo.push_back( *i );
+            }
+        }
+    }
+
+    return r;
+}
+
+static void output_what_if_report( std::string const & file, bool track_sources, bool track_tests, what_if_actions & actions )
+{
+    fs::ifstream is( root_path( file ) );
+
+    if( !is )
+    {
+        std::cerr << "'" << file << "': could not open file.\n";
+        return;
+    }
+
+    // read edits; each line is '+ <header> <header>' or '- <header> <header>'
+
+    std::vector< std::pair< bool, std::pair< std::string, std::string > > > edits;
+
+    {
+        std::string line;
+
+        for( int n = 1; std::getline( is, line ); ++n )
+        {
+            std::istringstream ls( line );
+
+            std::string op, h1, h2;
+            ls >> op;
+
+            if( op.empty() || op[0] == '#' ) continue;
+
+            if( ( op != "+" && op != "-" ) || !( ls >> h1 >> h2 ) )
+            {
+                std::cerr << file << "(" << n << "): expected '+ <header> <header>' or '- <header> <header>'.\n";
+                continue;
+            }
+
+            edits.push_back( std::make_pair( op == "+", std::make_pair( h1, h2 ) ) );
+        }
+    }
+
+    // baseline
+
+    std::map< std::string, std::set< std::string > > mdeps1 = s_context->module_deps_;
+
+    std::map< std::string, int > levels1;
+    compute_module_levels( levels1 );
+
+    std::map< std::string, std::set< std::string > > secondary_deps;
+    compute_secondary_dependencies( s_context->modules_, secondary_deps );
+
+    std::map< std::string, int > weights1;
+
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        weights1[ *i ] = module_weight( *i, secondary_deps );
+    }
+
+    // apply the edits and recompute the edges of the affected modules
+
+    std::set< std::string > affected;
+
+    for( std::size_t i = 0; i < edits.size(); ++i )
+    {
+        std::string const & h1 = edits[ i ].second.first;
+        std::string const & h2 = edits[ i ].second.second;
+
+        std::string module = file_module( h1 );
+
+        if( module.empty() )
+        {
+            std::cerr << "'" << h1 << "': not a header or a source file of a module.\n";
+            continue;
+        }
+
+        apply_header_edge( h1, h2, edits[ i ].first );
+        affected.insert( module );
+    }
+
+    // modules that could reach an affected module before the edits
+    std::set< std::string > stale = reverse_closure( affected );
+
+    for( std::set< std::string >::const_iterator i = affected.begin(); i != affected.end(); ++i )
+    {
+        update_module_dependencies( *i, track_sources, track_tests );
+    }
+
+    // ... or can reach one after them
+    {
+        std::set< std::string > stale2 = reverse_closure( affected );
+        stale.insert( stale2.begin(), stale2.end() );
+    }
+
+    // closures of modules that can't reach an affected module are unchanged
+    compute_secondary_dependencies( stale, secondary_deps );
+
+    std::map< std::string, int > levels2;
+    compute_module_levels( levels2 );
+
+    // output report
+
+    actions.heading( file );
+
+    actions.section_start( "Module dependencies" );
+
+    for( std::set< std::string >::const_iterator i = affected.begin(); i != affected.end(); ++i )
+    {
+        std::set< std::string > const & d1 = mdeps1[ *i ];
+        std::set< std::string > const & d2 = s_context->module_deps_[ *i ];
+
+        for( std::set< std::string >::const_iterator j = d1.begin(); j != d1.end(); ++j )
+        {
+            if( d2.count( *j ) == 0 )
+            {
+                actions.module_dependency( *i, *j, false );
+            }
+        }
+
+        for( std::set< std::string >::const_iterator j = d2.begin(); j != d2.end(); ++j )
+        {
+            if( d1.count( *j ) == 0 )
+            {
+                actions.module_dependency( *i, *j, true );
+            }
+        }
+    }
+
+    actions.section_end();
+
+    actions.section_start( "Module levels" );
+
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        if( levels1[ *i ] != levels2[ *i ] )
+        {
+            actions.module_level( *i, levels1[ *i ], levels2[ *i ] );
+        }
+    }
+
+    actions.section_end();
+
+    actions.section_start( "Module weights" );
+
+    for( std::set< std::string >::const_iterator i = stale.begin(); i != stale.end(); ++i )
+    {
+        int w2 = module_weight( *i, secondary_deps );
+
+        if( weights1[ *i ] != w2 )
+        {
+            actions.module_weight( *i, weights1[ *i ], w2 );
+        }
+    }
+
+    actions.section_end();
+
+    actions.end();
+}
+
+static void output_level( int level )
+{
+    if( level >= unknown_level )
+    {
+        std::cout << "-";
+    }
+    else
+    {
+        std::cout << level;
+    }
+}
+
+struct what_if_txt_actions: public what_if_actions
+{
+    void heading( std::string const & file )
+    {
+        std::cout << "What-if report for " << file << ":\n\n";
+    }
+
+    void end()
+    {
+    }
+
+    void section_start( std::string const & title )
+    {
+        std::cout << title << ":\n";
+    }
+
+    void section_end()
+    {
+        std::cout << "\n";
+    }
+
+    void module_dependency( std::string const & module, std::string const & module2, bool added )
+    {
+        std::cout << "    " << ( added? "+ ": "- " ) << module << " -> " << module2 << "\n";
+    }
+
+    void module_level( std::string const & module, int level1, int level2 )
+    {
+        std::cout << "    " << module << ": ";
+        output_level( level1 );
+        std::cout << " -> ";
+        output_level( level2 );
+        std::cout << "\n";
+    }
+
+    void module_weight( std::string const & module, int weight1, int weight2 )
+    {
+        std::cout << "    " << module << ": " << weight1 << " -> " << weight2 << "\n";
+    }
+};
+
+struct what_if_html_actions: public what_if_actions
+{
+    void heading( std::string const & file )
+    {
+        std::cout << "\n\n<h1 id=\"what-if\">What-if report for <em>" << file << "</em></h1>\n";
+    }
+
+    void end()
+    {
+    }
+
+    void section_start( std::string const & title )
+    {
+        std::cout << "  <h2>" << title << "</h2><ul>\n";
+    }
+
+    void section_end()
+    {
+        std::cout << "  </ul>\n";
+    }
+
+    void module_dependency( std::string const & module, std::string const & module2, bool added )
+    {
+        std::cout << "    <li>" << ( added? "adds": "removes" ) << " <a href=\"" << module << ".html\"><em>" << module << "</em></a> &#8674; <em>" << module2 << "</em></li>\n";
+    }
+
+    void module_level( std::string const & module, int level1, int level2 )
+    {
+        std::cout << "    <li><a href=\"" << module << ".html\"><em>" << module << "</em></a>: ";
+        output_level( level1 );
+        std::cout << " &#8674; ";
+        output_level( level2 );
+        std::cout << "</li>\n";
+    }
+
+    void module_weight( std::string const & module, int weight1, int weight2 )
+    {
+        std::cout << "    <li><a href=\"" << module << ".html\"><em>" << module << "</em></a>: " << weight1 << " &#8674; " << weight2 << "</li>\n";
+    }
+};
+
+static void output_what_if_report( std::string const & file, bool track_sources, bool track_tests, bool html )
+{
+    if( html )
+    {
+        what_if_html_actions actions;
+        output_what_if_report( file, track_sources, track_tests, actions );
+    }
+    else
+    {
+        what_if_txt_actions actions;
+        output_what_if_report( file, track_sources, track_tests, actions );
+    }
+}
+
+//
+
+// teebuf
+
+class teebuf: public std::streambuf
+{
+private:
+
+    std::streambuf * sb1_;
+    std::streambuf * sb2_;
+
+public:
+
+    teebuf( std::streambuf * sb1, std::streambuf * sb2 ): sb1_( sb1 ), sb2_( sb2 )
+    {
+    }
+
+private:
+
+    virtual int overflow( int c )
+    {
+        int r1 = sb1_->sputc( c );
+        int r2 = sb2_->sputc( c );
+
+        return r1 == EOF || r2 == EOF? EOF : c;
+    }
+
+    virtual int sync()
+    {
+        int r1 = sb1_->pubsync();
+        int r2 = sb2_->pubsync();
+
+        return r1 == 0 && r2 == 0? 0 : -1;
+    }
+};
+
+// save_cout_rdbuf
+
+class save_cout_rdbuf
+{
+private:
+
+    std::streambuf * sb_;
+
+public:
+
+    save_cout_rdbuf(): sb_( std::cout.rdbuf() )
+    {
+    }
+
+    std::streambuf * rdbuf() const
+    {
+        return sb_;
+    }
+
+    ~save_cout_rdbuf()
+    {
+        std::cout.rdbuf( sb_ );
+    }
+};
+
+// --profile summary
+
+static void output_json_string( std::ostream & os, std::string const & s )
+{
+    os << '"';
+
+    for( std::string::const_iterator i = s.begin(); i != s.end(); ++i )
+    {
+        if( *i == '"' || *i == '\\' )
+        {
+            os << '\\';
+        }
+
+        os << *i;
+    }
+
+    os << '"';
+}
+
+// writes the events in the Chrome trace event format
+static void write_profile_trace( std::string const & fn )
+{
+    fs::ofstream os( root_path( fn ) );
+
+    if( !os )
+    {
+        std::cerr << "'" << fn << "': could not open file.\n";
+        return;
+    }
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    std::set< int > threads;
+
+    for( std::vector< profile_event >::const_iterator i = s_profile_events.begin(); i != s_profile_events.end(); ++i )
+    {
+        os << "{\"name\":";
+        output_json_string( os, i->name );
+        os << ",\"cat\":\"" << i->category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << i->thread;
+        os << ",\"ts\":" << static_cast< long long >( i->start * 1000 ) << ",\"dur\":" << static_cast< long long >( i->wall * 1000 );
+        os << ",\"args\":{\"cpu_ms\":" << i->cpu << "}},\n";
+
+        threads.insert( i->thread );
+    }
+
+    for( std::set< int >::const_iterator i = threads.begin(); i != threads.end(); ++i )
+    {
+        if( i != threads.begin() )
+        {
+            os << ",\n";
+        }
+
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << *i << ",\"args\":{\"name\":\"";
+
+        if( *i == 0 )
+        {
+            os << "main";
+        }
+        else
+        {
+            os << "worker " << *i;
+        }
+
+        os << "\"}}";
+    }
+
+    os << "\n]}\n";
+}
+
+static bool slower_event( profile_event const & e1, profile_event const & e2 )
+{
+    return e1.wall > e2.wall;
+}
+
+static void output_profile_summary( std::string const & trace )
+{
+    // name -> (count, wall, cpu)
+    std::map< std::string, std::pair< int, std::pair< double, double > > > phases;
+
+    // a module can be scanned by several commands and, with --jobs, in
+    // batches on several threads; its events are summed, and the thread
+    // is -1 if they differ
+    std::map< std::string, profile_event > module_scans;
+
+    for( std::vector< profile_event >::const_iterator i = s_profile_events.begin(); i != s_profile_events.end(); ++i )
+    {
+        if( i->category == "scan" )
+        {
+            std::pair< std::map< std::string, profile_event >::iterator, bool > r = module_scans.insert( std::make_pair( i->name, *i ) );
+
+            if( !r.second )
+            {
+                profile_event & e = r.first->second;
+
+                e.wall += i->wall;
+                e.cpu += i->cpu;
+
+                if( e.thread != i->thread )
+                {
+                    e.thread = -1;
+                }
+            }
+
+            continue;
+        }
+
+        std::pair< int, std::pair< double, double > > & p = phases[ i->name ];
+
+        ++p.first;
+        p.second.first += i->wall;
+        p.second.second += i->cpu;
+    }
+
+    std::ostream & os = std::cerr;
+
+    os << "\nProfile:\n\n";
+    os << std::left << std::setw( 36 ) << "Phase" << std::right << std::setw( 8 ) << "Count" << std::setw( 12 ) << "Wall ms" << std::setw( 12 ) << "CPU ms" << "\n";
+
+    os << std::fixed << std::setprecision( 1 );
+
+    for( std::map< std::string, std::pair< int, std::pair< double, double > > >::const_iterator i = phases.begin(); i != phases.end(); ++i )
+    {
+        os << std::left << std::setw( 36 ) << i->first << std::right << std::setw( 8 ) << i->second.first << std::setw( 12 ) << i->second.second.first << std::setw( 12 ) << i->second.second.second << "\n";
+    }
+
+    std::vector< profile_event > scans;
+
+    for( std::map< std::string, profile_event >::const_iterator i = module_scans.begin(); i != module_scans.end(); ++i )
+    {
+        scans.push_back( i->second );
+    }
+
+    std::sort( scans.begin(), scans.end(), slower_event );
+
+    if( !scans.empty() )
+    {
+        os << "\n" << std::left << std::setw( 36 ) << "Slowest module scans" << std::right << std::setw( 8 ) << "Thread" << std::setw( 12 ) << "Wall ms" << std::setw( 12 ) << "CPU ms" << "\n";
+
+        for( std::size_t i = 0; i < scans.size() && i < 10; ++i )
+        {
+            os << std::left << std::setw( 36 ) << scans[ i ].name << std::right << std::setw( 8 );
+
+            if( scans[ i ].thread < 0 )
+            {
+                os << "*";
+            }
+            else
+            {
+                os << scans[ i ].thread;
+            }
+
+            os << std::setw( 12 ) << scans[ i ].wall << std::setw( 12 ) << scans[ i ].cpu << "\n";
+        }
+    }
+
+    os << "\nFiles opened: " << s_context->scan_counters_.files << "\n";
+    os << "Bytes read: " << s_context->scan_counters_.bytes << "\n";
+    os << "Includes parsed: " << s_context->scan_counters_.includes << "\n";
+    os << "Header map lookups: " << s_context->scan_counters_.lookups << " (" << s_context->scan_counters_.hits << " hits)\n";
+
+    os << std::resetiosflags( std::ios::floatfield );
+
+    if( !trace.empty() )
+    {
+        write_profile_trace( trace );
+    }
+}
+
+// --mem-stats summary
+
+static std::size_t approximate_size( std::string const & s )
+{
+    // assume that short strings are stored in the object itself
+    return sizeof( s ) + ( s.capacity() >= sizeof( s )? s.capacity() + 1: 0 );
+}
+
+template< class T > static std::size_t approximate_size( T const & )
+{
+    return sizeof( T );
+}
+
+// a tree node holds a color and three pointers besides the value
+static std::size_t const tree_node_overhead = 4 * sizeof( void* );
+
+template< class T > static std::size_t approximate_size( std::set< T > const & s )
+{
+    std::size_t r = sizeof( s );
+
+    for( typename std::set< T >::const_iterator i = s.begin(); i != s.end(); ++i )
+    {
+        r += tree_node_overhead + approximate_size( *i );
+    }
+
+    return r;
+}
+
+template< class K, class V > static std::size_t approximate_size( std::map< K, V > const & m )
+{
+    std::size_t r = sizeof( m );
+
+    for( typename std::map< K, V >::const_iterator i = m.begin(); i != m.end(); ++i )
+    {
+        r += tree_node_overhead + approximate_size( i->first ) + approximate_size( i->second );
+    }
+
+    return r;
+}
+
+static void output_structure_size( std::ostream & os, char const * name, std::size_t elements, std::size_t size )
+{
+    os << std::left << std::setw( 36 ) << name << std::right << std::setw( 12 ) << elements << std::setw( 16 ) << size << "\n";
+}
+
+static void output_mem_stats()
+{
+    // name -> (allocations, allocated, live, peak)
+    std::map< std::string, std::vector< long long > > phases;
+
+    for( std::vector< profile_event >::const_iterator i = s_profile_events.begin(); i != s_profile_events.end(); ++i )
+    {
+        if( i->thread != 0 ) continue;
+
+        std::vector< long long > & v = phases[ i->category == "scan"? std::string( "(module scans)" ): i->name ];
+
+        v.resize( 4 );
+
+        v[ 0 ] += i->allocations;
+        v[ 1 ] += i->allocated;
+        v[ 2 ] += i->live;
+        v[ 3 ] = std::max( v[ 3 ], i->peak );
+    }
+
+    std::ostream & os = std::cerr;
+
+    os << "\nMemory:\n\n";
+    os << std::left << std::setw( 36 ) << "Phase" << std::right << std::setw( 12 ) << "Allocations" << std::setw( 16 ) << "Bytes" << std::setw( 16 ) << "Live change" << std::setw( 16 ) << "Peak live" << "\n";
+
+    for( std::map< std::string, std::vector< long long > >::const_iterator i = phases.begin(); i != phases.end(); ++i )
+    {
+        os << std::left << std::setw( 36 ) << i->first << std::right << std::setw( 12 ) << i->second[ 0 ] << std::setw( 16 ) << i->second[ 1 ] << std::setw( 16 ) << i->second[ 2 ] << std::setw( 16 ) << i->second[ 3 ] << "\n";
+    }
+
+    long long allocations = s_mem_allocations, allocated = s_mem_allocated, live = s_mem_live;
+
+    os << std::left << std::setw( 36 ) << "(total)" << std::right << std::setw( 12 ) << allocations << std::setw( 16 ) << allocated << std::setw( 16 ) << live << std::setw( 16 ) << "" << "\n";
+
+    os << "\n" << std::left << std::setw( 36 ) << "Structure" << std::right << std::setw( 12 ) << "Elements" << std::setw( 16 ) << "Approx. bytes" << "\n";
+
+    output_structure_size( os, "header_map", s_context->header_map_.size(), approximate_size( s_context->header_map_ ) );
+    output_structure_size( os, "module_headers", s_context->module_headers_.size(), approximate_size( s_context->module_headers_ ) );
+    output_structure_size( os, "modules", s_context->modules_.size(), approximate_size( s_context->modules_ ) );
+    output_structure_size( os, "module_deps", s_context->module_deps_.size(), approximate_size( s_context->module_deps_ ) );
+    output_structure_size( os, "header_deps", s_context->header_deps_.size(), approximate_size( s_context->header_deps_ ) );
+    output_structure_size( os, "reverse_deps", s_context->reverse_deps_.size(), approximate_size( s_context->reverse_deps_ ) );
+    output_structure_size( os, "header_includes", s_context->header_includes_.size(), approximate_size( s_context->header_includes_ ) );
+    output_structure_size( os, "header_included_by", s_context->header_included_by_.size(), approximate_size( s_context->header_included_by_ ) );
+    output_structure_size( os, "file_sizes", s_context->file_sizes_.size(), approximate_size( s_context->file_sizes_ ) );
+    output_structure_size( os, "unguarded_files", s_context->unguarded_files_.size(), approximate_size( s_context->unguarded_files_ ) );
+
+    os << "\nPeak RSS: " << peak_rss_kb() << " KB\n";
+}
+
+// --bench
+
+// discards everything written to it
+class nullbuf: public std::streambuf
+{
+protected:
+
+    int overflow( int c )
+    {
+        return traits_type::not_eof( c );
+    }
+};
+
+struct bench_state
+{
+    // number of runs requested; 0 when not benchmarking
+    int runs_;
+
+    // reset the maps and rescan before each run
+    bool cold_;
+
+    double start_;
+    std::vector< double > times_;
+
+    // files and bytes scanned during the measured runs
+    scan_counters counters_;
+    double scan_time_;
+
+    // first s_profile_events entry of the measured runs
+    std::size_t events_;
+
+    bench_state(): runs_( 0 ), cold_( false ), start_( 0 ), scan_time_( 0 ), events_( 0 )
+    {
+    }
+};
+
+// v must be sorted; q in [0, 1]
+static double percentile( std::vector< double > const & v, double q )
+{
+    if( v.empty() ) return 0;
+
+    std::size_t k = static_cast< std::size_t >( q * ( v.size() - 1 ) + 0.5 );
+    return v[ k ];
+}
+
+static double median( std::vector< double > const & v )
+{
+    std::size_t n = v.size();
+
+    if( n == 0 ) return 0;
+
+    return n % 2? v[ n / 2 ]: ( v[ n / 2 - 1 ] + v[ n / 2 ] ) / 2;
+}
+
+static void output_bench_summary( bench_state const & bs, std::string const & commands )
+{
+    std::ostream & os = std::cout;
+
+    os << "Benchmark: " << bs.times_.size() << ( bs.cold_? " cold": " warm" ) << " run(s) of" << commands << "\n\n";
+
+    os << std::fixed << std::setprecision( 2 );
+
+    std::vector< double > times( bs.times_ );
+    std::sort( times.begin(), times.end() );
+
+    os << std::left << std::setw( 36 ) << "" << std::right << std::setw( 12 ) << "Min ms" << std::setw( 12 ) << "Median ms" << std::setw( 12 ) << "P95 ms" << "\n";
+    os << std::left << std::setw( 36 ) << "(run)" << std::right << std::setw( 12 ) << percentile( times, 0 ) << std::setw( 12 ) << median( times ) << std::setw( 12 ) << percentile( times, 0.95 ) << "\n";
+
+    // name -> (wall times, peak RSS)
+    std::map< std::string, std::pair< std::vector< double >, long > > phases;
+
+    for( std::size_t i = bs.events_; i < s_profile_events.size(); ++i )
+    {
+        profile_event const & e = s_profile_events[ i ];
+
+        if( e.thread != 0 || e.category == "scan" ) continue;
+
+        std::pair< std::vector< double >, long > & p = phases[ e.name ];
+
+        p.first.push_back( e.wall );
+        p.second = std::max( p.second, e.rss );
+    }
+
+    for( std::map< std::string, std::pair< std::vector< double >, long > >::iterator i = phases.begin(); i != phases.end(); ++i )
+    {
+        std::vector< double > & v = i->second.first;
+        std::sort( v.begin(), v.end() );
+
+        os << std::left << std::setw( 36 ) << i->first << std::right << std::setw( 12 ) << percentile( v, 0 ) << std::setw( 12 ) << median( v ) << std::setw( 12 ) << percentile( v, 0.95 ) << "    peak RSS " << i->second.second << " KB\n";
+    }
+
+    os << "\n";
+
+    if( bs.counters_.files == 0 )
+    {
+        os << "No files scanned during the measured runs.\n";
+    }
+    else
+    {
+        double seconds = bs.scan_time_ / 1000;
+
+        os << "Scanned " << bs.counters_.files << " files, " << bs.counters_.bytes << " bytes: "
+            << bs.counters_.files / seconds << " files/s, " << bs.counters_.bytes / seconds / ( 1024 * 1024 ) << " MB/s\n";
+    }
+
+    os << "Peak RSS: " << peak_rss_kb() << " KB\n";
+
+    os << std::resetiosflags( std::ios::floatfield );
+}
+
+// --shard, --merge-shards
+
+// A shard file holds the dependency maps built by scanning every N-th
+// module, along with the complete header map; one line per entry, with
+// tab-separated fields. Maps of sets have a line per element, or a line
+// with the key alone when the set is empty.
+
+static char const * const shard_magic = "boostdep-shard 1";
+
+static void write_shard_map( std::ostream & os, char const * tag, std::map< std::string, std::set< std::string > > const & m )
+{
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = m.begin(); i != m.end(); ++i )
+    {
+        if( i->second.empty() )
+        {
+            os << tag << '\t' << i->first << '\n';
+        }
+
+        for( std::set< std::string >::const_iterator j = i->second.begin(); j != i->second.end(); ++j )
+        {
+            os << tag << '\t' << i->first << '\t' << *j << '\n';
+        }
+    }
+}
+
+// scans the modules of shard i of n, module k belonging to shard k % n,
+// and writes them to fn
+static void output_shard( int shard, int shards, std::string const & fn, bool track_sources, bool track_tests )
+{
+    // a context of its own, so that the maps hold only this shard
+    context ctx( *s_context );
+
+    {
+        context_scope cs( ctx );
+
+        reset_dependency_maps();
+        ctx.file_sizes_.clear();
+        ctx.unguarded_files_.clear();
+        ctx.scan_counters_ = scan_counters();
+
+        enable_header_map();
+
+        std::vector< std::string > modules;
+
+        int k = 0;
+
+        for( std::set< std::string >::const_iterator i = ctx.modules_.begin(); i != ctx.modules_.end(); ++i, ++k )
+        {
+            if( k % shards == shard )
+            {
+                modules.push_back( *i );
+            }
+        }
+
+        {
+            profile_scope ps( "build_module_dependency_map" );
+            scan_modules( modules, track_sources, track_tests, 0 );
+        }
+
+        fs::ofstream os( root_path( fn ) );
+
+        if( !os )
+        {
+            std::cerr << "'" << fn << "': could not create file.\n";
+            return;
+        }
+
+        os << shard_magic << '\n';
+        os << "shard\t" << shard << '\t' << shards << '\n';
+        os << "options\t" << track_sources << '\t' << track_tests << '\n';
+
+        for( std::set< std::string >::const_iterator i = ctx.modules_.begin(); i != ctx.modules_.end(); ++i )
+        {
+            os << "module\t" << *i << '\n';
+        }
+
+        write_shard_map( os, "headers", ctx.module_headers_ );
+
+        for( std::map< std::string, std::string >::const_iterator i = ctx.header_map_.begin(); i != ctx.header_map_.end(); ++i )
+        {
+            os << "map\t" << i->first << '\t' << i->second << '\n';
+        }
+
+        write_shard_map( os, "deps", ctx.module_deps_ );
+        write_shard_map( os, "reverse", ctx.reverse_deps_ );
+        write_shard_map( os, "header-deps", ctx.header_deps_ );
+        write_shard_map( os, "includes", ctx.header_includes_ );
+        write_shard_map( os, "included-by", ctx.header_included_by_ );
+
+        for( std::map< std::string, file_size >::const_iterator i = ctx.file_sizes_.begin(); i != ctx.file_sizes_.end(); ++i )
+        {
+            os << "size\t" << i->first << '\t' << i->second.bytes << '\t' << i->second.lines << '\n';
+        }
+
+        for( std::set< std::string >::const_iterator i = ctx.unguarded_files_.begin(); i != ctx.unguarded_files_.end(); ++i )
+        {
+            os << "unguarded\t" << *i << '\n';
+        }
+
+        scan_counters const & c = ctx.scan_counters_;
+        os << "counters\t" << c.files << '\t' << c.bytes << '\t' << c.includes << '\t' << c.lookups << '\t' << c.hits << '\n';
+    }
+
+    s_context->scan_counters_.add( ctx.scan_counters_ );
+}
+
+struct shard_info
+{
+    int shard;
+    int shards;
+
+    std::string options;
+    std::set< std::string > modules;
+};
+
+// adds the maps in the shard file fn to the current context
+static bool read_shard( std::string const & fn, shard_info & info )
+{
+    fs::ifstream is( root_path( fn ) );
+
+    std::string line;
+
+    if( !std::getline( is, line ) || line != shard_magic )
+    {
+        std::cerr << "'" << fn << "': not a shard file.\n";
+        return false;
+    }
+
+    info.shard = -1;
+
+    for( int n = 2; std::getline( is, line ); ++n )
+    {
+        std::vector< std::string > fields;
+
+        {
+            std::istringstream ls( line );
+            std::string field;
+
+            while( std::getline( ls, field, '\t' ) )
+            {
+                fields.push_back( field );
+            }
+        }
+
+        std::string const tag = fields.empty()? std::string(): fields[ 0 ];
+        std::size_t const size = fields.size();
+
+        // a key alone adds an empty set
+        std::map< std::string, std::set< std::string > > * m =
+            tag == "headers"? &s_context->module_headers_:
+            tag == "deps"? &s_context->module_deps_:
+            tag == "reverse"? &s_context->reverse_deps_:
+            tag == "header-deps"? &s_context->header_deps_:
+            tag == "includes"? &s_context->header_includes_:
+            tag == "included-by"? &s_context->header_included_by_: 0;
+
+        if( m && ( size == 2 || size == 3 ) )
+        {
+            std::set< std::string > & s = ( *m )[ fields[ 1 ] ];
+
+            if( size == 3 ) s.insert( fields[ 2 ] );
+        }
+        else if( tag == "module" && size == 2 )
+        {
+            info.modules.insert( fields[ 1 ] );
+            s_context->modules_.insert( fields[ 1 ] );
+        }
+        else if( tag == "map" && size == 3 )
+        {
+            s_context->header_map_[ fields[ 1 ] ] = fields[ 2 ];
+        }
+        else if( tag == "size" && size == 4 )
+        {
+            file_size & sz = s_context->file_sizes_[ fields[ 1 ] ];
+
+            sz.bytes = std::strtoul( fields[ 2 ].c_str(), 0, 10 );
+            sz.lines = std::strtoul( fields[ 3 ].c_str(), 0, 10 );
+        }
+        else if( tag == "unguarded" && size == 2 )
+        {
+            s_context->unguarded_files_.insert( fields[ 1 ] );
+        }
+        else if( tag == "counters" && size == 6 )
+        {
+            scan_counters c;
+
+            c.files = std::strtoul( fields[ 1 ].c_str(), 0, 10 );
+            c.bytes = std::strtoul( fields[ 2 ].c_str(), 0, 10 );
+            c.includes = std::strtoul( fields[ 3 ].c_str(), 0, 10 );
+            c.lookups = std::strtoul( fields[ 4 ].c_str(), 0, 10 );
+            c.hits = std::strtoul( fields[ 5 ].c_str(), 0, 10 );
+
+            s_context->scan_counters_.add( c );
+        }
+        else if( tag == "shard" && size == 3 )
+        {
+            info.shard = std::atoi( fields[ 1 ].c_str() );
+            info.shards = std::atoi( fields[ 2 ].c_str() );
+        }
+        else if( tag == "options" && size == 3 )
+        {
+            info.options = fields[ 1 ] + fields[ 2 ];
+        }
+        else
+        {
+            std::cerr << fn << "(" << n << "): unrecognized line.\n";
+            return false;
+        }
+    }
+
+    if( info.shard < 0 || info.shard >= info.shards )
+    {
+        std::cerr << "'" << fn << "': missing shard number.\n";
+        return false;
+    }
+
+    return true;
+}
+
+// replaces the dependency maps with the union of the shards in files,
+// which must be the shards 0 to N-1 of the same tree and options
+static bool merge_shards( std::vector< std::string > const & files )
+{
+    profile_scope ps( "merge_shards" );
+
+    reset_dependency_maps();
+    s_context->file_sizes_.clear();
+    s_context->unguarded_files_.clear();
+
+    std::vector< shard_info > shards;
+
+    for( std::vector< std::string >::const_iterator i = files.begin(); i != files.end(); ++i )
+    {
+        shard_info info;
+
+        if( !read_shard( *i, info ) )
+        {
+            reset_dependency_maps();
+            return false;
+        }
+
+        shards.push_back( info );
+    }
+
+    std::set< int > seen;
+
+    for( std::size_t i = 0; i < shards.size(); ++i )
+    {
+        shard_info const & s = shards[ i ];
+        shard_info const & s0 = shards[ 0 ];
+
+        char const * error =
+            s.shards != s0.shards? "was written with a different shard count":
+            s.options != s0.options? "was written with different --track-sources or --track-tests options":
+            s.modules != s0.modules? "was written for a different set of modules":
+            !seen.insert( s.shard ).second? "repeats a shard": 0;
+
+        if( error )
+        {
+            std::cerr << "'" << files[ i ] << "' " << error << ".\n";
+
+            reset_dependency_maps();
+            return false;
+        }
+    }
+
+    if( shards.empty() || static_cast< int >( seen.size() ) != shards[ 0 ].shards )
+    {
+        std::cerr << "boostdep: --merge-shards needs all " << ( shards.empty()? 0: shards[ 0 ].shards ) << " shards.\n";
+
+        reset_dependency_maps();
+        return false;
+    }
+
+    s_context->header_map_complete_ = true;
+    s_context->complete_ = true;
+
+    return true;
+}
+
+// --overlay-root
+
+// adds the modules of dir, a tree outside the Boost root: dir itself when
+// it has an include directory, else each of its subdirectories that has
+// one. The modules are scanned at once when the others have already been
+// scanned, as after --merge-shards, or else along with them.
+static void add_overlay_root( std::string const & dir, bool scan, bool track_sources, bool track_tests )
+{
+    if( !fs::is_directory( root_path( dir ) ) )
+    {
+        std::cerr << "'" << dir << "': not a directory.\n";
+        return;
+    }
+
+    enable_header_map();
+
+    fs::path const root = fs::canonical( root_path( dir ) );
+
+    std::map< std::string, fs::path > candidates;
+
+    if( fs::exists( root / "include" ) )
+    {
+        candidates[ root.filename().string() ] = root;
+    }
+    else
+    {
+        fs::directory_iterator it( root ), last;
+
+        for( ; it != last; ++it )
+        {
+            if( it->status().type() == fs::directory_file && fs::exists( it->path() / "include" ) )
+            {
+                candidates[ it->path().filename().string() ] = it->path();
+            }
+        }
+    }
+
+    std::vector< std::string > modules;
+
+    for( std::map< std::string, fs::path >::const_iterator i = candidates.begin(); i != candidates.end(); ++i )
+    {
+        if( s_context->modules_.count( i->first ) )
+        {
+            std::cerr << "'" << i->second.string() << "': module '" << i->first << "' already exists; skipped.\n";
+            continue;
+        }
+
+        s_context->module_dirs_[ i->first ] = i->second;
+        map_module_headers( i->first );
+
+        modules.push_back( i->first );
+    }
+
+    if( scan )
+    {
+        profile_scope ps( "build_module_dependency_map" );
+        scan_modules( modules, track_sources, track_tests, 0 );
+    }
+}
+
+// --history
+
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+static void output_history_csv( std::vector< history_entry > const & entries )
+{
+    std::cout << "revision,commit,time,module,level,weight\n";
+
+    for( std::vector< history_entry >::const_iterator i = entries.begin(); i != entries.end(); ++i )
+    {
+        if( !i->error.empty() ) continue;
+
+        for( std::map< std::string, int >::const_iterator j = i->weights.begin(); j != i->weights.end(); ++j )
+        {
+            std::map< std::string, int >::const_iterator k = i->levels.find( j->first );
+
+            std::cout << i->revision << ',' << git_hex( i->commit.id ) << ',' << i->commit.time << ',' << j->first << ',';
+
+            // levels that cannot be computed due to cycles are left empty
+            if( k != i->levels.end() && k->second < unknown_level )
+            {
+                std::cout << k->second;
+            }
+
+            std::cout << ',' << j->second << '\n';
+        }
+    }
+}
+
+static void output_history_json( std::vector< history_entry > const & entries )
+{
+    std::cout << "[\n";
+
+    bool first = true;
+
+    for( std::vector< history_entry >::const_iterator i = entries.begin(); i != entries.end(); ++i )
+    {
+        if( !i->error.empty() ) continue;
+
+        std::cout << ( first? "": ",\n" ) << "{\"revision\":";
+        output_json_string( std::cout, i->revision );
+        std::cout << ",\"commit\":\"" << git_hex( i->commit.id ) << "\",\"time\":" << i->commit.time << ",\"modules\":{";
+
+        first = false;
+
+        for( std::map< std::string, int >::const_iterator j = i->weights.begin(); j != i->weights.end(); ++j )
+        {
+            std::map< std::string, int >::const_iterator k = i->levels.find( j->first );
+
+            std::cout << ( j == i->weights.begin()? "": "," );
+            output_json_string( std::cout, j->first );
+            std::cout << ":{\"level\":";
+
+            if( k != i->levels.end() && k->second < unknown_level )
+            {
+                std::cout << k->second;
+            }
+            else
+            {
+                std::cout << "null";
+            }
+
+            std::cout << ",\"weight\":" << j->second << "}";
+        }
+
+        std::cout << "}}";
+    }
+
+    std::cout << "\n]\n";
+}
+
+static void output_history_report( std::string const & revisions, bool json, bool track_sources, bool track_tests )
+{
+    std::vector< history_entry > entries;
+
+    if( !compute_history( s_context->root_, revisions, track_sources, track_tests, entries ) ) return;
+
+    for( std::vector< history_entry >::const_iterator i = entries.begin(); i != entries.end(); ++i )
+    {
+        if( !i->error.empty() )
+        {
+            std::cerr << i->error << "\n";
+        }
+
+        s_context->scan_counters_.add( i->counters );
+    }
+
+    if( json )
+    {
+        output_history_json( entries );
+    }
+    else
+    {
+        output_history_csv( entries );
+    }
+}
+
+#endif // defined(BOOSTDEP_HAS_ZLIB)
+
+// main
+
+// options that work without walking all modules
+static bool is_header_map_optional( std::string const & option )
+{
+    static char const * const options[] =
+    {
+        "--boost-root", "--mem-stats", "--title", "--html-title", "--footer", "--html-footer", "--html-stylesheet", "--html-prefix", "--html",
+        "--track-sources", "--no-track-sources", "--track-tests", "--no-track-tests", "--why-paths", "--pch-budget", "--jobs", "-j", "--reader", "--use-git-index", "--git-rev", "--history", "--history-format",
+        "--shard", "--merge-shards", "--overlay-root", "--config", "--use-config", "--preprocess",
+        "--primary", "--subset", "--subset-for", "--cmake", "--pkgconfig",
+        "--capture-output", "--compare-output", "--bench", "--bench-cold",
+    };
+
+    for( std::size_t i = 0; i < sizeof( options ) / sizeof( options[ 0 ] ); ++i )
+    {
+        if( option == options[ i ] ) return true;
+    }
+
+    if( option == "--profile" || option.compare( 0, 10, "--profile=" ) == 0 )
+    {
+        return true;
+    }
+
+    // a module name, for the primary report
+    return is_module( option );
+}
+
+int main( int argc, char const* argv[] )
+{
+#if defined(__linux__)
+
+    if( argc > 3 && std::strcmp( argv[ 1 ], "--exec-maxrss" ) == 0 )
+    {
+        return exec_maxrss( argv[ 2 ], const_cast< char** >( argv + 3 ) );
+    }
+
+#endif
+
+    if( argc < 2 )
+    {
+        std::cout <<
+
+            "Usage:\n"
+            "\n"
+            "    boostdep --list-modules\n"
+            "    boostdep --list-buildable\n"
+            "    boostdep [--track-sources] [--track-tests] --list-dependencies\n"
+            "    boostdep --list-exceptions\n"
+            "    boostdep --list-missing-headers\n"
+            "    boostdep --list-buildable-dependencies\n"
+            "\n"
+            "    boostdep [options] --module-overview\n"
+            "    boostdep [options] --module-levels\n"
+            "    boostdep [options] --module-weights\n"
+            "    boostdep [options] --header-cost\n"
+            "    boostdep [options] --redundant-includes\n"
+            "    boostdep [options] [--pch-budget <bytes>] --pch-candidates [--for <directory>]\n"
+            "    boostdep [options] --profile-headers <module>|<header>|all\n"
+            "\n"
+            "    boostdep [options] [--primary] <module>\n"
+            "    boostdep [options] --secondary <module>\n"
+            "    boostdep [options] --reverse <module>\n"
+            "    boostdep [options] --subset <module>\n"
+            "    boostdep [options] [--header] <header>\n"
+            "    boostdep --test <module>\n"
+            "    boostdep --cmake <module>\n"
+            "    boostdep --pkgconfig <module> <version> [<var>=<value>] [<var>=<value>]...\n"
+            "    boostdep [options] --subset-for <directory>\n"
+            "    boostdep [options] [--why-paths <count>] --why <module-or-header> <module-or-header>\n"
+            "    boostdep [options] --what-if <file>\n"
+            "    boostdep [options] --history <revision>[,<revision>...]|<from>..<to>|@<file>\n"
+            "    boostdep [options] --shard <i>/<n> <file>\n"
+            "    boostdep [options] --merge-shards <file>... <commands>...\n"
+            "\n"
+            "    boostdep [options] --watch <commands>...\n"
+            "    boostdep [options] --bench <n> <commands>...\n"
+            "\n"
+            "    [options]: [--boost-root <path-to-boost>]\n"
+            "               [--[no-]track-sources] [--[no-]track-tests]\n"
+            "               [--html-title <title>] [--html-footer <footer>]\n"
+            "               [--html-stylesheet <stylesheet>] [--html-prefix <prefix>]\n"
+            "               [--html]\n"
+            "               [--jobs <n>] [--reader stream|pread|io_uring] [--use-git-index]\n"
+            "               [--git-rev <revision>] [--history-format csv|json]\n"
+            "               [--overlay-root <directory>]\n"
+            "               [--config <name> <macros-file>] [--use-config <name>|all]\n"
+            "               [--preprocess]\n"
+            "               [--profile[=<trace.json>]] [--mem-stats]\n"
+            "               [--bench <n>|--bench-cold <n>]\n";
+
+        return -1;
+    }
+
+    context ctx;
+    context_scope cs( ctx );
+
+    bool root_set = false;
+
+    std::string profile_trace;
+
+    // with --git-rev or --history, the root may also be a bare repository
+    std::string git_rev;
+    bool git_root = false;
+
+    for( int i = 1; i + 1 < argc; ++i )
+    {
+        std::string option = argv[ i ];
+
+        if( option == "--git-rev" )
+        {
+            git_rev = argv[ ++i ];
+            git_root = true;
+        }
+        else if( option == "--history" )
+        {
+            git_root = true;
+        }
+    }
+
+    for( int i = 0; i < argc; ++i )
+    {
+        std::string option = argv[ i ];
+
+        if( option == "--profile" || option.compare( 0, 10, "--profile=" ) == 0 )
+        {
+            s_profile = true;
+            s_profile_start = wall_time_ms();
+
+            if( option.size() > 10 )
+            {
+                profile_trace = option.substr( 10 );
+            }
+        }
+        else if( option == "--mem-stats" )
+        {
+            s_mem_stats = true;
+            s_profile_start = wall_time_ms();
+        }
+        else if( option == "--bench" || option == "--bench-cold" )
+        {
+            s_bench = true;
+            s_profile_start = wall_time_ms();
+        }
+        else if( option == "--boost-root" )
+        {
+            if( i + 1 < argc )
+            {
+                fs::path p( argv[ ++i ] );
+
+                if( is_boost_root( p ) || ( git_root && fs::is_directory( p ) ) )
+                {
+                    ctx.root_ = fs::absolute( p );
+                    root_set = true;
+                }
+                else
+                {
+                    std::cerr << "'" << p.string() << "': not a valid Boost root.\n";
+                    return -2;
+                }
+            }
+            else
+            {
+                std::cerr << "'" << option << "': missing argument.\n";
+                return -2;
+            }
+        }
+    }
+
+    if( !root_set && !find_boost_root( ctx.root_ ) )
+    {
+        char const * env_root = std::getenv( "BOOST_ROOT" );
+
+        if( env_root && is_boost_root( env_root ) )
+        {
+            ctx.root_ = fs::absolute( env_root );
+        }
+        else
+        {
+            std::cerr << "boostdep: Could not find Boost root.\n";
+            return -2;
+        }
+    }
+
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+    git_revision_root grr;
+
+    if( !git_rev.empty() )
+    {
+        ctx.git_ = grr.open( ctx.root_, git_rev );
+
+        if( ctx.git_ == 0 ) return -2;
+    }
+
+#else
+
+    if( !git_rev.empty() )
+    {
+        std::cerr << "boostdep: --git-rev requires zlib.\n";
+        return -2;
+    }
+
+#endif
+
+    bool html = false;
+    bool secondary = false;
+    bool track_sources = false;
+    bool track_tests = false;
+    bool history_json = false;
+
+    int why_paths = 1;
+
+    // bytes of headers in a precompiled header
+    unsigned long long pch_budget = 4 * 1024 * 1024;
+
+    std::string html_title = "Boost Dependency Report";
+    std::string html_footer;
+    std::string html_stylesheet;
+    std::string html_prefix;
+
+    std::ostringstream captured_output;
+    teebuf tsb( std::cout.rdbuf(), captured_output.rdbuf() );
+
+    save_cout_rdbuf scrdb;
+
+    int first = 1;
+    bool watch = false;
+
+    bench_state bench;
+    std::string bench_commands;
+
+    nullbuf nsb;
+
+    for( ;; )
+    {
+        for( int i = first; i < argc; ++i )
+        {
+            std::string option = argv[ i ];
+
+            profile_scope ps( option, "command" );
+
+            // most commands need the headers of all modules; the rest
+            // resolve headers on demand
+            if( s_context->git_ || !is_header_map_optional( option ) )
+            {
+                enable_header_map();
+            }
+
+            if( option == "--boost-root" || option == "--git-rev" )
+            {
+                ++i;
+            }
+            else if( option == "--profile" || option.compare( 0, 10, "--profile=" ) == 0 || option == "--mem-stats" )
+            {
+            }
+            else if( option == "--list-modules" )
+            {
+                list_modules();
+            }
+            else if( option == "--list-buildable" )
+            {
+                list_buildable();
+            }
+            else if( option == "--title" || option == "--html-title" )
+            {
+                if( i + 1 < argc )
+                {
+                    html_title = argv[ ++i ];
+                }
+            }
+            else if( option == "--footer" || option == "--html-footer" )
+            {
+                if( i + 1 < argc )
+                {
+                    html_footer = argv[ ++i ];
+                }
+            }
+            else if( option == "--html-stylesheet" )
+            {
+                if( i + 1 < argc )
+                {
+                    html_stylesheet = argv[ ++i ];
+                }
+            }
+            else if( option == "--html-prefix" )
+            {
+                if( i + 1 < argc )
+                {
+                    html_prefix = argv[ ++i ];
+                }
+            }
+            else if( option == "--html" )
+            {
+                if( !html )
+                {
+                    html = true;
+                    output_html_header( html_title, html_stylesheet, html_prefix );
+                }
+            }
+            else if( option == "--track-sources" )
+            {
+                track_sources = true;
+            }
+            else if( option == "--no-track-sources" )
+            {
+                track_sources = false;
+            }
+            else if( option == "--track-tests" )
+            {
+                track_tests = true;
+            }
+            else if( option == "--no-track-tests" )
+            {
+                track_tests = false;
+            }
+            else if( option == "--primary" )
+            {
+                if( i + 1 < argc )
+                {
+                    output_module_primary_report( argv[ ++i ], html, track_sources, track_tests );
+                }
+            }
+            else if( option == "--secondary" )
+            {
+                if( i + 1 < argc )
+                {
+                    enable_secondary( secondary, track_sources, track_tests );
+                    output_module_secondary_report( argv[ ++i ], html );
+                }
+            }
+            else if( option == "--reverse" )
+            {
+                if( i + 1 < argc )
+                {
+                    enable_secondary( secondary, track_sources, track_tests );
+                    output_module_reverse_report( argv[ ++i ], html );
+                }
+            }
+            else if( option == "--header" )
+            {
+                if( i + 1 < argc )
+                {
+                    enable_secondary( secondary, track_sources, track_tests );
+                    output_header_report( argv[ ++i ], html );
+                }
+            }
+            else if( option == "--subset" )
+            {
+                if( i + 1 < argc )
+                {
+                    output_module_subset_report( argv[ ++i ], track_sources, track_tests, html );
+                }
+            }
+            else if( option == "--why-paths" )
+            {
+                if( i + 1 < argc )
+                {
+                    char const * value = argv[ ++i ];
+
+                    char * end;
+                    long n = std::strtol( value, &end, 10 );
+
+                    if( end == value || *end != 0 || n < 1 || n > INT_MAX )
+                    {
+                        std::cerr << "'" << value << "': --why-paths needs a positive number.\n";
+                        return -2;
+                    }
+
+                    why_paths = static_cast< int >( n );
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                    return -2;
+                }
+            }
+            else if( option == "--why" )
+            {
+                if( i + 2 < argc )
+                {
+                    std::string from = argv[ ++i ];
+                    std::string to = argv[ ++i ];
+
+                    enable_header_map();
+
+                    // the includes of the files reachable from 'from' are
+                    // enough, unless an endpoint is a source or test file,
+                    // which only the full scan knows, or the includes have
+                    // to be those of a configuration
+                    bool const lazy = s_context->active_config_ < 0 && !s_context->preprocess_ &&
+                        ( s_context->modules_.count( from ) || s_context->header_map_.count( from ) ) &&
+                        ( s_context->modules_.count( to ) || s_context->header_map_.count( to ) );
+
+                    if( !lazy )
+                    {
+                        enable_secondary( secondary, track_sources, track_tests );
+                    }
+
+                    if( !s_context->modules_.count( from ) && !is_known_header( from ) )
+                    {
+                        std::cerr << "'" << from << "': not a module or header.\n";
+                    }
+                    else if( !s_context->modules_.count( to ) && !is_known_header( to ) )
+                    {
+                        std::cerr << "'" << to << "': not a module or header.\n";
+                    }
+                    else
+                    {
+                        output_why_report( from, to, why_paths, track_sources, track_tests, html );
+                    }
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
+            }
+            else if( option == "--test" )
+            {
+                if( i + 1 < argc )
+                {
+                    output_module_test_report( argv[ ++i ] );
+                }
+            }
+            else if( option == "--cmake" )
+            {
+                if( i + 1 < argc )
+                {
+                    output_module_cmake_report( argv[ ++i ] );
+                }
+            }
+            else if( option == "--module-levels" )
+            {
+                enable_secondary( secondary, track_sources, track_tests );
+                output_module_level_report( html );
+            }
+            else if( option == "--module-overview" )
+            {
+                output_module_overview_report( html, secondary, track_sources, track_tests );
+            }
+            else if( option == "--module-weights" )
+            {
+                enable_secondary( secondary, track_sources, track_tests );
+                output_module_weight_report( html );
+            }
+            else if( option == "--header-cost" )
+            {
+                enable_secondary( secondary, track_sources, track_tests );
+                output_header_cost_report( html );
+            }
+            else if( option == "--redundant-includes" )
+            {
+                enable_secondary( secondary, track_sources, track_tests );
+                output_redundant_include_report( html );
+            }
+            else if( option == "--pch-budget" )
+            {
+                if( i + 1 < argc )
+                {
+                    char const * value = argv[ ++i ];
+
+                    char * end;
+                    unsigned long long n = std::strtoull( value, &end, 10 );
+
+                    if( end == value || *end != 0 || *value == '-' || n == 0 )
+                    {
+                        std::cerr << "'" << value << "': --pch-budget needs a positive number of bytes.\n";
+                        return -2;
+                    }
+
+                    pch_budget = n;
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                    return -2;
+                }
+            }
+            else if( option == "--pch-candidates" )
+            {
+                std::string dir;
+
+                if( i + 2 < argc && std::strcmp( argv[ i + 1 ], "--for" ) == 0 )
+                {
+                    dir = argv[ i + 2 ];
+                    i += 2;
+                }
+
+                enable_secondary( secondary, track_sources, track_tests );
+                output_pch_candidate_report( dir, pch_budget, html );
             }
-        }
-        else if( option == "--html-stylesheet" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--jobs" || option == "-j" )
             {
-                html_stylesheet = argv[ ++i ];
+                if( i + 1 < argc )
+                {
+                    s_context->jobs_ = std::atoi( argv[ ++i ] );
+                }
             }
-        }
-        else if( option == "--html-prefix" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--use-git-index" )
             {
-                html_prefix = argv[ ++i ];
+                s_context->use_git_index_ = true;
             }
-        }
-        else if( option == "--html" )
-        {
-            if( !html )
+            else if( option == "--reader" )
             {
-                html = true;
-                output_html_header( html_title, html_stylesheet, html_prefix );
+                if( i + 1 < argc )
+                {
+                    std::string reader = argv[ ++i ];
+
+                    if( reader == "stream" )
+                    {
+                        s_context->reader_ = reader_stream;
+                    }
+                    else if( reader == "pread" )
+                    {
+                        s_context->reader_ = reader_pread;
+                    }
+                    else if( reader == "io_uring" )
+                    {
+                        s_context->reader_ = reader_io_uring;
+                    }
+                    else
+                    {
+                        std::cerr << "'" << reader << "': unknown reader; use stream, pread or io_uring.\n";
+                    }
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
             }
-        }
-        else if( option == "--track-sources" )
-        {
-            track_sources = true;
-        }
-        else if( option == "--no-track-sources" )
-        {
-            track_sources = false;
-        }
-        else if( option == "--track-tests" )
-        {
-            track_tests = true;
-        }
-        else if( option == "--no-track-tests" )
-        {
-            track_tests = false;
-        }
-        else if( option == "--primary" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--profile-headers" )
             {
-                output_module_primary_report( argv[ ++i ], html, track_sources, track_tests );
+                if( i + 1 < argc )
+                {
+                    enable_secondary( secondary, track_sources, track_tests );
+                    output_profile_headers_report( argv[ ++i ], s_context->jobs_, html );
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
             }
-        }
-        else if( option == "--secondary" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--list-dependencies" )
             {
-                enable_secondary( secondary, track_sources, track_tests );
-                output_module_secondary_report( argv[ ++i ], html );
+                list_dependencies( secondary, track_sources, track_tests );
             }
-        }
-        else if( option == "--reverse" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--list-exceptions" )
             {
-                enable_secondary( secondary, track_sources, track_tests );
-                output_module_reverse_report( argv[ ++i ], html );
+                list_exceptions();
             }
-        }
-        else if( option == "--header" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--list-missing-headers" )
             {
-                enable_secondary( secondary, track_sources, track_tests );
-                output_header_report( argv[ ++i ], html );
+                list_missing_headers();
             }
-        }
-        else if( option == "--subset" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--pkgconfig" )
             {
-                enable_secondary( secondary, track_sources, track_tests );
-                output_module_subset_report( argv[ ++i ], track_sources, track_tests, html );
+                if( i + 2 < argc )
+                {
+                    std::string module = argv[ ++i ];
+                    std::string version = argv[ ++i ];
+
+                    ++i;
+
+                    output_pkgconfig( module, version, argc - i, argv + i );
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing module or version.\n";
+                }
+
+                break;
             }
-        }
-        else if( option == "--test" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--subset-for" )
             {
-                output_module_test_report( argv[ ++i ] );
+                if( i + 1 < argc )
+                {
+                    std::string module = argv[ ++i ];
+
+                    std::set<std::string> headers;
+                    add_module_headers( module, headers );
+
+                    output_directory_subset_report( module, headers, html );
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
+
+                break;
             }
-        }
-        else if( option == "--cmake" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--what-if" )
             {
-                output_module_cmake_report( argv[ ++i ] );
+                if( i + 1 < argc )
+                {
+                    enable_secondary( secondary, track_sources, track_tests );
+                    output_what_if_report( argv[ ++i ], track_sources, track_tests, html );
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
             }
-        }
-        else if( option == "--module-levels" )
-        {
-            enable_secondary( secondary, track_sources, track_tests );
-            output_module_level_report( html );
-        }
-        else if( option == "--module-overview" )
-        {
-            enable_secondary( secondary, track_sources, track_tests );
-            output_module_overview_report( html );
-        }
-        else if( option == "--module-weights" )
-        {
-            enable_secondary( secondary, track_sources, track_tests );
-            output_module_weight_report( html );
-        }
-        else if( option == "--list-dependencies" )
-        {
-            enable_secondary( secondary, track_sources, track_tests );
-            list_dependencies();
-        }
-        else if( option == "--list-exceptions" )
-        {
-            list_exceptions();
-        }
-        else if( option == "--list-missing-headers" )
-        {
-            list_missing_headers();
-        }
-        else if( option == "--pkgconfig" )
-        {
-            if( i + 2 < argc )
+            else if( option == "--shard" )
             {
-                std::string module = argv[ ++i ];
-                std::string version = argv[ ++i ];
+                if( i + 2 < argc )
+                {
+                    int shard = -1, shards = 0;
+                    char slash = 0;
 
-                ++i;
+                    std::istringstream is( argv[ ++i ] );
+                    is >> shard >> slash >> shards;
+
+                    std::string fn = argv[ ++i ];
 
-                output_pkgconfig( module, version, argc - i, argv + i );
+                    if( !is || slash != '/' || shard < 0 || shard >= shards )
+                    {
+                        std::cerr << "'" << argv[ i - 1 ] << "': expected <i>/<n>, with 0 <= i < n.\n";
+                    }
+                    else
+                    {
+                        output_shard( shard, shards, fn, track_sources, track_tests );
+                    }
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
             }
-            else
+            else if( option == "--overlay-root" )
             {
-                std::cerr << "'" << option << "': missing module or version.\n";
+                if( i + 1 < argc )
+                {
+                    add_overlay_root( argv[ ++i ], secondary, track_sources, track_tests );
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
             }
-
-            break;
-        }
-        else if( option == "--subset-for" )
-        {
-            if( i + 1 < argc )
+            else if( option == "--config" )
             {
-                std::string module = argv[ ++i ];
+                if( i + 2 < argc )
+                {
+                    std::string name = argv[ ++i ];
+                    add_configuration( name, argv[ ++i ] );
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
+            }
+            else if( option == "--use-config" )
+            {
+                if( i + 1 < argc )
+                {
+                    std::string name = argv[ ++i ];
+                    int k = -1;
 
-                enable_secondary( secondary, track_sources, track_tests );
+                    for( std::size_t j = 0; j < s_context->configs_.size(); ++j )
+                    {
+                        if( s_context->configs_[ j ].name == name ) k = static_cast< int >( j );
+                    }
 
-                std::set<std::string> headers;
-                add_module_headers( module, headers );
+                    if( k < 0 && name != "all" )
+                    {
+                        std::cerr << "'" << name << "': no such configuration.\n";
+                    }
+                    else
+                    {
+                        // the reports that follow use the maps of configuration k
+                        secondary = use_configuration( k );
+                    }
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
+            }
+            else if( option == "--preprocess" )
+            {
+                s_context->preprocess_ = true;
 
-                output_directory_subset_report( module, headers, html );
+                // the reports that follow rescan the modules
+                secondary = use_configuration( s_context->active_config_ );
             }
-            else
+            else if( option == "--merge-shards" )
             {
-                std::cerr << "'" << option << "': missing argument.\n";
+                std::vector< std::string > files;
+
+                for( ; i + 1 < argc && argv[ i + 1 ][ 0 ] != '-'; ++i )
+                {
+                    files.push_back( argv[ i + 1 ] );
+                }
+
+                // the reports that follow use the merged maps
+                secondary = merge_shards( files );
             }
+            else if( option == "--history-format" )
+            {
+                if( i + 1 < argc )
+                {
+                    std::string format = argv[ ++i ];
 
-            break;
-        }
-        else if( option == "--list-buildable-dependencies" )
-        {
-            enable_secondary( secondary, true, false );
-            list_buildable_dependencies();
-        }
-        else if( option == "--capture-output" )
-        {
-            std::cout.rdbuf( &tsb );
-        }
-        else if( option == "--compare-output" )
-        {
-            if( i + 1 < argc )
+                    if( format == "csv" || format == "json" )
+                    {
+                        history_json = format == "json";
+                    }
+                    else
+                    {
+                        std::cerr << "'" << format << "': unknown history format; use csv or json.\n";
+                    }
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
+            }
+            else if( option == "--history" )
             {
-                std::string fn = argv[ ++i ];
-                std::fstream is( fn.c_str() );
+                if( i + 1 < argc )
+                {
+#if defined(BOOSTDEP_HAS_ZLIB)
+                    output_history_report( argv[ ++i ], history_json, track_sources, track_tests );
+#else
+                    ++i;
+                    (void)history_json;
+                    std::cerr << "boostdep: --history requires zlib.\n";
+#endif
+                }
+                else
+                {
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
+            }
+            else if( option == "--bench" || option == "--bench-cold" )
+            {
+                if( bench.runs_ == 0 && !watch && i + 1 < argc )
+                {
+                    bench.runs_ = std::max( std::atoi( argv[ ++i ] ), 1 );
+                    bench.cold_ = option == "--bench-cold";
 
-                if( !is )
+                    first = i + 1;
+
+                    for( int j = first; j < argc; ++j )
+                    {
+                        bench_commands += ' ';
+                        bench_commands += argv[ j ];
+                    }
+
+                    // start the runs from the outer loop
+                    break;
+                }
+                else if( bench.runs_ == 0 && !watch )
                 {
-                    std::cerr << option << " '" << fn << "': could not open file.\n";
-                    return 1;
+                    std::cerr << "'" << option << "': missing argument.\n";
+                }
+            }
+            else if( option == "--watch" )
+            {
+                if( !watch && bench.runs_ == 0 )
+                {
+                    enable_secondary( secondary, track_sources, track_tests );
+
+                    if( start_watch( track_sources, track_tests ) )
+                    {
+                        watch = true;
+                        first = i + 1;
+                    }
                 }
+            }
+            else if( option == "--list-buildable-dependencies" )
+            {
+                list_buildable_dependencies( secondary );
+            }
+            else if( option == "--capture-output" )
+            {
+                std::cout.rdbuf( &tsb );
+            }
+            else if( option == "--compare-output" )
+            {
+                if( i + 1 < argc )
+                {
+                    std::string fn = argv[ ++i ];
+                    fs::ifstream is( root_path( fn ) );
+
+                    if( !is )
+                    {
+                        std::cerr << option << " '" << fn << "': could not open file.\n";
+                        return 1;
+                    }
+
+                    std::istreambuf_iterator<char> first( is ), last;
+                    std::string fc( first, last );
 
-                std::istreambuf_iterator<char> first( is ), last;
-                std::string fc( first, last );
+                    if( fc != captured_output.str() )
+                    {
+                        std::cerr << option << " '" << fn << "': output does not match; expected output:\n---\n" << fc << "---\n";
+                        return 1;
+                    }
 
-                if( fc != captured_output.str() )
+                    std::cerr << option << " '" << fn << "': output matches.\n";
+                    captured_output.str( "" );
+                }
+                else
                 {
-                    std::cerr << option << " '" << fn << "': output does not match; expected output:\n---\n" << fc << "---\n";
+                    std::cerr << "'" << option << "': missing argument.\n";
                     return 1;
                 }
-
-                std::cerr << option << " '" << fn << "': output matches.\n";
-                captured_output.str( "" );
+            }
+            else if( is_module( option ) )
+            {
+                output_module_primary_report( option, html, track_sources, track_tests );
+            }
+            else if( s_context->header_map_.count( option ) )
+            {
+                enable_secondary( secondary, track_sources, track_tests );
+                output_header_report( option, html );
             }
             else
             {
-                std::cerr << "'" << option << "': missing argument.\n";
-                return 1;
+                std::cerr << "'" << option << "': not an option, module or header.\n";
             }
         }
-        else if( s_modules.count( option ) )
+
+        if( bench.runs_ > 0 )
         {
-            output_module_primary_report( option, html, track_sources, track_tests );
+            if( bench.start_ != 0 )
+            {
+                double t = wall_time_ms() - bench.start_;
+
+                bench.times_.push_back( t );
+
+                if( s_context->scan_counters_.files != bench.counters_.files )
+                {
+                    bench.scan_time_ += t;
+                }
+
+                bench.counters_ = s_context->scan_counters_;
+            }
+            else
+            {
+                // output of the measured runs is discarded
+                std::cout << std::flush;
+                std::cout.rdbuf( &nsb );
+
+                bench.events_ = s_profile_events.size();
+                s_context->scan_counters_ = scan_counters();
+            }
+
+            if( static_cast< int >( bench.times_.size() ) < bench.runs_ )
+            {
+                if( bench.cold_ )
+                {
+                    reset_dependency_maps();
+                    s_context->file_sizes_.clear();
+                    s_context->unguarded_files_.clear();
+
+                    secondary = false;
+                }
+
+                bench.start_ = wall_time_ms();
+
+                continue;
+            }
+
+            std::cout.rdbuf( scrdb.rdbuf() );
+            output_bench_summary( bench, bench_commands );
+
+            break;
         }
-        else if( s_header_map.count( option ) )
+
+        if( !watch )
         {
-            enable_secondary( secondary, track_sources, track_tests );
-            output_header_report( option, html );
+            break;
         }
-        else
+
+        std::cout << std::flush;
+
+        if( !wait_for_changes( secondary, track_sources, track_tests ) )
         {
-            std::cerr << "'" << option << "': not an option, module or header.\n";
+            break;
         }
     }
 
@@ -2811,4 +6280,14 @@ int main( int argc, char const* argv[] )
     {
         output_html_footer( html_footer );
     }
+
+    if( s_profile )
+    {
+        output_profile_summary( profile_trace );
+    }
+
+    if( s_mem_stats )
+    {
+        output_mem_stats();
+    }
 }
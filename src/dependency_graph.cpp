@@ -0,0 +1,227 @@
+// dependency_graph.cpp - the library interface of boostdep
+//
+// Copyright 2026 agent
+//
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt
+
+#include <boostdep/dependency_graph.hpp>
+#include "dependency_scan.hpp"
+#include <stdexcept>
+
+namespace boostdep
+{
+
+struct dependency_graph::impl
+{
+    context context_;
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+    // the algorithms may add empty entries to the maps, so queries
+    // on the same graph are serialized
+    std::mutex mutex_;
+
+#endif
+};
+
+// makes the context of a graph current for the duration of a query
+class graph_scope
+{
+private:
+
+#if defined(BOOSTDEP_HAS_THREADS)
+    std::lock_guard< std::mutex > lock_;
+#endif
+
+    context_scope cs_;
+
+    graph_scope( graph_scope const & );
+    graph_scope & operator=( graph_scope const & );
+
+public:
+
+    // Impl is dependency_graph::impl, whose name is private
+    template< class Impl > explicit graph_scope( Impl & g ):
+#if defined(BOOSTDEP_HAS_THREADS)
+        lock_( g.mutex_ ),
+#endif
+        cs_( g.context_ )
+    {
+    }
+};
+
+dependency_graph::dependency_graph( std::string const & root, bool track_sources, bool track_tests, int jobs ): pi_( new impl )
+{
+    try
+    {
+        context & ctx = pi_->context_;
+
+        ctx.root_ = fs::absolute( root );
+        ctx.jobs_ = jobs;
+
+        if( !is_boost_root( ctx.root_ ) )
+        {
+            throw std::runtime_error( "'" + root + "': not a valid Boost root" );
+        }
+
+        graph_scope scope( *pi_ );
+
+        build_header_map();
+        build_module_dependency_map( track_sources, track_tests );
+    }
+    catch( ... )
+    {
+        delete pi_;
+        throw;
+    }
+}
+
+dependency_graph::~dependency_graph()
+{
+    delete pi_;
+}
+
+std::string dependency_graph::root() const
+{
+    return pi_->context_.root_.string();
+}
+
+template< class K, class V > static V lookup( std::map< K, V > const & m, K const & k )
+{
+    typename std::map< K, V >::const_iterator i = m.find( k );
+    return i == m.end()? V(): i->second;
+}
+
+std::set< std::string > dependency_graph::modules() const
+{
+    graph_scope scope( *pi_ );
+    return s_context->modules_;
+}
+
+std::set< std::string > dependency_graph::module_headers( std::string const & module ) const
+{
+    graph_scope scope( *pi_ );
+    return lookup( s_context->module_headers_, module );
+}
+
+std::string dependency_graph::header_module( std::string const & header ) const
+{
+    graph_scope scope( *pi_ );
+    return lookup( s_context->header_map_, header );
+}
+
+std::set< std::string > dependency_graph::header_includes( std::string const & header ) const
+{
+    graph_scope scope( *pi_ );
+    return lookup( s_context->header_includes_, header );
+}
+
+std::set< std::string > dependency_graph::header_included_by( std::string const & header ) const
+{
+    graph_scope scope( *pi_ );
+    return lookup( s_context->header_included_by_, header );
+}
+
+std::set< std::string > dependency_graph::primary( std::string const & module ) const
+{
+    graph_scope scope( *pi_ );
+    return lookup( s_context->module_deps_, module );
+}
+
+std::set< std::string > dependency_graph::secondary( std::string const & module ) const
+{
+    graph_scope scope( *pi_ );
+
+    std::set< std::string > modules;
+    modules.insert( module );
+
+    std::map< std::string, std::set< std::string > > secondary_deps;
+    compute_secondary_dependencies( modules, secondary_deps );
+
+    return secondary_deps[ module ];
+}
+
+std::set< std::string > dependency_graph::reverse( std::string const & module ) const
+{
+    graph_scope scope( *pi_ );
+    return lookup( s_context->reverse_deps_, module );
+}
+
+std::map< std::string, int > dependency_graph::levels() const
+{
+    graph_scope scope( *pi_ );
+
+    std::map< std::string, int > level_map;
+    compute_module_levels( level_map );
+
+    for( std::map< std::string, int >::iterator i = level_map.begin(); i != level_map.end(); ++i )
+    {
+        if( i->second >= ::unknown_level )
+        {
+            i->second = unknown_level;
+        }
+    }
+
+    return level_map;
+}
+
+std::map< std::string, int > dependency_graph::weights() const
+{
+    graph_scope scope( *pi_ );
+
+    std::map< std::string, std::set< std::string > > secondary_deps;
+    compute_secondary_dependencies( s_context->modules_, secondary_deps );
+
+    std::map< std::string, int > r;
+
+    for( std::set< std::string >::const_iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        r[ *i ] = module_weight( *i, secondary_deps );
+    }
+
+    return r;
+}
+
+namespace
+{
+
+struct collect_subset_actions: public module_subset_actions
+{
+    std::map< std::string, std::vector< std::vector< std::string > > > subset_;
+    std::string module_;
+
+    void heading( std::string const & /*module*/ )
+    {
+    }
+
+    void module_start( std::string const & module )
+    {
+        module_ = module;
+        subset_[ module ];
+    }
+
+    void module_end( std::string const & /*module*/ )
+    {
+    }
+
+    void from_path( std::vector<std::string> const & path )
+    {
+        subset_[ module_ ].push_back( path );
+    }
+};
+
+} // unnamed namespace
+
+std::map< std::string, std::vector< std::vector< std::string > > > dependency_graph::subset( std::string const & module ) const
+{
+    graph_scope scope( *pi_ );
+
+    collect_subset_actions actions;
+    output_module_subset_report_( module, lookup( s_context->module_headers_, module ), s_context->header_includes_, actions );
+
+    return actions.subset_;
+}
+
+} // namespace boostdep
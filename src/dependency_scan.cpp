@@ -0,0 +1,6700 @@
+// dependency_scan.cpp - the scanning and dependency graph code of boostdep
+//
+// Copyright 2014-2017 Peter Dimov
+//
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "dependency_scan.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <unistd.h>
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <sys/resource.h>
+# include <time.h>
+#endif
+
+#if defined(__linux__)
+# include <sys/syscall.h>
+# include <sys/mman.h>
+# if defined(__GNUC__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#   include <linux/io_uring.h>
+#  endif
+# endif
+# if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(IORING_FEAT_CUR_PERSONALITY)
+#  define BOOSTDEP_HAS_IO_URING
+# endif
+#endif
+
+#if defined(BOOSTDEP_HAS_ZLIB)
+# include <zlib.h>
+#endif
+
+// timing
+
+double wall_time_ms()
+{
+#if defined(_WIN32)
+
+    // clock() measures wall time under Windows
+    return std::clock() * 1000.0 / CLOCKS_PER_SEC;
+
+#else
+
+    timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+
+#endif
+}
+
+// CPU time of the calling thread, or of the whole process
+double cpu_time_ms( bool thread )
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+
+    timespec ts;
+    clock_gettime( thread? CLOCK_THREAD_CPUTIME_ID: CLOCK_PROCESS_CPUTIME_ID, &ts );
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+
+#else
+
+    (void)thread;
+    return std::clock() * 1000.0 / CLOCKS_PER_SEC;
+
+#endif
+}
+
+// peak resident set size of the process so far
+long peak_rss_kb()
+{
+#if defined(__unix__) || defined(__APPLE__)
+
+    rusage ru;
+    getrusage( RUSAGE_SELF, &ru );
+
+#if defined(__APPLE__)
+    return ru.ru_maxrss / 1024;
+#else
+    return ru.ru_maxrss;
+#endif
+
+#else
+
+    return 0;
+
+#endif
+}
+
+// --mem-stats
+
+bool s_mem_stats = false;
+
+memory_counter s_mem_allocations;
+memory_counter s_mem_allocated;
+memory_counter s_mem_live;
+memory_counter s_mem_peak;
+
+// --profile
+
+bool s_profile = false;
+double s_profile_start;
+
+std::vector< profile_event > s_profile_events;
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+std::mutex s_profile_mutex;
+
+#endif
+
+// --bench
+bool s_bench = false;
+
+BOOSTDEP_THREAD_LOCAL context * s_context;
+
+// resolves a path relative to the Boost root
+fs::path root_path( fs::path const & p )
+{
+    return p.is_absolute()? p: s_context->root_ / p;
+}
+
+// libs/<module>, or the directory of a module of an --overlay-root
+static fs::path module_path( std::string module )
+{
+    std::map< std::string, fs::path >::const_iterator i = s_context->module_dirs_.find( module );
+
+    if( i != s_context->module_dirs_.end() )
+    {
+        return i->second;
+    }
+
+    std::replace( module.begin(), module.end(), '~', '/' );
+    return fs::path( "libs" ) / module;
+}
+
+fs::path module_include_path( std::string const & module )
+{
+    return module_path( module ) / "include";
+}
+
+fs::path module_source_path( std::string const & module )
+{
+    return module_path( module ) / "src";
+}
+
+fs::path module_build_path( std::string const & module )
+{
+    return module_path( module ) / "build";
+}
+
+fs::path module_test_path( std::string const & module )
+{
+    return module_path( module ) / "test";
+}
+
+// #include directives
+
+// a group of #if, #elif and #else branches
+struct condition_frame
+{
+    // the condition of the current branch, and the disjunction of
+    // those of the branches before it
+    std::string branch;
+    std::string taken;
+
+    // the include guard of the file, which isn't a condition
+    bool guard;
+};
+
+static void skip_spaces( std::string & line )
+{
+    std::string::size_type k = line.find_first_not_of( " \t" );
+    line.erase( 0, k == std::string::npos? line.size(): k );
+}
+
+// the operand of a directive, without comments and trailing spaces
+static std::string directive_operand( std::string const & text )
+{
+    std::string r;
+
+    for( std::string::size_type i = 0; i < text.size(); ++i )
+    {
+        if( text.compare( i, 2, "//" ) == 0 ) break;
+
+        if( text.compare( i, 2, "/*" ) == 0 )
+        {
+            std::string::size_type k = text.find( "*/", i + 2 );
+
+            if( k == std::string::npos ) break;
+
+            r += ' ';
+            i = k + 1;
+
+            continue;
+        }
+
+        r += text[ i ];
+    }
+
+    std::string::size_type k = r.find_last_not_of( " \t\r" );
+    r.erase( k == std::string::npos? 0: k + 1 );
+
+    skip_spaces( r );
+    return r;
+}
+
+static bool is_pp_ident_start( char ch )
+{
+    return std::isalpha( static_cast< unsigned char >( ch ) ) || ch == '_';
+}
+
+static bool is_pp_ident_char( char ch )
+{
+    return std::isalnum( static_cast< unsigned char >( ch ) ) || ch == '_';
+}
+
+// the end of the string or character literal whose opening quote is at
+// s[ i ]; raw string literals may span lines
+static std::size_t pp_literal_end( std::string const & s, std::size_t i, bool raw )
+{
+    // a delimiter has at most 16 characters, none of them spaces,
+    // parentheses or backslashes; otherwise the literal isn't raw
+    std::size_t const k = raw? s.find_first_of( " \t\r\n\\()\"", i + 1 ): std::string::npos;
+
+    if( k != std::string::npos && k - i - 1 <= 16 && s[ k ] == '(' )
+    {
+        std::string const close = ")" + s.substr( i + 1, k - i - 1 ) + "\"";
+
+        std::size_t const e = s.find( close, k + 1 );
+        return e == std::string::npos? s.size(): e + close.size();
+    }
+
+    char const quote = s[ i ];
+
+    for( ++i; i < s.size() && s[ i ] != '\n'; ++i )
+    {
+        if( s[ i ] == '\\' )
+        {
+            ++i;
+        }
+        else if( s[ i ] == quote )
+        {
+            return i + 1;
+        }
+    }
+
+    return i;
+}
+
+// whether the identifier that ends before s[ i ] is the prefix of a raw
+// string literal
+static bool is_raw_prefix( std::string const & s, std::size_t i )
+{
+    std::size_t k = i;
+    while( k > 0 && is_pp_ident_char( s[ k - 1 ] ) ) --k;
+
+    std::size_t const n = i - k;
+    return s.compare( k, n, "R" ) == 0 || s.compare( k, n, "LR" ) == 0 || s.compare( k, n, "uR" ) == 0 || s.compare( k, n, "UR" ) == 0 || s.compare( k, n, "u8R" ) == 0;
+}
+
+// whether the ' at s[ i ] is a digit separator, as in 1'000
+static bool is_digit_separator( std::string const & s, std::size_t i )
+{
+    std::size_t k = i;
+    while( k > 0 && ( is_pp_ident_char( s[ k - 1 ] ) || s[ k - 1 ] == '.' || s[ k - 1 ] == '\'' ) ) --k;
+
+    return k < i && std::isdigit( static_cast< unsigned char >( s[ k ] ) );
+}
+
+// directive == name, with the lengths compared first, as most directives
+// are checked against several names
+template< std::size_t N > static bool is_directive( std::string const & directive, char const (&name)[ N ] )
+{
+    return directive.size() == N - 1 && std::memcmp( directive.data(), name, N - 1 ) == 0;
+}
+
+// the macro X of an #ifndef X, #if !defined(X) or #if !defined X that may
+// start an include guard, or an empty string
+static std::string guard_macro( std::string const & directive, std::string const & operand )
+{
+    std::string x;
+
+    if( directive == "ifndef" )
+    {
+        x = operand;
+    }
+    else if( directive == "if" && operand.compare( 0, 8, "!defined" ) == 0 )
+    {
+        x = operand.substr( 8 );
+        x.erase( std::remove( x.begin(), x.end(), '(' ), x.end() );
+        x.erase( std::remove( x.begin(), x.end(), ')' ), x.end() );
+        x.erase( x.find_last_not_of( " \t" ) + 1 );
+        skip_spaces( x );
+    }
+
+    return x.find_first_of( " \t" ) == std::string::npos? x: std::string();
+}
+
+// the condition of the #include directives at the current point
+static std::string current_condition( std::vector< condition_frame > const & frames )
+{
+    std::string r;
+
+    for( std::vector< condition_frame >::const_iterator i = frames.begin(); i != frames.end(); ++i )
+    {
+        if( i->guard ) continue;
+
+        r = r.empty()? i->branch: "(" + r + ") && (" + i->branch + ")";
+    }
+
+    return r;
+}
+
+// the size of text, in the bytes and lines that std::getline sees
+static file_size text_size( std::string const & text )
+{
+    file_size r = { text.size(), static_cast< unsigned long >( std::count( text.begin(), text.end(), '\n' ) ) };
+
+    if( !text.empty() && text[ text.size() - 1 ] != '\n' )
+    {
+        ++r.bytes;
+        ++r.lines;
+    }
+
+    return r;
+}
+
+// the newline that ends the // comment at text[ i ], which may be
+// continued with a backslash, or the end of text
+static std::size_t line_comment_end( std::string const & text, std::size_t i )
+{
+    for( ;; )
+    {
+        i = text.find( '\n', i + 1 );
+
+        if( i == std::string::npos ) return text.size();
+
+        std::size_t b = text[ i - 1 ] == '\r'? i - 1: i;
+
+        if( text[ b - 1 ] != '\\' ) return i;
+    }
+}
+
+// whether ch may end a line, or start a comment or a literal
+static bool is_lexer_stop( char ch )
+{
+    // one bit for each of \n, ", ' and /
+    unsigned char const c = static_cast< unsigned char >( ch );
+    return ( c < 64 && ( ( 0x808400000400ull >> c ) & 1 ) ) || c == '\\';
+}
+
+// the first character from text[ i ] on for which is_lexer_stop holds, or
+// the end of text; tests eight characters at a time while there are none
+static std::size_t find_lexer_stop( std::string const & text, std::size_t i )
+{
+    unsigned long long const ones = 0x0101010101010101ull;
+    unsigned long long const highs = 0x8080808080808080ull;
+
+    for( ; i + 8 <= text.size(); i += 8 )
+    {
+        unsigned long long w;
+        std::memcpy( &w, text.data() + i, 8 );
+
+        // a byte of v is zero when the corresponding one of w is c
+        unsigned long long const v1 = w ^ ( ones * '\n' );
+        unsigned long long const v2 = w ^ ( ones * '/' );
+        unsigned long long const v3 = w ^ ( ones * '"' );
+        unsigned long long const v4 = w ^ ( ones * '\'' );
+        unsigned long long const v5 = w ^ ( ones * '\\' );
+
+        unsigned long long const z = ( ( v1 - ones ) & ~v1 ) | ( ( v2 - ones ) & ~v2 ) | ( ( v3 - ones ) & ~v3 ) | ( ( v4 - ones ) & ~v4 ) | ( ( v5 - ones ) & ~v5 );
+
+        if( z & highs ) break;
+    }
+
+    while( i < text.size() && !is_lexer_stop( text[ i ] ) ) ++i;
+
+    return i;
+}
+
+// the text of a directive from text[ i ] on, with its comments replaced
+// by spaces and its continued lines joined, stored in line when it isn't
+// null; returns the newline that ends it, or the end of text
+static std::size_t directive_text( std::string const & text, std::size_t i, std::string * line )
+{
+    if( line ) line->clear();
+
+    for( ; i < text.size(); ++i )
+    {
+        char ch = text[ i ];
+
+        if( ch == '\n' ) break;
+
+        char next = i + 1 < text.size()? text[ i + 1 ]: 0;
+
+        if( ch == '\\' && ( next == '\n' || ( next == '\r' && i + 2 < text.size() && text[ i + 2 ] == '\n' ) ) )
+        {
+            i += next == '\n'? 1: 2;
+        }
+        else if( ch == '/' && next == '*' )
+        {
+            std::size_t k = text.find( "*/", i + 2 );
+
+            if( line ) *line += ' ';
+
+            if( k == std::string::npos ) return text.size();
+
+            i = k + 1;
+        }
+        else if( ch == '/' && next == '/' )
+        {
+            return line_comment_end( text, i );
+        }
+        else if( ch == '"' || ( ch == '\'' && !is_digit_separator( text, i ) ) )
+        {
+            std::size_t k = pp_literal_end( text, i, ch == '"' && is_raw_prefix( text, i ) );
+
+            if( line ) line->append( text, i, k - i );
+            i = k - 1;
+        }
+        else
+        {
+            std::size_t k = find_lexer_stop( text, i + 1 );
+
+            if( line ) line->append( text, i, k - i );
+            i = k - 1;
+        }
+    }
+
+    return i;
+}
+
+// the number of newlines in text[ i ], ..., text[ k - 1 ]
+static unsigned long count_newlines( std::string const & text, std::size_t i, std::size_t k )
+{
+    return static_cast< unsigned long >( std::count( text.begin() + i, text.begin() + k, '\n' ) );
+}
+
+// recognizes the include guard of a file from its directives: the first
+// one is #ifndef X or #if !defined(X), possibly after #pragma once, the
+// second is #define X, and the #endif that matches the first is the last
+// one, with only comments before and after them
+class include_guard_scanner
+{
+private:
+
+    enum { guard_start, guard_define, guard_body, guard_end, guard_none } state_;
+
+    std::string guard_;
+    int level_;
+
+    bool once_;
+
+    // the text lines up to the end of the guard
+    unsigned long text_lines_;
+
+public:
+
+    include_guard_scanner(): state_( guard_start ), level_( 0 ), once_( false ), text_lines_( 0 )
+    {
+    }
+
+    // whether directive() needs the operand of `directive`, other than
+    // #include
+    bool needs_operand( std::string const & directive ) const
+    {
+        return is_directive( directive, "pragma" ) || ( state_ == guard_start && ( is_directive( directive, "if" ) || is_directive( directive, "ifndef" ) ) ) || ( state_ == guard_define && is_directive( directive, "define" ) );
+    }
+
+    // an #include outside the guard
+    void include()
+    {
+        if( state_ != guard_body )
+        {
+            state_ = guard_none;
+        }
+    }
+
+    // `text_lines` is the number of lines before the directive with text
+    // other than directives and comments; returns true when `directive`
+    // is the #define of the guard
+    bool directive( std::string const & directive, std::string const & operand, unsigned long text_lines );
+
+    bool guarded( unsigned long text_lines ) const
+    {
+        return once_ || ( state_ == guard_end && text_lines == text_lines_ );
+    }
+};
+
+bool include_guard_scanner::directive( std::string const & directive, std::string const & operand, unsigned long text_lines )
+{
+    if( is_directive( directive, "pragma" ) )
+    {
+        once_ = once_ || operand == "once";
+
+        if( state_ == guard_start ) return false;
+    }
+
+    switch( state_ )
+    {
+    case guard_start:
+
+        guard_ = text_lines == 0? guard_macro( directive, operand ): std::string();
+        state_ = guard_.empty()? guard_none: guard_define;
+
+        return false;
+
+    case guard_define:
+
+        state_ = text_lines == 0 && is_directive( directive, "define" ) && operand.substr( 0, operand.find_first_of( " \t(" ) ) == guard_? guard_body: guard_none;
+        return state_ == guard_body;
+
+    case guard_body:
+
+        if( is_directive( directive, "if" ) || is_directive( directive, "ifdef" ) || is_directive( directive, "ifndef" ) )
+        {
+            ++level_;
+        }
+        else if( is_directive( directive, "endif" ) && level_-- == 0 )
+        {
+            state_ = guard_end;
+            text_lines_ = text_lines;
+        }
+        else if( level_ == 0 && ( is_directive( directive, "else" ) || is_directive( directive, "elif" ) ) )
+        {
+            state_ = guard_none;
+        }
+
+        return false;
+
+    default:
+
+        state_ = guard_none;
+        return false;
+    }
+}
+
+// the #include directives of text, in a single pass that skips comments
+// and string, character and raw string literals; the lines are counted on
+// the way, while the text that is skipped is still in the cache
+//
+// #if 0 groups are not skipped, as Boost headers use them to show their
+// computed includes to dependency trackers
+static void parse_includes( std::string const & text, file_includes & f, bool track_conditions )
+{
+    unsigned long lines = 0;
+
+    std::vector< condition_frame > frames;
+    std::string condition;
+
+    include_guard_scanner guard;
+
+    // the lines with text other than directives and comments
+    unsigned long text_lines = 0;
+
+    // whether only spaces and comments precede text[ i ] on its line
+    bool bol = true;
+
+    std::string line;
+
+    for( std::size_t i = 0, n = text.size(); i < n; ++i )
+    {
+        char const ch = text[ i ];
+
+        switch( ch )
+        {
+        case '\n':
+
+            ++lines;
+
+            if( !bol ) ++text_lines;
+
+            bol = true;
+            continue;
+
+        case ' ': case '\t': case '\r': case '\f': case '\v':
+
+            while( i + 1 < n && ( text[ i + 1 ] == ' ' || text[ i + 1 ] == '\t' ) ) ++i;
+            continue;
+
+        case '\\':
+
+            // a line continuation
+            if( i + 1 < n && text[ i + 1 ] == '\n' )
+            {
+                ++i;
+                ++lines;
+            }
+            else if( i + 2 < n && text[ i + 1 ] == '\r' && text[ i + 2 ] == '\n' )
+            {
+                i += 2;
+                ++lines;
+            }
+            else
+            {
+                bol = false;
+            }
+
+            continue;
+
+        case '/':
+
+            if( i + 1 < n && text[ i + 1 ] == '*' )
+            {
+                std::size_t k = text.find( "*/", i + 2 );
+                k = k == std::string::npos? n: k + 2;
+
+                lines += count_newlines( text, i, k );
+                i = k - 1;
+            }
+            else if( i + 1 < n && text[ i + 1 ] == '/' )
+            {
+                std::size_t k = line_comment_end( text, i );
+
+                lines += count_newlines( text, i, k );
+                i = k - 1;
+            }
+            else
+            {
+                bol = false;
+            }
+
+            continue;
+
+        case '"': case '\'':
+
+            if( ch == '"' || !is_digit_separator( text, i ) )
+            {
+                std::size_t k = pp_literal_end( text, i, ch == '"' && is_raw_prefix( text, i ) );
+
+                lines += count_newlines( text, i, k );
+                i = k - 1;
+            }
+
+            bol = false;
+            continue;
+
+        case '#':
+
+            if( bol ) break;
+            continue;
+
+        default:
+
+            bol = false;
+
+            // up to the next character that may end the line or start
+            // a comment or a literal
+            i = find_lexer_stop( text, i + 1 ) - 1;
+
+            continue;
+        }
+
+        // a directive; its name is followed by its text, which is only
+        // collected for those below, and i is left before the newline
+        // that ends it
+
+        std::size_t b = i + 1;
+
+        // spaces, continued lines and /* */ comments may come between
+        // the # and the name, and continued lines also within the name
+
+        for( ;; )
+        {
+            if( b < n && ( text[ b ] == ' ' || text[ b ] == '\t' ) )
+            {
+                ++b;
+            }
+            else if( text.compare( b, 2, "\\\n" ) == 0 )
+            {
+                b += 2;
+            }
+            else if( text.compare( b, 3, "\\\r\n" ) == 0 )
+            {
+                b += 3;
+            }
+            else if( text.compare( b, 2, "/*" ) == 0 )
+            {
+                std::size_t k = text.find( "*/", b + 2 );
+                b = k == std::string::npos? n: k + 2;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        std::size_t e = b;
+
+        for( ;; )
+        {
+            while( e < n && std::isalpha( static_cast< unsigned char >( text[ e ] ) ) ) ++e;
+
+            std::size_t const k = text.compare( e, 2, "\\\n" ) == 0? e + 2: text.compare( e, 3, "\\\r\n" ) == 0? e + 3: e;
+
+            if( k == e || k >= n || !std::isalpha( static_cast< unsigned char >( text[ k ] ) ) ) break;
+
+            e = k;
+        }
+
+        std::string directive( text, b, e - b );
+
+        for( std::string::size_type k; ( k = directive.find( '\\' ) ) != std::string::npos; )
+        {
+            directive.erase( k, directive[ k + 1 ] == '\r'? 3: 2 );
+        }
+
+        if( is_directive( directive, "include" ) )
+        {
+            guard.include();
+
+            std::size_t const eol = directive_text( text, e, &line );
+
+            lines += count_newlines( text, i, eol );
+            i = eol - 1;
+
+            std::size_t h = e;
+            while( h < eol && ( text[ h ] == ' ' || text[ h ] == '\t' ) ) ++h;
+
+            if( h < eol && text[ h ] == '<' )
+            {
+                // a header name, in which // and /* don't start comments
+                std::size_t const j = text.find( '>', h );
+                line.assign( text, h, j < eol? j + 1 - h: eol - h );
+            }
+
+            skip_spaces( line );
+
+            if( line.size() < 2 ) continue;
+
+            char delim = line[0];
+
+            if( delim != '<' && delim != '"' ) continue;
+
+            if( delim == '<' )
+            {
+                delim = '>';
+            }
+
+            line.erase( 0, 1 );
+
+            std::string::size_type j = line.find_first_of( delim );
+
+            if( j != std::string::npos )
+            {
+                line.erase( j );
+            }
+
+            f.includes.push_back( line );
+
+            if( track_conditions )
+            {
+                f.conditions.push_back( condition );
+            }
+
+            continue;
+        }
+
+        // conditional directives, and those of the include guard
+
+        bool const conditional = track_conditions && ( is_directive( directive, "if" ) || is_directive( directive, "ifdef" ) || is_directive( directive, "ifndef" ) || is_directive( directive, "elif" ) || is_directive( directive, "else" ) || is_directive( directive, "endif" ) || is_directive( directive, "define" ) );
+
+        bool const collect = conditional || guard.needs_operand( directive );
+
+        std::size_t const eol = directive_text( text, e, collect? &line: 0 );
+
+        lines += count_newlines( text, i, eol );
+        i = eol - 1;
+
+        // the null directive, often followed by a comment, has no effect
+        if( directive.empty() ) continue;
+
+        std::string const operand = collect? directive_operand( line ): std::string();
+
+        if( guard.directive( directive, operand, text_lines ) && track_conditions && frames.size() == 1 )
+        {
+            // the guard isn't a condition
+            frames[ 0 ].guard = true;
+            condition = current_condition( frames );
+        }
+
+        if( !conditional || is_directive( directive, "define" ) ) continue;
+
+        if( is_directive( directive, "if" ) || is_directive( directive, "ifdef" ) || is_directive( directive, "ifndef" ) )
+        {
+            condition_frame c;
+
+            c.branch = is_directive( directive, "ifdef" )? "defined(" + operand + ")": is_directive( directive, "ifndef" )? "!defined(" + operand + ")": operand;
+            c.taken = "(" + c.branch + ")";
+            c.guard = false;
+
+            frames.push_back( c );
+        }
+        else if( frames.empty() )
+        {
+            // unbalanced
+            continue;
+        }
+        else if( is_directive( directive, "elif" ) )
+        {
+            condition_frame & c = frames.back();
+
+            c.branch = "!(" + c.taken + ") && (" + operand + ")";
+            c.taken += " || (" + operand + ")";
+            c.guard = false;
+        }
+        else if( is_directive( directive, "else" ) )
+        {
+            condition_frame & c = frames.back();
+
+            c.branch = "!(" + c.taken + ")";
+            c.guard = false;
+        }
+        else // endif
+        {
+            frames.pop_back();
+        }
+
+        condition = current_condition( frames );
+    }
+
+    if( !bol ) ++text_lines;
+
+    f.guarded = guard.guarded( text_lines );
+
+    // as counted by std::getline
+    f.size.bytes = text.size();
+    f.size.lines = lines;
+
+    if( !text.empty() && text[ text.size() - 1 ] != '\n' )
+    {
+        ++f.size.bytes;
+        ++f.size.lines;
+    }
+}
+
+// #if conditions, evaluated under a --config configuration
+
+class condition_evaluator
+{
+private:
+
+    configuration const & config_;
+
+    std::vector< std::string > tokens_;
+    std::size_t pos_;
+
+    // a value, or unknown when it depends on something that can't be
+    // evaluated, such as a function-like macro
+    struct value
+    {
+        bool known;
+        long long v;
+    };
+
+    static value make( bool known, long long v )
+    {
+        value r = { known, v };
+        return r;
+    }
+
+    static bool is_ident_start( char ch )
+    {
+        return std::isalpha( static_cast< unsigned char >( ch ) ) || ch == '_';
+    }
+
+    static bool is_ident_char( char ch )
+    {
+        return std::isalnum( static_cast< unsigned char >( ch ) ) || ch == '_';
+    }
+
+    static void tokenize( std::string const & s, std::vector< std::string > & tokens )
+    {
+        static char const * const ops[] = { "&&", "||", "==", "!=", "<=", ">=", "<<", ">>" };
+
+        for( std::size_t i = 0; i < s.size(); )
+        {
+            char ch = s[ i ];
+
+            if( ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' )
+            {
+                ++i;
+            }
+            else if( is_ident_start( ch ) || std::isdigit( static_cast< unsigned char >( ch ) ) )
+            {
+                std::size_t j = i + 1;
+                while( j < s.size() && ( is_ident_char( s[ j ] ) || s[ j ] == '\'' ) ) ++j;
+
+                tokens.push_back( s.substr( i, j - i ) );
+                i = j;
+            }
+            else if( ch == '\'' )
+            {
+                // a character literal
+                std::size_t j = s.find( '\'', i + 1 + ( i + 1 < s.size() && s[ i + 1 ] == '\\' ) );
+                j = j == std::string::npos? s.size(): j + 1;
+
+                tokens.push_back( s.substr( i, j - i ) );
+                i = j;
+            }
+            else
+            {
+                std::size_t n = 1;
+
+                for( std::size_t k = 0; k < sizeof( ops ) / sizeof( ops[ 0 ] ); ++k )
+                {
+                    if( s.compare( i, 2, ops[ k ] ) == 0 ) n = 2;
+                }
+
+                tokens.push_back( s.substr( i, n ) );
+                i += n;
+            }
+        }
+    }
+
+    // replaces the object-like macros in tokens by their bodies, and the
+    // invocations of function-like macros by #unknown
+    void expand( std::vector< std::string > const & tokens, std::set< std::string > & active, int depth )
+    {
+        for( std::size_t i = 0; i < tokens.size(); ++i )
+        {
+            std::string const & t = tokens[ i ];
+
+            if( t == "defined" )
+            {
+                // the operand is not expanded
+                tokens_.push_back( t );
+
+                std::size_t n = i + 1 < tokens.size() && tokens[ i + 1 ] == "("? 3: 1;
+
+                for( std::size_t k = 0; k < n && i + 1 < tokens.size(); ++k )
+                {
+                    tokens_.push_back( tokens[ ++i ] );
+                }
+
+                continue;
+            }
+
+            std::map< std::string, macro_definition >::const_iterator m = is_ident_start( t[ 0 ] )? config_.macros.find( t ): config_.macros.end();
+
+            bool const call = i + 1 < tokens.size() && tokens[ i + 1 ] == "(";
+
+            if( m != config_.macros.end() && !m->second.function && !active.count( t ) && depth < 32 )
+            {
+                std::vector< std::string > body;
+                tokenize( m->second.body, body );
+
+                active.insert( t );
+                expand( body, active, depth + 1 );
+                active.erase( t );
+            }
+            else if( call && ( m != config_.macros.end() || t.compare( 0, 2, "__" ) == 0 ) )
+            {
+                // a function-like macro, or __has_include and the like
+                int level = 0;
+
+                for( ++i; i < tokens.size(); ++i )
+                {
+                    if( tokens[ i ] == "(" ) ++level;
+                    if( tokens[ i ] == ")" && --level == 0 ) break;
+                }
+
+                tokens_.push_back( "#unknown" );
+            }
+            else
+            {
+                tokens_.push_back( t );
+            }
+        }
+    }
+
+    std::string const & peek() const
+    {
+        static std::string const end;
+        return pos_ < tokens_.size()? tokens_[ pos_ ]: end;
+    }
+
+    bool accept( char const * t )
+    {
+        if( peek() == t )
+        {
+            ++pos_;
+            return true;
+        }
+
+        return false;
+    }
+
+    value primary()
+    {
+        std::string const t = peek();
+        ++pos_;
+
+        if( t == "(" )
+        {
+            value v = conditional();
+            return accept( ")" )? v: make( false, 0 );
+        }
+
+        if( t == "!" ) { value v = primary(); return make( v.known, !v.v ); }
+        if( t == "~" ) { value v = primary(); return make( v.known, ~v.v ); }
+        if( t == "-" ) { value v = primary(); return make( v.known, -v.v ); }
+        if( t == "+" ) { return primary(); }
+
+        if( t == "defined" )
+        {
+            bool paren = accept( "(" );
+
+            std::string const name = peek();
+            ++pos_;
+
+            if( paren && !accept( ")" ) ) return make( false, 0 );
+
+            return make( true, config_.macros.count( name ) != 0 );
+        }
+
+        if( t.empty() || t == "#unknown" ) return make( false, 0 );
+
+        if( std::isdigit( static_cast< unsigned char >( t[ 0 ] ) ) )
+        {
+            std::string digits;
+
+            for( std::string::const_iterator i = t.begin(); i != t.end(); ++i )
+            {
+                if( *i != '\'' ) digits += *i;
+            }
+
+            // the suffixes, such as L or ULL, are ignored
+            return make( true, static_cast< long long >( std::strtoull( digits.c_str(), 0, 0 ) ) );
+        }
+
+        if( t[ 0 ] == '\'' )
+        {
+            return t.size() == 3? make( true, t[ 1 ] ): make( false, 0 );
+        }
+
+        if( is_ident_start( t[ 0 ] ) )
+        {
+            // identifiers that aren't macros are 0, except true
+            return make( true, t == "true" );
+        }
+
+        return make( false, 0 );
+    }
+
+    static int precedence( std::string const & op )
+    {
+        if( op == "||" ) return 1;
+        if( op == "&&" ) return 2;
+        if( op == "|" ) return 3;
+        if( op == "^" ) return 4;
+        if( op == "&" ) return 5;
+        if( op == "==" || op == "!=" ) return 6;
+        if( op == "<" || op == ">" || op == "<=" || op == ">=" ) return 7;
+        if( op == "<<" || op == ">>" ) return 8;
+        if( op == "+" || op == "-" ) return 9;
+        if( op == "*" || op == "/" || op == "%" ) return 10;
+
+        return 0;
+    }
+
+    static value apply( std::string const & op, value a, value b )
+    {
+        // && and || are known when one known operand decides them
+        if( op == "&&" )
+        {
+            if( ( a.known && !a.v ) || ( b.known && !b.v ) ) return make( true, 0 );
+            return make( a.known && b.known, 1 );
+        }
+
+        if( op == "||" )
+        {
+            if( ( a.known && a.v ) || ( b.known && b.v ) ) return make( true, 1 );
+            return make( a.known && b.known, 0 );
+        }
+
+        if( !a.known || !b.known ) return make( false, 0 );
+
+        long long x = a.v, y = b.v;
+
+        if( op == "|" ) return make( true, x | y );
+        if( op == "^" ) return make( true, x ^ y );
+        if( op == "&" ) return make( true, x & y );
+        if( op == "==" ) return make( true, x == y );
+        if( op == "!=" ) return make( true, x != y );
+        if( op == "<" ) return make( true, x < y );
+        if( op == ">" ) return make( true, x > y );
+        if( op == "<=" ) return make( true, x <= y );
+        if( op == ">=" ) return make( true, x >= y );
+        if( op == "<<" ) return make( y >= 0 && y < 64, y >= 0 && y < 64? x << y: 0 );
+        if( op == ">>" ) return make( y >= 0 && y < 64, y >= 0 && y < 64? x >> y: 0 );
+        if( op == "+" ) return make( true, x + y );
+        if( op == "-" ) return make( true, x - y );
+        if( op == "*" ) return make( true, x * y );
+        if( op == "/" ) return make( y != 0, y != 0? x / y: 0 );
+        if( op == "%" ) return make( y != 0, y != 0? x % y: 0 );
+
+        return make( false, 0 );
+    }
+
+    value binary( int min_precedence )
+    {
+        value a = primary();
+
+        for( ;; )
+        {
+            std::string const op = peek();
+            int const p = precedence( op );
+
+            if( p == 0 || p < min_precedence ) return a;
+
+            ++pos_;
+
+            value b = binary( p + 1 );
+            a = apply( op, a, b );
+        }
+    }
+
+    value conditional()
+    {
+        value c = binary( 1 );
+
+        if( !accept( "?" ) ) return c;
+
+        value a = conditional();
+
+        if( !accept( ":" ) ) return make( false, 0 );
+
+        value b = conditional();
+
+        if( !c.known ) return a.known && b.known && a.v == b.v? a: make( false, 0 );
+
+        return c.v? a: b;
+    }
+
+public:
+
+    explicit condition_evaluator( configuration const & config ): config_( config ), pos_( 0 )
+    {
+    }
+
+    // false only when the condition is known not to hold
+    bool may_hold( std::string const & condition )
+    {
+        std::vector< std::string > tokens;
+        tokenize( condition, tokens );
+
+        std::set< std::string > active;
+
+        tokens_.clear();
+        expand( tokens, active, 0 );
+
+        pos_ = 0;
+
+        value v = conditional();
+
+        if( pos_ != tokens_.size() ) return true;
+
+        return !v.known || v.v != 0;
+    }
+};
+
+// the configurations in which condition may hold; memoized
+static config_mask condition_mask( std::string const & condition )
+{
+    std::map< std::string, config_mask >::const_iterator i = s_context->condition_masks_.find( condition );
+
+    if( i != s_context->condition_masks_.end() ) return i->second;
+
+    config_mask mask = 0;
+
+    for( std::size_t k = 0; k < s_context->configs_.size(); ++k )
+    {
+        condition_evaluator e( s_context->configs_[ k ] );
+
+        if( e.may_hold( condition ) )
+        {
+            mask |= static_cast< config_mask >( 1 ) << k;
+        }
+    }
+
+    return s_context->condition_masks_[ condition ] = mask;
+}
+
+// reads a configuration from the #define lines in fn, as written by
+// the -dM option of GCC and Clang
+bool add_configuration( std::string const & name, std::string const & fn )
+{
+    if( s_context->configs_.size() == sizeof( config_mask ) * CHAR_BIT )
+    {
+        std::cerr << "'" << name << "': too many configurations.\n";
+        return false;
+    }
+
+    fs::ifstream is( root_path( fn ) );
+
+    if( !is )
+    {
+        std::cerr << "'" << fn << "': could not open file.\n";
+        return false;
+    }
+
+    configuration c;
+    c.name = name;
+
+    std::string line;
+
+    while( std::getline( is, line ) )
+    {
+        skip_spaces( line );
+
+        if( line.compare( 0, 1, "#" ) != 0 ) continue;
+
+        line.erase( 0, 1 );
+        skip_spaces( line );
+
+        if( line.compare( 0, 6, "define" ) != 0 ) continue;
+
+        line.erase( 0, 6 );
+        skip_spaces( line );
+
+        std::string::size_type k = 0;
+        while( k < line.size() && ( std::isalnum( static_cast< unsigned char >( line[ k ] ) ) || line[ k ] == '_' ) ) ++k;
+
+        if( k == 0 ) continue;
+
+        macro_definition & m = c.macros[ line.substr( 0, k ) ];
+
+        std::string::size_type const close = line.find( ')', k );
+
+        m.function = k < line.size() && line[ k ] == '(' && close != std::string::npos;
+        m.params = m.function? line.substr( k + 1, close - k - 1 ): std::string();
+        m.body = directive_operand( line.substr( m.function? close + 1: k ) );
+    }
+
+    s_context->configs_.push_back( c );
+
+    // the masks of the conditions have one more bit now
+    s_context->condition_masks_.clear();
+
+    return true;
+}
+
+// --use-git-index
+
+static unsigned long git_be32( unsigned char const * p )
+{
+    return ( static_cast< unsigned long >( p[ 0 ] ) << 24 ) | ( p[ 1 ] << 16 ) | ( p[ 2 ] << 8 ) | p[ 3 ];
+}
+
+// reads the paths of the files in a git index, versions 2 to 4; see
+// Documentation/gitformat-index.txt in the git sources
+static bool read_git_index( fs::path const & path, std::vector< std::string > & files )
+{
+    std::string data;
+
+    {
+        fs::ifstream is( path, std::ios_base::binary );
+
+        if( !is ) return false;
+
+        char buffer[ 65536 ];
+
+        while( is.read( buffer, sizeof( buffer ) ) || is.gcount() > 0 )
+        {
+            data.append( buffer, static_cast< std::size_t >( is.gcount() ) );
+        }
+    }
+
+    unsigned char const * p = reinterpret_cast< unsigned char const * >( data.data() );
+    std::size_t const size = data.size();
+
+    if( size < 12 || data.compare( 0, 4, "DIRC" ) != 0 ) return false;
+
+    unsigned long const version = git_be32( p + 4 );
+    unsigned long const count = git_be32( p + 8 );
+
+    if( version < 2 || version > 4 ) return false;
+
+    std::size_t pos = 12;
+    std::string name;
+
+    for( unsigned long i = 0; i < count; ++i )
+    {
+        // ctime, mtime, dev, ino, mode, uid, gid, size, object id, flags
+        if( pos + 62 > size ) return false;
+
+        unsigned long const mode = git_be32( p + pos + 24 );
+        unsigned const flags = ( p[ pos + 60 ] << 8 ) | p[ pos + 61 ];
+
+        std::size_t start = pos + 62;
+        unsigned extended = 0;
+
+        if( flags & 0x4000 )
+        {
+            if( version < 3 || start + 2 > size ) return false;
+
+            extended = ( p[ start ] << 8 ) | p[ start + 1 ];
+            start += 2;
+        }
+
+        if( version == 4 )
+        {
+            // the number of bytes to remove from the previous name,
+            // followed by the rest of this one
+            std::size_t k = start;
+
+            if( k >= size ) return false;
+
+            unsigned char c = p[ k++ ];
+            std::size_t strip = c & 127;
+
+            while( c & 128 )
+            {
+                if( k >= size ) return false;
+
+                c = p[ k++ ];
+                strip = ( ( strip + 1 ) << 7 ) | ( c & 127 );
+            }
+
+            void const * end = std::memchr( p + k, 0, size - k );
+
+            if( end == 0 || strip > name.size() ) return false;
+
+            std::size_t n = static_cast< unsigned char const * >( end ) - ( p + k );
+
+            name.erase( name.size() - strip );
+            name.append( data, k, n );
+
+            pos = k + n + 1;
+        }
+        else
+        {
+            void const * end = std::memchr( p + start, 0, size - start );
+
+            if( end == 0 ) return false;
+
+            std::size_t n = static_cast< unsigned char const * >( end ) - ( p + start );
+
+            name.assign( data, start, n );
+
+            // entries are padded with NULs to a multiple of eight bytes
+            pos += ( start - pos + n + 8 ) & ~static_cast< std::size_t >( 7 );
+        }
+
+        // regular files and symbolic links, not submodules or sparse
+        // directories; only one side of a conflict; not files that
+        // aren't checked out (skip-worktree)
+
+        unsigned long const type = mode & 0170000;
+
+        if( type != 0100000 && type != 0120000 ) continue;
+
+        unsigned const stage = ( flags >> 12 ) & 3;
+
+        if( stage != 0 && stage != 2 ) continue;
+
+        if( extended & 0x4000 ) continue;
+
+        files.push_back( name );
+    }
+
+    std::sort( files.begin(), files.end() );
+    return true;
+}
+
+// the git directory of the work tree at dir: dir/.git, or the directory
+// named by the "gitdir:" line of dir/.git, as in submodules
+static bool find_git_dir( fs::path const & dir, fs::path & git_dir )
+{
+    fs::path dot_git = root_path( dir ) / ".git";
+
+    if( fs::is_directory( dot_git ) )
+    {
+        git_dir = dot_git;
+        return true;
+    }
+
+    fs::ifstream is( dot_git );
+    std::string line;
+
+    if( !std::getline( is, line ) || line.compare( 0, 8, "gitdir: " ) != 0 ) return false;
+
+    line.erase( 0, 8 );
+
+    if( !line.empty() && line[ line.size() - 1 ] == '\r' )
+    {
+        line.erase( line.size() - 1 );
+    }
+
+    git_dir = fs::path( line );
+
+    if( !git_dir.is_absolute() )
+    {
+        git_dir = root_path( dir ) / git_dir;
+    }
+
+    return true;
+}
+
+// the files tracked by git under dir, relative to dir; returns false
+// when dir isn't in a git work tree that has an index
+static bool list_tracked_files( fs::path const & dir, std::vector< std::string > & files )
+{
+    // the closest enclosing work tree, within the root
+
+    fs::path work_tree = dir;
+    fs::path git_dir;
+
+    while( !find_git_dir( work_tree, git_dir ) )
+    {
+        if( work_tree.empty() ) return false;
+        work_tree = work_tree.parent_path();
+    }
+
+    std::string const key = work_tree.generic_string();
+
+    std::map< std::string, std::vector< std::string > >::iterator i = s_context->git_indexes_.find( key );
+
+    if( i == s_context->git_indexes_.end() )
+    {
+        std::vector< std::string > index;
+
+        if( !read_git_index( git_dir / "index", index ) ) return false;
+
+        i = s_context->git_indexes_.insert( std::make_pair( key, std::vector< std::string >() ) ).first;
+        i->second.swap( index );
+    }
+
+    // dir relative to the work tree, with a trailing slash
+
+    std::string prefix = dir.generic_string().substr( key.size() );
+
+    if( !prefix.empty() && prefix[ 0 ] == '/' )
+    {
+        prefix.erase( 0, 1 );
+    }
+
+    if( !prefix.empty() )
+    {
+        prefix += '/';
+    }
+
+    std::vector< std::string > const & index = i->second;
+
+    for( std::vector< std::string >::const_iterator j = std::lower_bound( index.begin(), index.end(), prefix ); j != index.end() && j->compare( 0, prefix.size(), prefix ) == 0; ++j )
+    {
+        files.push_back( j->substr( prefix.size() ) );
+    }
+
+    return true;
+}
+
+// --git-rev
+
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+// object types, as in packfiles
+enum git_object_type
+{
+    git_none = 0,
+    git_commit = 1,
+    git_tree = 2,
+    git_blob = 3,
+    git_tag = 4,
+    git_ofs_delta = 6,
+    git_ref_delta = 7
+};
+
+// the value of a hex digit, or -1
+static int git_hex_digit( char ch )
+{
+    if( ch >= '0' && ch <= '9' ) return ch - '0';
+    if( ch >= 'a' && ch <= 'f' ) return ch - 'a' + 10;
+    if( ch >= 'A' && ch <= 'F' ) return ch - 'A' + 10;
+
+    return -1;
+}
+
+static bool git_unhex( std::string const & hex, std::string & id )
+{
+    if( hex.size() != 40 ) return false;
+
+    id.resize( 20 );
+
+    for( std::size_t i = 0; i < 40; ++i )
+    {
+        int v = git_hex_digit( hex[ i ] );
+
+        if( v < 0 ) return false;
+
+        if( i % 2 == 0 )
+        {
+            id[ i / 2 ] = static_cast< char >( v << 4 );
+        }
+        else
+        {
+            id[ i / 2 ] = static_cast< char >( id[ i / 2 ] | v );
+        }
+    }
+
+    return true;
+}
+
+std::string git_hex( std::string const & id )
+{
+    static char const digits[] = "0123456789abcdef";
+
+    std::string hex;
+
+    for( std::size_t i = 0; i < id.size(); ++i )
+    {
+        unsigned char c = static_cast< unsigned char >( id[ i ] );
+
+        hex += digits[ c >> 4 ];
+        hex += digits[ c & 15 ];
+    }
+
+    return hex;
+}
+
+// inflates the zlib stream that starts at the current position of is;
+// size is the size of the result when known, or -1
+static bool git_inflate( std::istream & is, std::size_t size, std::string & out )
+{
+    z_stream zs;
+    std::memset( &zs, 0, sizeof( zs ) );
+
+    if( inflateInit( &zs ) != Z_OK ) return false;
+
+    bool const known = size != static_cast< std::size_t >( -1 );
+
+    // one byte more than needed, to detect objects that are too long
+    out.resize( known? size + 1: 4096 );
+
+    char in[ 16384 ];
+    int r = Z_OK;
+
+    while( r == Z_OK )
+    {
+        if( zs.avail_in == 0 )
+        {
+            is.read( in, sizeof( in ) );
+
+            if( is.gcount() == 0 ) break;
+
+            zs.next_in = reinterpret_cast< Bytef * >( in );
+            zs.avail_in = static_cast< uInt >( is.gcount() );
+        }
+
+        if( zs.total_out == out.size() )
+        {
+            if( known ) break;
+            out.resize( out.size() * 2 );
+        }
+
+        zs.next_out = reinterpret_cast< Bytef * >( &out[ zs.total_out ] );
+        zs.avail_out = static_cast< uInt >( out.size() - zs.total_out );
+
+        r = inflate( &zs, Z_NO_FLUSH );
+    }
+
+    out.resize( zs.total_out );
+    inflateEnd( &zs );
+
+    return r == Z_STREAM_END && ( !known || out.size() == size );
+}
+
+// applies a delta to base; see Documentation/gitformat-pack.txt
+static bool git_apply_delta( std::string const & base, std::string const & delta, std::string & out )
+{
+    unsigned char const * p = reinterpret_cast< unsigned char const * >( delta.data() );
+    unsigned char const * last = p + delta.size();
+
+    std::size_t sizes[ 2 ] = { 0, 0 };
+
+    for( int i = 0; i < 2; ++i )
+    {
+        int shift = 0;
+        unsigned char c;
+
+        do
+        {
+            if( p == last ) return false;
+
+            c = *p++;
+            sizes[ i ] |= static_cast< std::size_t >( c & 127 ) << shift;
+            shift += 7;
+        }
+        while( c & 128 );
+    }
+
+    if( sizes[ 0 ] != base.size() ) return false;
+
+    out.clear();
+    out.reserve( sizes[ 1 ] );
+
+    while( p != last )
+    {
+        unsigned char c = *p++;
+
+        if( c & 128 )
+        {
+            // copy from the base
+            std::size_t offset = 0, size = 0;
+
+            for( int i = 0; i < 4; ++i )
+            {
+                if( c & ( 1 << i ) )
+                {
+                    if( p == last ) return false;
+                    offset |= static_cast< std::size_t >( *p++ ) << ( 8 * i );
+                }
+            }
+
+            for( int i = 0; i < 3; ++i )
+            {
+                if( c & ( 16 << i ) )
+                {
+                    if( p == last ) return false;
+                    size |= static_cast< std::size_t >( *p++ ) << ( 8 * i );
+                }
+            }
+
+            if( size == 0 ) size = 0x10000;
+
+            if( offset > base.size() || size > base.size() - offset ) return false;
+
+            out.append( base, offset, size );
+        }
+        else if( c != 0 )
+        {
+            // insert the next c bytes
+            if( static_cast< std::size_t >( last - p ) < c ) return false;
+
+            out.append( reinterpret_cast< char const * >( p ), c );
+            p += c;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return out.size() == sizes[ 1 ];
+}
+
+class git_pack
+{
+private:
+
+    std::string idx_;
+    unsigned long count_;
+    bool v2_;
+
+    fs::ifstream pack_;
+
+    git_pack( git_pack const & );
+    git_pack & operator=( git_pack const & );
+
+    unsigned long be32( std::size_t pos ) const
+    {
+        unsigned char const * p = reinterpret_cast< unsigned char const * >( idx_.data() ) + pos;
+        return ( static_cast< unsigned long >( p[ 0 ] ) << 24 ) | ( p[ 1 ] << 16 ) | ( p[ 2 ] << 8 ) | p[ 3 ];
+    }
+
+public:
+
+    git_pack(): count_(), v2_()
+    {
+    }
+
+    bool open( fs::path const & idx )
+    {
+        fs::ifstream is( idx, std::ios_base::binary );
+
+        if( !is ) return false;
+
+        std::ostringstream os;
+        os << is.rdbuf();
+        idx_ = os.str();
+
+        v2_ = idx_.size() >= 8 && idx_.compare( 0, 4, "\377tOc" ) == 0;
+
+        std::size_t fanout = v2_? 8: 0;
+
+        if( v2_ && be32( 4 ) != 2 ) return false;
+        if( idx_.size() < fanout + 1024 ) return false;
+
+        count_ = be32( fanout + 255 * 4 );
+
+        std::size_t const need = v2_? 8 + 1024 + count_ * 28: 1024 + count_ * 24;
+
+        if( idx_.size() < need ) return false;
+
+        fs::path pack = idx;
+        pack.replace_extension( ".pack" );
+
+        pack_.open( pack, std::ios_base::binary );
+
+        return pack_.is_open();
+    }
+
+    // the offset of the object id in the packfile
+    bool find( std::string const & id, unsigned long long & offset ) const
+    {
+        std::size_t const fanout = v2_? 8: 0;
+        unsigned char const first = static_cast< unsigned char >( id[ 0 ] );
+
+        unsigned long lo = first == 0? 0: be32( fanout + ( first - 1 ) * 4 );
+        unsigned long hi = be32( fanout + first * 4 );
+
+        std::size_t const ids = fanout + 1024;
+        std::size_t const stride = v2_? 20: 24;
+        std::size_t const skip = v2_? 0: 4;
+
+        while( lo < hi )
+        {
+            unsigned long mid = lo + ( hi - lo ) / 2;
+            int r = idx_.compare( ids + mid * stride + skip, 20, id );
+
+            if( r < 0 )
+            {
+                lo = mid + 1;
+            }
+            else if( r > 0 )
+            {
+                hi = mid;
+            }
+            else
+            {
+                if( !v2_ )
+                {
+                    offset = be32( ids + mid * stride );
+                    return true;
+                }
+
+                std::size_t const offsets = ids + count_ * 24;
+                unsigned long v = be32( offsets + mid * 4 );
+
+                if( v & 0x80000000ul )
+                {
+                    // an index into the table of 64 bit offsets
+                    std::size_t const k = offsets + count_ * 4 + ( v & 0x7ffffffful ) * 8;
+
+                    if( k + 8 > idx_.size() ) return false;
+
+                    offset = ( static_cast< unsigned long long >( be32( k ) ) << 32 ) | be32( k + 4 );
+                }
+                else
+                {
+                    offset = v;
+                }
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // adds the ids that start with prefix, at least two lowercase hex
+    // digits, to ids
+    void find_prefix( std::string const & prefix, std::set< std::string > & ids ) const
+    {
+        std::size_t const fanout = v2_? 8: 0;
+        unsigned const first = git_hex_digit( prefix[ 0 ] ) * 16 + git_hex_digit( prefix[ 1 ] );
+
+        unsigned long lo = first == 0? 0: be32( fanout + ( first - 1 ) * 4 );
+        unsigned long hi = be32( fanout + first * 4 );
+
+        std::size_t const ids_pos = fanout + 1024;
+        std::size_t const stride = v2_? 20: 24;
+        std::size_t const skip = v2_? 0: 4;
+
+        // the ids of a fanout bucket are few, so compare them all
+        for( unsigned long i = lo; i < hi; ++i )
+        {
+            std::string const id = idx_.substr( ids_pos + i * stride + skip, 20 );
+
+            if( git_hex( id ).compare( 0, prefix.size(), prefix ) == 0 )
+            {
+                ids.insert( id );
+            }
+        }
+    }
+
+    std::istream & stream()
+    {
+        return pack_;
+    }
+};
+
+// the objects of a git repository, from loose objects and packfiles
+class git_repository
+{
+private:
+
+    fs::path git_dir_;
+    std::vector< git_pack * > packs_;
+
+    // recently used bases of deltas; pack, offset -> type, data
+    std::map< std::pair< std::size_t, unsigned long long >, std::pair< int, std::string > > bases_;
+    std::size_t bases_size_;
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+    std::mutex mutex_;
+
+#endif
+
+    git_repository( git_repository const & );
+    git_repository & operator=( git_repository const & );
+
+    bool read_loose( std::string const & id, int & type, std::string & data )
+    {
+        std::string const hex = git_hex( id );
+
+        fs::ifstream is( git_dir_ / "objects" / hex.substr( 0, 2 ) / hex.substr( 2 ), std::ios_base::binary );
+
+        if( !is ) return false;
+
+        std::string object;
+
+        if( !git_inflate( is, static_cast< std::size_t >( -1 ), object ) ) return false;
+
+        // "<type> <size>\0<data>"
+
+        std::string::size_type k = object.find( '\0' );
+
+        if( k == std::string::npos ) return false;
+
+        std::string const header = object.substr( 0, k );
+
+        if( header.compare( 0, 7, "commit " ) == 0 ) type = git_commit;
+        else if( header.compare( 0, 5, "tree " ) == 0 ) type = git_tree;
+        else if( header.compare( 0, 5, "blob " ) == 0 ) type = git_blob;
+        else if( header.compare( 0, 4, "tag " ) == 0 ) type = git_tag;
+        else return false;
+
+        data.assign( object, k + 1, std::string::npos );
+        return true;
+    }
+
+    bool read_packed( std::size_t pack, unsigned long long offset, int & type, std::string & data, int depth )
+    {
+        if( depth > 64 ) return false;
+
+        std::map< std::pair< std::size_t, unsigned long long >, std::pair< int, std::string > >::const_iterator i = bases_.find( std::make_pair( pack, offset ) );
+
+        if( i != bases_.end() )
+        {
+            type = i->second.first;
+            data = i->second.second;
+
+            return true;
+        }
+
+        std::istream & is = packs_[ pack ]->stream();
+
+        is.clear();
+        is.seekg( static_cast< std::streamoff >( offset ) );
+
+        // the type and the size of the object, or of the delta
+
+        int c = is.get();
+
+        if( c == EOF ) return false;
+
+        type = ( c >> 4 ) & 7;
+
+        std::size_t size = c & 15;
+        int shift = 4;
+
+        while( c & 128 )
+        {
+            c = is.get();
+
+            if( c == EOF ) return false;
+
+            size |= static_cast< std::size_t >( c & 127 ) << shift;
+            shift += 7;
+        }
+
+        if( type == git_ofs_delta || type == git_ref_delta )
+        {
+            std::string base_id;
+            unsigned long long base_offset = 0;
+
+            if( type == git_ofs_delta )
+            {
+                c = is.get();
+
+                if( c == EOF ) return false;
+
+                unsigned long long back = c & 127;
+
+                while( c & 128 )
+                {
+                    c = is.get();
+
+                    if( c == EOF ) return false;
+
+                    back = ( ( back + 1 ) << 7 ) | ( c & 127 );
+                }
+
+                if( back > offset ) return false;
+
+                base_offset = offset - back;
+            }
+            else
+            {
+                base_id.resize( 20 );
+
+                if( !is.read( &base_id[ 0 ], 20 ) ) return false;
+            }
+
+            std::string delta;
+
+            if( !git_inflate( is, size, delta ) ) return false;
+
+            std::string base;
+
+            if( type == git_ofs_delta )
+            {
+                if( !read_packed( pack, base_offset, type, base, depth + 1 ) ) return false;
+            }
+            else
+            {
+                if( !read( base_id, type, base, depth + 1 ) ) return false;
+            }
+
+            if( !git_apply_delta( base, delta, data ) ) return false;
+        }
+        else
+        {
+            if( type < git_commit || type > git_tag ) return false;
+
+            if( !git_inflate( is, size, data ) ) return false;
+        }
+
+        // trees and deltified objects tend to share bases
+        if( type != git_blob )
+        {
+            if( bases_size_ > 64 * 1024 * 1024 )
+            {
+                bases_.clear();
+                bases_size_ = 0;
+            }
+
+            bases_[ std::make_pair( pack, offset ) ] = std::make_pair( type, data );
+            bases_size_ += data.size();
+        }
+
+        return true;
+    }
+
+    bool read( std::string const & id, int & type, std::string & data, int depth )
+    {
+        for( std::size_t i = 0; i < packs_.size(); ++i )
+        {
+            unsigned long long offset;
+
+            if( packs_[ i ]->find( id, offset ) )
+            {
+                return read_packed( i, offset, type, data, depth );
+            }
+        }
+
+        return read_loose( id, type, data );
+    }
+
+public:
+
+    git_repository(): bases_size_( 0 )
+    {
+    }
+
+    ~git_repository()
+    {
+        for( std::size_t i = 0; i < packs_.size(); ++i )
+        {
+            delete packs_[ i ];
+        }
+    }
+
+    bool open( fs::path const & git_dir )
+    {
+        git_dir_ = git_dir;
+
+        if( !fs::is_directory( git_dir / "objects" ) ) return false;
+
+        fs::path const pack_dir = git_dir / "objects" / "pack";
+
+        if( fs::is_directory( pack_dir ) )
+        {
+            for( fs::directory_iterator it( pack_dir ), last; it != last; ++it )
+            {
+                if( it->path().extension() != ".idx" ) continue;
+
+                git_pack * pack = new git_pack;
+
+                if( pack->open( it->path() ) )
+                {
+                    packs_.push_back( pack );
+                }
+                else
+                {
+                    delete pack;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    fs::path const & git_dir() const
+    {
+        return git_dir_;
+    }
+
+    bool read( std::string const & id, int & type, std::string & data )
+    {
+#if defined(BOOSTDEP_HAS_THREADS)
+        std::lock_guard< std::mutex > lock( mutex_ );
+#endif
+
+        return read( id, type, data, 0 );
+    }
+
+    // adds the ids of the objects that start with prefix, at least two
+    // lowercase hex digits, to ids
+    void find_prefix( std::string const & prefix, std::set< std::string > & ids ) const
+    {
+        for( std::size_t i = 0; i < packs_.size(); ++i )
+        {
+            packs_[ i ]->find_prefix( prefix, ids );
+        }
+
+        fs::path const dir = git_dir_ / "objects" / prefix.substr( 0, 2 );
+
+        if( !fs::is_directory( dir ) ) return;
+
+        for( fs::directory_iterator it( dir ), last; it != last; ++it )
+        {
+            std::string const hex = prefix.substr( 0, 2 ) + it->path().filename().string();
+            std::string id;
+
+            if( hex.compare( 0, prefix.size(), prefix ) == 0 && git_unhex( hex, id ) )
+            {
+                ids.insert( id );
+            }
+        }
+    }
+
+    // resolves a full or abbreviated object id, or a branch, tag or other
+    // ref; a ref takes precedence over an abbreviated id, as in git
+    bool resolve_name( std::string const & name, std::string & id ) const
+    {
+        if( git_unhex( name, id ) ) return true;
+
+        char const * prefixes[] = { "", "refs/", "refs/tags/", "refs/heads/", "refs/remotes/" };
+
+        for( std::size_t i = 0; i < sizeof( prefixes ) / sizeof( prefixes[ 0 ] ); ++i )
+        {
+            if( resolve_ref( prefixes[ i ] + name, id, 0 ) ) return true;
+        }
+
+        if( name.size() >= 4 && name.size() < 40 && name.find_first_not_of( "0123456789abcdefABCDEF" ) == std::string::npos )
+        {
+            std::string prefix( name );
+
+            for( std::size_t i = 0; i < prefix.size(); ++i )
+            {
+                prefix[ i ] = static_cast< char >( std::tolower( static_cast< unsigned char >( prefix[ i ] ) ) );
+            }
+
+            std::set< std::string > ids;
+            find_prefix( prefix, ids );
+
+            if( ids.size() == 1 )
+            {
+                id = *ids.begin();
+                return true;
+            }
+
+            if( ids.size() > 1 )
+            {
+                std::cerr << "'" << name << "': abbreviated object id is ambiguous.\n";
+            }
+        }
+
+        return false;
+    }
+
+    // resolves a revision, a name as above followed by any number of ~n,
+    // the nth first-parent ancestor, and ^n, the nth parent, where n
+    // defaults to 1 and ^0 is the commit itself
+    bool resolve( std::string const & rev, std::string & id )
+    {
+        std::string::size_type k = rev.find_first_of( "~^" );
+
+        if( !resolve_name( rev.substr( 0, k ), id ) ) return false;
+
+        while( k != std::string::npos )
+        {
+            char const op = rev[ k ];
+
+            std::string::size_type k2 = rev.find_first_of( "~^", k + 1 );
+            std::string const arg = rev.substr( k + 1, k2 == std::string::npos? std::string::npos: k2 - k - 1 );
+
+            k = k2;
+
+            unsigned long n = 1;
+
+            if( !arg.empty() )
+            {
+                if( arg.find_first_not_of( "0123456789" ) != std::string::npos ) return false;
+                n = std::strtoul( arg.c_str(), 0, 10 );
+            }
+
+            git_commit_info c;
+
+            if( op == '^' )
+            {
+                if( !read_commit( id, c ) || n > c.parents.size() ) return false;
+
+                id = n == 0? c.id: c.parents[ n - 1 ];
+            }
+            else
+            {
+                for( ; n > 0; --n )
+                {
+                    if( !read_commit( id, c ) || c.parents.empty() ) return false;
+
+                    id = c.parents[ 0 ];
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool resolve_ref( std::string const & ref, std::string & id, int depth ) const
+    {
+        if( depth > 8 ) return false;
+
+        {
+            fs::ifstream is( git_dir_ / ref );
+            std::string line;
+
+            if( std::getline( is, line ) )
+            {
+                if( line.compare( 0, 5, "ref: " ) == 0 )
+                {
+                    return resolve_ref( line.substr( 5 ), id, depth + 1 );
+                }
+
+                return git_unhex( line.substr( 0, 40 ), id );
+            }
+        }
+
+        fs::ifstream is( git_dir_ / "packed-refs" );
+        std::string line;
+
+        while( std::getline( is, line ) )
+        {
+            if( line.size() > 41 && line[ 40 ] == ' ' && line.substr( 41 ) == ref )
+            {
+                return git_unhex( line.substr( 0, 40 ), id );
+            }
+        }
+
+        return false;
+    }
+
+    // the tree of a commit, or of the commit a tag points to
+    bool commit_tree( std::string id, std::string & tree )
+    {
+        for( int i = 0; i < 8; ++i )
+        {
+            int type;
+            std::string data;
+
+            if( !read( id, type, data ) ) return false;
+
+            if( type == git_tree )
+            {
+                tree = id;
+                return true;
+            }
+
+            char const * field = type == git_commit? "tree ": type == git_tag? "object ": 0;
+
+            if( field == 0 ) return false;
+
+            std::size_t const n = std::strlen( field );
+
+            if( data.compare( 0, n, field ) != 0 || !git_unhex( data.substr( n, 40 ), id ) ) return false;
+        }
+
+        return false;
+    }
+
+    // the commit id, or the commit a tag points to
+    bool read_commit( std::string id, git_commit_info & commit )
+    {
+        for( int i = 0; i < 8; ++i )
+        {
+            int type;
+            std::string data;
+
+            if( !read( id, type, data ) ) return false;
+
+            if( type == git_tag )
+            {
+                if( data.compare( 0, 7, "object " ) != 0 || !git_unhex( data.substr( 7, 40 ), id ) ) return false;
+                continue;
+            }
+
+            if( type != git_commit ) return false;
+
+            commit.id = id;
+            commit.parents.clear();
+            commit.time = 0;
+
+            // the header lines end at the first empty line
+            std::istringstream is( data );
+            std::string line;
+
+            while( std::getline( is, line ) && !line.empty() )
+            {
+                std::string parent;
+
+                if( line.compare( 0, 5, "tree " ) == 0 )
+                {
+                    git_unhex( line.substr( 5, 40 ), commit.tree );
+                }
+                else if( line.compare( 0, 7, "parent " ) == 0 && git_unhex( line.substr( 7, 40 ), parent ) )
+                {
+                    commit.parents.push_back( parent );
+                }
+                else if( line.compare( 0, 10, "committer " ) == 0 )
+                {
+                    // "committer <name> <<email>> <time> <zone>"
+                    std::string::size_type k = line.rfind( '>' );
+
+                    if( k != std::string::npos )
+                    {
+                        std::istringstream ts( line.substr( k + 1 ) );
+                        ts >> commit.time;
+                    }
+                }
+            }
+
+            return !commit.tree.empty();
+        }
+
+        return false;
+    }
+};
+
+struct git_entry
+{
+    std::string name;
+    unsigned long mode;
+    std::string id;
+};
+
+static bool git_parse_tree( std::string const & data, std::vector< git_entry > & entries )
+{
+    // "<octal mode> <name>\0<20 byte id>"...
+
+    std::size_t pos = 0;
+
+    while( pos < data.size() )
+    {
+        std::string::size_type k = data.find( ' ', pos );
+        std::string::size_type k2 = data.find( '\0', k );
+
+        if( k == std::string::npos || k2 == std::string::npos || k2 + 21 > data.size() ) return false;
+
+        git_entry e;
+
+        e.mode = std::strtoul( data.substr( pos, k - pos ).c_str(), 0, 8 );
+        e.name = data.substr( k + 1, k2 - k - 1 );
+        e.id = data.substr( k2 + 1, 20 );
+
+        entries.push_back( e );
+
+        pos = k2 + 21;
+    }
+
+    return true;
+}
+
+// the superproject and the submodules, shared by the revisions read
+// from them; also remembers the #includes of each blob, so that a file
+// is parsed once however many times it appears
+class git_store
+{
+private:
+
+    git_repository super_;
+    fs::path work_tree_;
+
+    // submodule name -> repository, 0 if not found
+    std::map< std::string, git_repository * > submodules_;
+
+    // blob id -> #includes
+    std::map< std::string, file_includes > parsed_;
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+    std::mutex mutex_;
+
+#endif
+
+    git_store( git_store const & );
+    git_store & operator=( git_store const & );
+
+public:
+
+    git_store()
+    {
+    }
+
+    ~git_store()
+    {
+        for( std::map< std::string, git_repository * >::iterator i = submodules_.begin(); i != submodules_.end(); ++i )
+        {
+            delete i->second;
+        }
+    }
+
+    // root is a work tree with a .git directory or file, or a bare repository
+    bool open( fs::path const & root )
+    {
+        work_tree_ = root;
+
+        fs::path git_dir;
+
+        if( find_git_dir( root, git_dir ) && super_.open( git_dir ) ) return true;
+
+        work_tree_.clear();
+        return super_.open( root );
+    }
+
+    git_repository & superproject()
+    {
+        return super_;
+    }
+
+    // the repository of the submodule name at path; submodules are
+    // looked for in modules/<name> in the git directory of the
+    // superproject, then in the work tree
+    git_repository * submodule( std::string const & name, std::string const & path )
+    {
+#if defined(BOOSTDEP_HAS_THREADS)
+        std::lock_guard< std::mutex > lock( mutex_ );
+#endif
+
+        std::map< std::string, git_repository * >::iterator i = submodules_.find( name );
+
+        if( i != submodules_.end() ) return i->second;
+
+        git_repository * repo = new git_repository;
+
+        fs::path git_dir;
+
+        if( !repo->open( super_.git_dir() / "modules" / name ) && ( work_tree_.empty() || !find_git_dir( work_tree_ / path, git_dir ) || !repo->open( git_dir ) ) )
+        {
+            std::cerr << "boostdep: submodule '" << name << "' not found; its files are skipped.\n";
+
+            delete repo;
+            repo = 0;
+        }
+
+        submodules_[ name ] = repo;
+        return repo;
+    }
+
+    // the #includes of a blob, parsed on first use
+    bool parse( git_repository & repo, std::string const & id, file_includes & f )
+    {
+        {
+#if defined(BOOSTDEP_HAS_THREADS)
+            std::lock_guard< std::mutex > lock( mutex_ );
+#endif
+
+            std::map< std::string, file_includes >::const_iterator i = parsed_.find( id );
+
+            if( i != parsed_.end() )
+            {
+                f = i->second;
+                return true;
+            }
+        }
+
+        int type;
+        std::string data;
+
+        if( !repo.read( id, type, data ) || type != git_blob ) return false;
+
+        parse_includes( data, f, !s_context->configs_.empty() );
+
+#if defined(BOOSTDEP_HAS_THREADS)
+        std::lock_guard< std::mutex > lock( mutex_ );
+#endif
+
+        parsed_[ id ] = f;
+        return true;
+    }
+};
+
+// the files of one revision of the superproject, with the trees of the
+// submodules in place of their commits
+class git_revision
+{
+private:
+
+    struct directory
+    {
+        git_repository * repo;
+        std::vector< git_entry > entries;
+    };
+
+    git_store & store_;
+
+    // submodule path -> name, from .gitmodules
+    std::map< std::string, std::string > submodules_;
+
+    // path -> directory, "" for the root; 0 if it doesn't exist
+    std::map< std::string, directory * > dirs_;
+
+    git_revision( git_revision const & );
+    git_revision & operator=( git_revision const & );
+
+    void read_gitmodules()
+    {
+        directory const * root = find( "" );
+
+        for( std::vector< git_entry >::const_iterator i = root->entries.begin(); i != root->entries.end(); ++i )
+        {
+            if( i->name != ".gitmodules" ) continue;
+
+            int type;
+            std::string data;
+
+            if( !root->repo->read( i->id, type, data ) ) return;
+
+            std::istringstream is( data );
+            std::string line, name;
+
+            while( std::getline( is, line ) )
+            {
+                std::string::size_type k = line.find_first_not_of( " \t" );
+
+                if( k == std::string::npos ) continue;
+
+                line.erase( 0, k );
+
+                if( line.compare( 0, 12, "[submodule \"" ) == 0 )
+                {
+                    name = line.substr( 12, line.find( '"', 12 ) - 12 );
+                }
+                else if( line.compare( 0, 4, "path" ) == 0 && !name.empty() )
+                {
+                    k = line.find( '=' );
+
+                    if( k == std::string::npos ) continue;
+
+                    k = line.find_first_not_of( " \t", k + 1 );
+
+                    if( k == std::string::npos ) continue;
+
+                    std::string path = line.substr( k );
+
+                    while( !path.empty() && ( path[ path.size() - 1 ] == ' ' || path[ path.size() - 1 ] == '\r' ) )
+                    {
+                        path.erase( path.size() - 1 );
+                    }
+
+                    submodules_[ path ] = name;
+                }
+            }
+        }
+    }
+
+    directory * load( git_repository & repo, std::string const & tree )
+    {
+        int type;
+        std::string data;
+
+        directory * dir = new directory;
+        dir->repo = &repo;
+
+        if( !repo.read( tree, type, data ) || type != git_tree || !git_parse_tree( data, dir->entries ) )
+        {
+            delete dir;
+            return 0;
+        }
+
+        return dir;
+    }
+
+public:
+
+    git_revision( git_store & store, std::string const & tree ): store_( store )
+    {
+        dirs_[ "" ] = load( store.superproject(), tree );
+
+        if( dirs_[ "" ] ) read_gitmodules();
+    }
+
+    ~git_revision()
+    {
+        for( std::map< std::string, directory * >::iterator i = dirs_.begin(); i != dirs_.end(); ++i )
+        {
+            delete i->second;
+        }
+    }
+
+    bool valid() const
+    {
+        return dirs_.find( "" )->second != 0;
+    }
+
+    git_store & store()
+    {
+        return store_;
+    }
+
+    // the directory at path, relative to the root, or 0
+    directory const * find( std::string const & path )
+    {
+        std::map< std::string, directory * >::const_iterator i = dirs_.find( path );
+
+        if( i != dirs_.end() ) return i->second;
+
+        directory * dir = 0;
+
+        std::string::size_type k = path.rfind( '/' );
+
+        std::string const parent_path = k == std::string::npos? std::string(): path.substr( 0, k );
+        std::string const name = k == std::string::npos? path: path.substr( k + 1 );
+
+        if( directory const * parent = find( parent_path ) )
+        {
+            for( std::vector< git_entry >::const_iterator j = parent->entries.begin(); j != parent->entries.end(); ++j )
+            {
+                if( j->name != name ) continue;
+
+                if( ( j->mode & 0170000 ) == 040000 )
+                {
+                    dir = load( *parent->repo, j->id );
+                }
+                else if( ( j->mode & 0170000 ) == 0160000 )
+                {
+                    // a submodule; its commit is in its own repository
+
+                    std::map< std::string, std::string >::const_iterator m = submodules_.find( path );
+
+                    git_repository * repo = store_.submodule( m != submodules_.end()? m->second: path, path );
+                    std::string tree;
+
+                    if( repo && repo->commit_tree( j->id, tree ) )
+                    {
+                        dir = load( *repo, tree );
+                    }
+                }
+
+                break;
+            }
+        }
+
+        dirs_[ path ] = dir;
+        return dir;
+    }
+
+    bool is_directory( std::string const & path )
+    {
+        return find( path ) != 0;
+    }
+
+    bool exists( std::string const & path )
+    {
+        if( find( path ) ) return true;
+
+        git_repository * repo;
+        std::string id;
+
+        return find_file( path, repo, id );
+    }
+
+    // the blob of the file at path
+    bool find_file( std::string const & path, git_repository * & repo, std::string & id )
+    {
+        std::string::size_type k = path.rfind( '/' );
+
+        directory const * parent = find( k == std::string::npos? std::string(): path.substr( 0, k ) );
+
+        if( parent == 0 ) return false;
+
+        std::string const name = k == std::string::npos? path: path.substr( k + 1 );
+
+        for( std::vector< git_entry >::const_iterator j = parent->entries.begin(); j != parent->entries.end(); ++j )
+        {
+            unsigned long const type = j->mode & 0170000;
+
+            if( j->name == name && ( type == 0100000 || type == 0120000 ) )
+            {
+                repo = parent->repo;
+                id = j->id;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // the files under dir, recursively, relative to dir
+    void list_files( std::string const & dir, std::string const & prefix, std::vector< std::string > & files )
+    {
+        directory const * d = find( dir );
+
+        if( d == 0 ) return;
+
+        for( std::vector< git_entry >::const_iterator i = d->entries.begin(); i != d->entries.end(); ++i )
+        {
+            unsigned long const type = i->mode & 0170000;
+
+            if( type == 040000 || type == 0160000 )
+            {
+                list_files( dir + '/' + i->name, prefix + i->name + '/', files );
+            }
+            else if( type == 0100000 || type == 0120000 )
+            {
+                files.push_back( prefix + i->name );
+            }
+        }
+    }
+
+    // the subdirectories of dir
+    void list_directories( std::string const & dir, std::vector< std::string > & dirs )
+    {
+        directory const * d = find( dir );
+
+        if( d == 0 ) return;
+
+        for( std::vector< git_entry >::const_iterator i = d->entries.begin(); i != d->entries.end(); ++i )
+        {
+            unsigned long const type = i->mode & 0170000;
+
+            if( type == 040000 || type == 0160000 )
+            {
+                dirs.push_back( i->name );
+            }
+        }
+    }
+
+    // the #includes of the file at path
+    bool parse( std::string const & path, file_includes & f )
+    {
+        git_repository * repo;
+        std::string id;
+
+        return find_file( path, repo, id ) && store_.parse( *repo, id, f );
+    }
+
+    // the contents of the file at path
+    bool read( std::string const & path, std::string & text )
+    {
+        git_repository * repo;
+        std::string id;
+        int type;
+
+        return find_file( path, repo, id ) && repo->read( id, type, text ) && type == git_blob;
+    }
+};
+
+// the revision rev of the superproject, or 0 after printing an error
+static git_revision * open_git_revision( git_store & store, std::string const & rev )
+{
+    git_repository & repo = store.superproject();
+
+    std::string id, tree;
+
+    if( !repo.resolve( rev, id ) || !repo.commit_tree( id, tree ) )
+    {
+        std::cerr << "'" << rev << "': not a valid revision.\n";
+        return 0;
+    }
+
+    git_revision * r = new git_revision( store, tree );
+
+    if( !r->valid() || !r->exists( "Jamroot" ) )
+    {
+        std::cerr << "'" << rev << "': not a valid Boost root.\n";
+
+        delete r;
+        return 0;
+    }
+
+    return r;
+}
+
+git_revision_root::git_revision_root(): store_( 0 ), revision_( 0 )
+{
+}
+
+git_revision_root::~git_revision_root()
+{
+    delete revision_;
+    delete store_;
+}
+
+git_revision * git_revision_root::open( fs::path const & root, std::string const & rev )
+{
+    store_ = new git_store;
+
+    if( !store_->open( root ) )
+    {
+        std::cerr << "'" << root.string() << "': not a git repository.\n";
+        return 0;
+    }
+
+    revision_ = open_git_revision( *store_, rev );
+    return revision_;
+}
+
+#endif // defined(BOOSTDEP_HAS_ZLIB)
+
+// the files under dir, relative to it: from the revision given by
+// --git-rev (for paths relative to the root), from the git index with
+// --use-git-index, or from dir itself
+static void list_module_files( fs::path const & dir, std::vector< std::string > & files )
+{
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+    if( s_context->git_ && !dir.is_absolute() )
+    {
+        s_context->git_->list_files( dir.generic_string(), "", files );
+        return;
+    }
+
+#endif
+
+    if( s_context->use_git_index_ && list_tracked_files( dir, files ) )
+    {
+        return;
+    }
+
+    fs::path const dir2 = root_path( dir );
+
+    if( !fs::exists( dir2 ) ) return;
+
+    size_t n = dir2.generic_string().size();
+
+    fs::recursive_directory_iterator it( dir2 ), last;
+
+    for( ; it != last; ++it )
+    {
+        if( it->status().type() == fs::directory_file )
+        {
+            continue;
+        }
+
+        files.push_back( it->path().generic_string().substr( n + 1 ) );
+    }
+}
+
+// whether the file or directory at path, relative to the root, exists
+bool root_exists( fs::path const & path )
+{
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+    if( s_context->git_ && !path.is_absolute() )
+    {
+        return s_context->git_->exists( path.generic_string() );
+    }
+
+#endif
+
+    return fs::exists( root_path( path ) );
+}
+
+// adds the headers in the include directory of module to the header map
+void map_module_headers( std::string const & module )
+{
+    try
+    {
+        s_context->modules_.insert( module );
+
+        std::vector< std::string > files;
+        list_module_files( module_include_path( module ), files );
+
+        for( std::vector< std::string >::const_iterator i = files.begin(); i != files.end(); ++i )
+        {
+            s_context->header_map_[ *i ] = module;
+            s_context->module_headers_[ module ].insert( *i );
+        }
+    }
+    catch( fs::filesystem_error const & x )
+    {
+        std::cout << x.what() << std::endl;
+    }
+}
+
+// the module at path, libs/m or libs/m/s for the sublibrary m~s
+static std::string module_name( fs::path const & path )
+{
+    std::string module = path.generic_string().substr( 5 ); // strip "libs/"
+
+    std::replace( module.begin(), module.end(), '/', '~' );
+
+    return module;
+}
+
+static void scan_module_headers( fs::path const & path )
+{
+    map_module_headers( module_name( path ) );
+}
+
+static void scan_submodules( fs::path const & path )
+{
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+    if( s_context->git_ )
+    {
+        std::vector< std::string > dirs;
+        s_context->git_->list_directories( path.generic_string(), dirs );
+
+        for( std::vector< std::string >::const_iterator i = dirs.begin(); i != dirs.end(); ++i )
+        {
+            fs::path path2 = path / *i;
+
+            if( root_exists( path2 / "include" ) )
+            {
+                scan_module_headers( path2 );
+            }
+
+            if( root_exists( path2 / "sublibs" ) )
+            {
+                scan_submodules( path2 );
+            }
+        }
+
+        return;
+    }
+
+#endif
+
+    fs::directory_iterator it( root_path( path ) ), last;
+
+    for( ; it != last; ++it )
+    {
+        fs::directory_entry const & e = *it;
+
+        if( e.status().type() != fs::directory_file )
+        {
+            continue;
+        }
+
+        // module names are derived from the path relative to the root
+        fs::path path2 = path / e.path().filename();
+
+        if( fs::exists( e.path() / "include" ) )
+        {
+            scan_module_headers( path2 );
+        }
+
+        if( fs::exists( e.path() / "sublibs" ) )
+        {
+            scan_submodules( path2 );
+        }
+    }
+}
+
+void build_header_map()
+{
+    profile_scope ps( "build_header_map" );
+
+    scan_submodules( "libs" );
+
+    s_context->header_map_complete_ = true;
+}
+
+void enable_header_map()
+{
+    if( !s_context->header_map_complete_ )
+    {
+        try
+        {
+            build_header_map();
+        }
+        catch( fs::filesystem_error const & x )
+        {
+            std::cerr << x.what() << std::endl;
+        }
+    }
+}
+
+// on demand header resolution
+
+static fs::path exceptions_path()
+{
+    return root_path( "tools/boostdep/depinst/exceptions.txt" );
+}
+
+// reads the output of --list-exceptions; returns false if there is none
+static bool load_exceptions()
+{
+    if( s_context->exceptions_loaded_ ) return true;
+
+    fs::ifstream is( exceptions_path() );
+
+    if( !is ) return false;
+
+    std::string line, module;
+
+    while( std::getline( is, line ) )
+    {
+        if( !line.empty() && line[ line.size() - 1 ] == '\r' )
+        {
+            line.erase( line.size() - 1 );
+        }
+
+        if( line.empty() || line[ 0 ] == '#' ) continue;
+
+        if( line[ 0 ] != ' ' && line[ line.size() - 1 ] == ':' )
+        {
+            module = line.substr( 0, line.size() - 1 );
+            std::replace( module.begin(), module.end(), '/', '~' );
+        }
+        else if( !module.empty() )
+        {
+            std::string::size_type k = line.find_first_not_of( " \t" );
+
+            if( k != std::string::npos )
+            {
+                s_context->exceptions_[ line.substr( k ) ] = module;
+            }
+        }
+    }
+
+    s_context->exceptions_loaded_ = true;
+    return true;
+}
+
+// the modules under path, as scan_submodules finds them, with the names
+// at the top of their include directories
+static void list_module_roots( fs::path const & path )
+{
+    fs::directory_iterator it( root_path( path ) ), last;
+
+    for( ; it != last; ++it )
+    {
+        fs::directory_entry const & e = *it;
+
+        if( e.status().type() != fs::directory_file )
+        {
+            continue;
+        }
+
+        fs::path path2 = path / e.path().filename();
+
+        if( fs::exists( e.path() / "include" ) )
+        {
+            std::set< std::string > & roots = s_context->module_roots_[ module_name( path2 ) ];
+
+            fs::directory_iterator it2( e.path() / "include" );
+
+            for( ; it2 != last; ++it2 )
+            {
+                roots.insert( it2->path().filename().string() );
+            }
+        }
+
+        if( fs::exists( e.path() / "sublibs" ) )
+        {
+            list_module_roots( path2 );
+        }
+    }
+}
+
+static void load_module_roots()
+{
+    if( s_context->module_roots_loaded_ ) return;
+
+    s_context->module_roots_loaded_ = true;
+
+    try
+    {
+        list_module_roots( "libs" );
+    }
+    catch( fs::filesystem_error const & x )
+    {
+        std::cerr << x.what() << std::endl;
+    }
+}
+
+// whether dir/name, relative to the root, exists with exactly that name,
+// and is a directory or a file as asked
+static bool directory_has_entry( fs::path const & dir, std::string const & name, bool directory )
+{
+    std::string const key = dir.generic_string();
+
+    std::map< std::string, std::map< std::string, bool > >::iterator i = s_context->directory_entries_.find( key );
+
+    if( i == s_context->directory_entries_.end() )
+    {
+        std::map< std::string, bool > & entries = s_context->directory_entries_[ key ];
+
+        fs::path const dir2 = root_path( dir );
+
+        if( fs::is_directory( dir2 ) )
+        {
+            fs::directory_iterator it( dir2 ), last;
+
+            for( ; it != last; ++it )
+            {
+                entries[ it->path().filename().string() ] = it->status().type() == fs::directory_file;
+            }
+        }
+
+        i = s_context->directory_entries_.find( key );
+    }
+
+    std::map< std::string, bool >::const_iterator j = i->second.find( name );
+    return j != i->second.end() && j->second == directory;
+}
+
+// whether header, as written, is a file in the include directory of
+// module; names that the header map can't contain, such as a/./b.hpp,
+// a//b.hpp or those differing only in case, aren't found
+static bool module_has_header( std::string const & module, std::string const & header )
+{
+    if( !s_context->module_roots_.count( module ) ) return false;
+
+    fs::path dir = module_include_path( module );
+
+    for( std::string::size_type k = 0;; )
+    {
+        std::string::size_type k2 = header.find( '/', k );
+        std::string const name = header.substr( k, k2 - k );
+
+        if( name.empty() || name == "." || name == ".." ) return false;
+
+        if( k2 == std::string::npos )
+        {
+            return directory_has_entry( dir, name, false );
+        }
+
+        if( !directory_has_entry( dir, name, true ) ) return false;
+
+        dir /= name;
+        k = k2 + 1;
+    }
+}
+
+// finds the module of header from the Boost naming conventions (boost/m.hpp
+// or boost/m/..., boost/m/s/... for the sublibrary m~s), from the list of
+// exceptions, and, for headers outside boost/, from the modules that have
+// their first directory; returns false when this can't decide, else true,
+// with an empty module when header isn't in a module
+static bool resolve_header_module( std::string const & header, std::string & module )
+{
+    load_module_roots();
+
+    std::map< std::string, std::string >::const_iterator i = s_context->exceptions_.find( header );
+
+    if( i != s_context->exceptions_.end() )
+    {
+        module = i->second;
+        return module_has_header( module, header );
+    }
+
+    if( header.compare( 0, 6, "boost/" ) != 0 )
+    {
+        std::string const root = header.substr( 0, header.find( '/' ) );
+
+        std::vector< std::string > found;
+
+        for( std::map< std::string, std::set< std::string > >::const_iterator j = s_context->module_roots_.begin(); j != s_context->module_roots_.end(); ++j )
+        {
+            if( j->second.count( root ) && module_has_header( j->first, header ) )
+            {
+                found.push_back( j->first );
+            }
+        }
+
+        // a header in several modules is left to the header map
+        if( found.size() > 1 ) return false;
+
+        module = found.empty()? std::string(): found.front();
+        return true;
+    }
+
+    std::string path = header.substr( 6 );
+
+    // candidate modules, longest first
+
+    std::vector< std::string > candidates;
+
+    if( path.size() > 4 && path.compare( path.size() - 4, 4, ".hpp" ) == 0 )
+    {
+        candidates.push_back( path.substr( 0, path.size() - 4 ) );
+    }
+
+    for( std::string::size_type k = path.rfind( '/' ); k != std::string::npos && k != 0; k = path.rfind( '/', k - 1 ) )
+    {
+        candidates.push_back( path.substr( 0, k ) );
+    }
+
+    std::sort( candidates.begin(), candidates.end() );
+    candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+
+    for( std::vector< std::string >::reverse_iterator j = candidates.rbegin(); j != candidates.rend(); ++j )
+    {
+        std::string m = *j;
+        std::replace( m.begin(), m.end(), '/', '~' );
+
+        if( module_has_header( m, header ) )
+        {
+            module = m;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// the module of header, or 0 if it isn't in a module; until the header
+// map is complete, the header is resolved on demand and the result is
+// remembered, and the full map is built whenever that can't decide. This
+// must not be called from several threads until then.
+static std::string const * find_header_module( std::string const & header )
+{
+    std::map< std::string, std::string >::const_iterator i = s_context->header_map_.find( header );
+
+    if( i != s_context->header_map_.end() )
+    {
+        return &i->second;
+    }
+
+    if( s_context->header_map_complete_ || s_context->unresolved_headers_.count( header ) )
+    {
+        return 0;
+    }
+
+    std::string module;
+
+    // without the exceptions, or with files that don't come from the
+    // directories, only the full walk is reliable
+    if( s_context->git_ || s_context->use_git_index_ || !load_exceptions() || !resolve_header_module( header, module ) )
+    {
+        enable_header_map();
+        return find_header_module( header );
+    }
+
+    if( module.empty() )
+    {
+        s_context->unresolved_headers_.insert( header );
+        return 0;
+    }
+
+    s_context->module_headers_[ module ].insert( header );
+    return &( s_context->header_map_[ header ] = module );
+}
+
+// is module a module; until the header map is complete, it's enough for
+// scan_submodules to find it
+bool is_module( std::string const & module )
+{
+    if( s_context->modules_.count( module ) )
+    {
+        return true;
+    }
+
+    if( s_context->header_map_complete_ || s_context->git_ ) return false;
+
+    load_module_roots();
+    return s_context->module_roots_.count( module ) != 0;
+}
+
+// makes the headers of module known, without walking all modules
+void enable_module_headers( std::string const & module )
+{
+    if( !s_context->header_map_complete_ && is_module( module ) && !s_context->modules_.count( module ) )
+    {
+        std::string path = module;
+        std::replace( path.begin(), path.end(), '~', '/' );
+
+        scan_module_headers( fs::path( "libs" ) / path );
+    }
+}
+
+void merge_scan_result( scan_result const & r )
+{
+    for( std::map< std::string, file_size >::const_iterator i = r.sizes.begin(); i != r.sizes.end(); ++i )
+    {
+        s_context->file_sizes_[ i->first ] = i->second;
+
+        if( r.unguarded.count( i->first ) )
+        {
+            s_context->unguarded_files_.insert( i->first );
+        }
+        else
+        {
+            s_context->unguarded_files_.erase( i->first );
+        }
+    }
+
+    s_context->scan_counters_.add( r.counters );
+}
+
+void add_header_dependencies( std::string const & header, file_includes const & f, scan_result & r )
+{
+    std::map< std::string, std::set< std::string > > & deps = r.deps;
+    std::map< std::string, std::set< std::string > > & from = r.from;
+
+    // with --config, included header -> condition, empty when
+    // the header is included unconditionally at least once
+    bool const track_conditions = !s_context->configs_.empty() && f.conditions.size() == f.includes.size();
+    std::map< std::string, std::string > conditions;
+
+    for( std::vector< std::string >::const_iterator i = f.includes.begin(); i != f.includes.end(); ++i )
+    {
+        std::string const & line = *i;
+
+        ++r.counters.includes;
+        ++r.counters.lookups;
+
+        if( std::string const * module = find_header_module( line ) )
+        {
+            ++r.counters.hits;
+
+            deps[ *module ].insert( line );
+            from[ line ].insert( header );
+        }
+        else if( line.substr( 0, 6 ) == "boost/" )
+        {
+            deps[ "(unknown)" ].insert( line );
+            from[ line ].insert( header );
+        }
+        else
+        {
+            continue;
+        }
+
+        if( track_conditions )
+        {
+            std::string const & c = f.conditions[ i - f.includes.begin() ];
+            std::map< std::string, std::string >::iterator j = conditions.find( line );
+
+            if( j == conditions.end() )
+            {
+                conditions[ line ] = c;
+            }
+            else if( !j->second.empty() )
+            {
+                j->second = c.empty()? c: "(" + j->second + ") || (" + c + ")";
+            }
+        }
+    }
+
+    for( std::map< std::string, std::string >::const_iterator i = conditions.begin(); i != conditions.end(); ++i )
+    {
+        if( !i->second.empty() )
+        {
+            r.conditions[ std::make_pair( header, i->first ) ] = i->second;
+        }
+    }
+
+    r.sizes[ header ] = f.size;
+    r.counters.bytes += f.size.bytes;
+
+    if( !f.guarded )
+    {
+        r.unguarded.insert( header );
+    }
+}
+
+void scan_header_dependencies( std::string const & header, std::string const & text, scan_result & r )
+{
+    file_includes f;
+
+    parse_includes( text, f, !s_context->configs_.empty() );
+    add_header_dependencies( header, f, r );
+}
+
+// reads the file at path, usually relative to the root, from the file
+// system
+bool read_file( fs::path const & path, std::string & text )
+{
+    fs::ifstream is( root_path( path ), std::ios_base::binary );
+
+    if( !is ) return false;
+
+    std::ostringstream os;
+    os << is.rdbuf();
+
+    text = os.str();
+    return true;
+}
+
+// the #include directives of the file at path, usually relative to the
+// root
+void scan_file_includes( fs::path const & path, file_includes & f )
+{
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+    if( s_context->git_ && !path.is_absolute() )
+    {
+        s_context->git_->parse( path.generic_string(), f );
+        return;
+    }
+
+#endif
+
+    std::string text;
+    read_file( path, text );
+
+    parse_includes( text, f, !s_context->configs_.empty() );
+}
+
+// scans the file at path, usually relative to the root, as header
+void scan_file( fs::path const & path, std::string const & header, scan_result & r )
+{
+    ++r.counters.files;
+
+    file_includes f;
+
+    scan_file_includes( path, f );
+    add_header_dependencies( header, f, r );
+}
+
+// --reader
+
+#if defined(__unix__) || defined(__APPLE__)
+
+// reads path with open/pread/close; leaves text empty on error
+static void pread_file( fs::path const & path, std::string & text )
+{
+    int fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+
+    if( fd < 0 ) return;
+
+    struct stat st;
+    std::size_t size = 0;
+
+    text.resize( ::fstat( fd, &st ) == 0 && st.st_size > 0? static_cast< std::size_t >( st.st_size ) + 1: 4096 );
+
+    for( ;; )
+    {
+        if( size == text.size() )
+        {
+            text.resize( text.size() * 2 );
+        }
+
+        ssize_t n = ::pread( fd, &text[ size ], text.size() - size, static_cast< off_t >( size ) );
+
+        if( n < 0 && errno == EINTR ) continue;
+        if( n <= 0 ) break;
+
+        size += static_cast< std::size_t >( n );
+    }
+
+    text.resize( size );
+    ::close( fd );
+}
+
+#endif
+
+#if defined(BOOSTDEP_HAS_IO_URING)
+
+// a minimal io_uring, on top of the raw system calls
+class io_uring_queue
+{
+private:
+
+    int fd_;
+
+    void * sq_ring_;
+    std::size_t sq_ring_size_;
+
+    void * cq_ring_;
+    std::size_t cq_ring_size_;
+
+    io_uring_sqe * sqes_;
+    std::size_t sqes_size_;
+
+    unsigned * sq_head_;
+    unsigned * sq_tail_;
+    unsigned sq_mask_;
+    unsigned sq_entries_;
+    unsigned * sq_array_;
+
+    unsigned * cq_head_;
+    unsigned * cq_tail_;
+    unsigned cq_mask_;
+    io_uring_cqe * cqes_;
+
+    // submission entries filled in, but not yet submitted
+    unsigned tail_;
+    unsigned pending_;
+
+    io_uring_queue( io_uring_queue const & );
+    io_uring_queue & operator=( io_uring_queue const & );
+
+    template< class T > static T * at( void * p, unsigned offset )
+    {
+        return reinterpret_cast< T * >( static_cast< char * >( p ) + offset );
+    }
+
+public:
+
+    io_uring_queue(): fd_( -1 ), sq_ring_( MAP_FAILED ), sq_ring_size_(), cq_ring_( MAP_FAILED ), cq_ring_size_(), sqes_( 0 ), sqes_size_(), tail_(), pending_()
+    {
+    }
+
+    ~io_uring_queue()
+    {
+        if( sqes_ ) ::munmap( sqes_, sqes_size_ );
+        if( cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_ ) ::munmap( cq_ring_, cq_ring_size_ );
+        if( sq_ring_ != MAP_FAILED ) ::munmap( sq_ring_, sq_ring_size_ );
+        if( fd_ >= 0 ) ::close( fd_ );
+    }
+
+    // returns false when io_uring isn't available, e.g. on kernels
+    // older than 5.6 or when disabled by a seccomp policy
+    bool open( unsigned entries )
+    {
+        io_uring_params params;
+        std::memset( &params, 0, sizeof( params ) );
+
+        fd_ = static_cast< int >( ::syscall( __NR_io_uring_setup, entries, &params ) );
+
+        if( fd_ < 0 ) return false;
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+
+        if( params.features & IORING_FEAT_SINGLE_MMAP )
+        {
+            sq_ring_size_ = cq_ring_size_ = std::max( sq_ring_size_, cq_ring_size_ );
+        }
+
+        sq_ring_ = ::mmap( 0, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING );
+
+        if( sq_ring_ == MAP_FAILED ) return false;
+
+        if( params.features & IORING_FEAT_SINGLE_MMAP )
+        {
+            cq_ring_ = sq_ring_;
+        }
+        else
+        {
+            cq_ring_ = ::mmap( 0, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING );
+
+            if( cq_ring_ == MAP_FAILED ) return false;
+        }
+
+        sqes_size_ = params.sq_entries * sizeof( io_uring_sqe );
+        void * sqes = ::mmap( 0, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES );
+
+        if( sqes == MAP_FAILED ) return false;
+
+        sqes_ = static_cast< io_uring_sqe * >( sqes );
+
+        sq_head_ = at< unsigned >( sq_ring_, params.sq_off.head );
+        sq_tail_ = at< unsigned >( sq_ring_, params.sq_off.tail );
+        sq_mask_ = *at< unsigned >( sq_ring_, params.sq_off.ring_mask );
+        sq_entries_ = *at< unsigned >( sq_ring_, params.sq_off.ring_entries );
+        sq_array_ = at< unsigned >( sq_ring_, params.sq_off.array );
+
+        cq_head_ = at< unsigned >( cq_ring_, params.cq_off.head );
+        cq_tail_ = at< unsigned >( cq_ring_, params.cq_off.tail );
+        cq_mask_ = *at< unsigned >( cq_ring_, params.cq_off.ring_mask );
+        cqes_ = at< io_uring_cqe >( cq_ring_, params.cq_off.cqes );
+
+        tail_ = *sq_tail_;
+
+        return true;
+    }
+
+    unsigned entries() const
+    {
+        return sq_entries_;
+    }
+
+    // a cleared submission entry, or 0 when the queue is full
+    io_uring_sqe * get_sqe()
+    {
+        unsigned head = __atomic_load_n( sq_head_, __ATOMIC_ACQUIRE );
+
+        if( tail_ - head >= sq_entries_ ) return 0;
+
+        unsigned index = tail_ & sq_mask_;
+
+        io_uring_sqe * sqe = &sqes_[ index ];
+        std::memset( sqe, 0, sizeof( *sqe ) );
+
+        sq_array_[ index ] = index;
+
+        ++tail_;
+        ++pending_;
+
+        return sqe;
+    }
+
+    // submits the pending entries and waits for at least wait completions
+    bool submit( unsigned wait )
+    {
+        __atomic_store_n( sq_tail_, tail_, __ATOMIC_RELEASE );
+
+        for( ;; )
+        {
+            long r = ::syscall( __NR_io_uring_enter, fd_, pending_, wait, wait? IORING_ENTER_GETEVENTS: 0, static_cast< void * >( 0 ), 0 );
+
+            if( r >= 0 )
+            {
+                pending_ -= static_cast< unsigned >( r ) < pending_? static_cast< unsigned >( r ): pending_;
+                return true;
+            }
+
+            if( errno != EINTR ) return false;
+        }
+    }
+
+    // takes a completion, if there is one
+    bool pop( io_uring_cqe & cqe )
+    {
+        unsigned head = *cq_head_;
+
+        if( head == __atomic_load_n( cq_tail_, __ATOMIC_ACQUIRE ) ) return false;
+
+        cqe = cqes_[ head & cq_mask_ ];
+        __atomic_store_n( cq_head_, head + 1, __ATOMIC_RELEASE );
+
+        return true;
+    }
+};
+
+#endif
+
+// the number of files the scans pass to file_reader::read at once; the
+// io_uring queue is as deep, so that a batch is opened and read with
+// all of its operations in flight
+static std::size_t const read_batch_size = 64;
+
+// reads batches of files, with several reads in flight when the
+// kind of reader supports it
+class file_reader
+{
+private:
+
+    reader_kind kind_;
+
+#if defined(BOOSTDEP_HAS_IO_URING)
+
+    io_uring_queue ring_;
+
+    bool read_io_uring( std::vector< fs::path > const & paths, std::vector< std::string > & texts );
+
+#endif
+
+    file_reader( file_reader const & );
+    file_reader & operator=( file_reader const & );
+
+public:
+
+    explicit file_reader( reader_kind kind ): kind_( kind )
+    {
+#if defined(BOOSTDEP_HAS_IO_URING)
+
+        if( kind_ == reader_io_uring && !ring_.open( read_batch_size ) )
+        {
+            kind_ = reader_pread;
+        }
+
+#else
+
+        if( kind_ == reader_io_uring )
+        {
+            kind_ = reader_pread;
+        }
+
+#endif
+
+#if !defined(__unix__) && !defined(__APPLE__)
+
+        kind_ = reader_stream;
+
+#endif
+    }
+
+    // texts[ i ] becomes the contents of paths[ i ]; empty on error
+    void read( std::vector< fs::path > const & paths, std::vector< std::string > & texts )
+    {
+        texts.resize( paths.size() );
+
+#if defined(BOOSTDEP_HAS_IO_URING)
+
+        if( kind_ == reader_io_uring && read_io_uring( paths, texts ) ) return;
+
+#endif
+
+        for( std::size_t i = 0; i < paths.size(); ++i )
+        {
+            texts[ i ].clear();
+
+#if defined(__unix__) || defined(__APPLE__)
+
+            if( kind_ != reader_stream )
+            {
+                pread_file( paths[ i ], texts[ i ] );
+                continue;
+            }
+
+#endif
+
+            fs::ifstream is( paths[ i ], std::ios_base::binary );
+            char buffer[ 4096 ];
+
+            while( is.read( buffer, sizeof( buffer ) ) || is.gcount() > 0 )
+            {
+                texts[ i ].append( buffer, static_cast< std::size_t >( is.gcount() ) );
+            }
+        }
+    }
+};
+
+#if defined(BOOSTDEP_HAS_IO_URING)
+
+// opens all files and reads them through the ring, keeping up to
+// entries() operations in flight; returns false, after switching to
+// pread, when the kernel doesn't support the operations
+bool file_reader::read_io_uring( std::vector< fs::path > const & paths, std::vector< std::string > & texts )
+{
+    std::size_t const n = paths.size();
+
+    // -1 while opening, then the descriptor
+    std::vector< int > fds( n, -1 );
+
+    // the bytes read so far, and the size of the file when it was opened
+    std::vector< std::size_t > sizes( n );
+    std::vector< std::size_t > expected( n );
+
+    std::size_t next = 0;
+    unsigned in_flight = 0;
+
+    bool unsupported = false;
+
+    while( next < n || in_flight > 0 )
+    {
+        while( next < n && in_flight < ring_.entries() && !unsupported )
+        {
+            io_uring_sqe * sqe = ring_.get_sqe();
+
+            if( sqe == 0 ) break;
+
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast< __u64 >( paths[ next ].c_str() );
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = next;
+
+            ++next;
+            ++in_flight;
+        }
+
+        if( in_flight == 0 ) break;
+
+        if( !ring_.submit( 1 ) )
+        {
+            unsupported = true;
+            break;
+        }
+
+        io_uring_cqe cqe;
+
+        while( ring_.pop( cqe ) )
+        {
+            --in_flight;
+
+            std::size_t i = static_cast< std::size_t >( cqe.user_data );
+            std::string & text = texts[ i ];
+
+            if( fds[ i ] < 0 )
+            {
+                // an open has completed
+
+                if( cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP )
+                {
+                    unsupported = true;
+                    continue;
+                }
+
+                if( cqe.res < 0 )
+                {
+                    text.clear();
+                    continue;
+                }
+
+                fds[ i ] = cqe.res;
+
+                // a byte more than the size, so that a single read both
+                // fills the text and shows that the file hasn't grown
+                struct stat st;
+
+                if( ::fstat( fds[ i ], &st ) == 0 )
+                {
+                    expected[ i ] = static_cast< std::size_t >( st.st_size );
+                    text.resize( expected[ i ] + 1 );
+                }
+                else
+                {
+                    expected[ i ] = static_cast< std::size_t >( -1 );
+                    text.resize( 16384 );
+                }
+            }
+            else if( cqe.res == -EINTR || cqe.res == -EAGAIN )
+            {
+                // nothing has been read; try again
+            }
+            else if( cqe.res <= 0 )
+            {
+                // the read has reached the end of the file, or failed
+
+                text.resize( cqe.res < 0? 0: sizes[ i ] );
+
+                ::close( fds[ i ] );
+                fds[ i ] = -1;
+
+                continue;
+            }
+            else
+            {
+                sizes[ i ] += cqe.res;
+
+                if( sizes[ i ] == text.size() )
+                {
+                    // the buffer is full, there may be more
+                    text.resize( text.size() * 2 );
+                }
+                else if( sizes[ i ] >= expected[ i ] )
+                {
+                    // the whole file has been read
+                    text.resize( sizes[ i ] );
+
+                    ::close( fds[ i ] );
+                    fds[ i ] = -1;
+
+                    continue;
+                }
+
+                // else a short read; read the rest
+            }
+
+            io_uring_sqe * sqe;
+
+            while( ( sqe = ring_.get_sqe() ) == 0 )
+            {
+                ring_.submit( 0 );
+            }
+
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = fds[ i ];
+            sqe->addr = reinterpret_cast< __u64 >( &text[ sizes[ i ] ] );
+            sqe->len = static_cast< __u32 >( text.size() - sizes[ i ] );
+            sqe->off = sizes[ i ];
+            sqe->user_data = i;
+
+            ++in_flight;
+        }
+    }
+
+    if( unsupported )
+    {
+        // wait for the operations still in flight, then fall back to
+        // pread, which rereads the whole batch
+        io_uring_cqe cqe;
+
+        while( in_flight > 0 && ring_.submit( 1 ) )
+        {
+            while( ring_.pop( cqe ) )
+            {
+                --in_flight;
+
+                std::size_t i = static_cast< std::size_t >( cqe.user_data );
+
+                if( fds[ i ] < 0 && cqe.res >= 0 )
+                {
+                    fds[ i ] = cqe.res;
+                }
+            }
+        }
+
+        for( std::size_t i = 0; i < n; ++i )
+        {
+            if( fds[ i ] >= 0 ) ::close( fds[ i ] );
+        }
+
+        kind_ = reader_pread;
+        return false;
+    }
+
+    return true;
+}
+
+#endif
+
+struct module_file_visitor
+{
+    virtual void file( std::string const & name, fs::path const & path ) = 0;
+};
+
+static void walk_module_path( fs::path const & dir, bool remove_prefix, module_file_visitor & visitor )
+{
+    std::vector< std::string > files;
+    list_module_files( dir, files );
+
+    for( std::vector< std::string >::const_iterator i = files.begin(); i != files.end(); ++i )
+    {
+        // names are relative to the include directory, or to the root;
+        // files in a --git-rev revision have no path on disk
+        visitor.file( remove_prefix? *i: dir.generic_string() + '/' + *i, s_context->git_? dir / *i: root_path( dir / *i ) );
+    }
+}
+
+static void walk_module_files( std::string const & module, bool track_sources, bool track_tests, module_file_visitor & visitor )
+{
+    walk_module_path( module_include_path( module ), true, visitor );
+
+    if( track_sources )
+    {
+        walk_module_path( module_source_path( module ), false, visitor );
+    }
+
+    if( track_tests )
+    {
+        walk_module_path( module_test_path( module ), false, visitor );
+    }
+}
+
+struct scan_file_visitor: public module_file_visitor
+{
+    scan_result & r_;
+
+    // 0 to read one file at a time, as it's found
+    file_reader * reader_;
+
+    std::vector< std::string > names_;
+    std::vector< fs::path > paths_;
+
+    scan_file_visitor( scan_result & r, file_reader * reader ): r_( r ), reader_( reader )
+    {
+    }
+
+    void file( std::string const & name, fs::path const & path )
+    {
+        if( reader_ == 0 )
+        {
+            scan_file( path, name, r_ );
+        }
+        else
+        {
+            names_.push_back( name );
+            paths_.push_back( path );
+
+            if( paths_.size() >= read_batch_size )
+            {
+                flush();
+            }
+        }
+    }
+
+    void flush()
+    {
+        if( paths_.empty() ) return;
+
+        std::vector< std::string > texts;
+        reader_->read( paths_, texts );
+
+        for( std::size_t i = 0; i < names_.size(); ++i )
+        {
+            ++r_.counters.files;
+
+            scan_header_dependencies( names_[ i ], texts[ i ], r_ );
+        }
+
+        names_.clear();
+        paths_.clear();
+    }
+};
+
+// --preprocess
+
+static void pp_tokenize( std::string const & s, std::vector< pp_token > & tokens )
+{
+    static char const * const puncts[] =
+    {
+        "%:%:", "...", "<<=", ">>=", "->*",
+        "##", "&&", "||", "==", "!=", "<=", ">=", "<<", ">>", "++", "--", "->", "::", ".*",
+        "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "%:",
+    };
+
+    bool space = false;
+
+    for( std::size_t i = 0; i < s.size(); )
+    {
+        char ch = s[ i ];
+
+        if( ch == ' ' || ch == '\t' || ch == '\r' || ch == '\f' || ch == '\v' || ch == '\n' )
+        {
+            space = true;
+            ++i;
+
+            continue;
+        }
+
+        pp_token t;
+
+        t.space = space;
+        t.id = 0;
+        t.hide = 0;
+
+        space = false;
+
+        std::size_t j = i + 1;
+
+        if( is_pp_ident_start( ch ) )
+        {
+            while( j < s.size() && is_pp_ident_char( s[ j ] ) ) ++j;
+
+            t.kind = 'i';
+
+            if( j < s.size() && ( s[ j ] == '"' || s[ j ] == '\'' ) )
+            {
+                std::string const prefix = s.substr( i, j - i );
+
+                if( prefix == "L" || prefix == "u" || prefix == "U" || prefix == "u8" || is_raw_prefix( prefix, prefix.size() ) )
+                {
+                    j = pp_literal_end( s, j, s[ j ] == '"' && is_raw_prefix( prefix, prefix.size() ) );
+                    t.kind = 's';
+                }
+            }
+        }
+        else if( std::isdigit( static_cast< unsigned char >( ch ) ) || ( ch == '.' && j < s.size() && std::isdigit( static_cast< unsigned char >( s[ j ] ) ) ) )
+        {
+            for( ; j < s.size(); ++j )
+            {
+                char c = s[ j ];
+
+                if( is_pp_ident_char( c ) || c == '.' ) continue;
+                if( ( c == '+' || c == '-' ) && std::strchr( "eEpP", s[ j - 1 ] ) ) continue;
+                if( c == '\'' && j + 1 < s.size() && is_pp_ident_char( s[ j + 1 ] ) ) continue;
+
+                break;
+            }
+
+            t.kind = 'n';
+        }
+        else if( ch == '"' || ch == '\'' )
+        {
+            j = pp_literal_end( s, i, false );
+            t.kind = 's';
+        }
+        else
+        {
+            t.kind = 'p';
+
+            for( std::size_t k = 0; k < sizeof( puncts ) / sizeof( puncts[ 0 ] ); ++k )
+            {
+                std::size_t n = std::strlen( puncts[ k ] );
+
+                if( s.compare( i, n, puncts[ k ] ) == 0 )
+                {
+                    j = i + n;
+                    break;
+                }
+            }
+        }
+
+        t.text = s.substr( i, j - i );
+        tokens.push_back( t );
+
+        i = j;
+    }
+}
+
+// adds line to the directives of f when it's one
+static void pp_lex_line( std::string const & line, pp_file & f, unsigned long & text_lines )
+{
+    std::string::size_type k = line.find_first_not_of( " \t\r\f\v" );
+
+    if( k == std::string::npos ) return;
+
+    if( line[ k ] != '#' )
+    {
+        ++text_lines;
+        return;
+    }
+
+    k = line.find_first_not_of( " \t\r\f\v", k + 1 );
+
+    if( k == std::string::npos ) return;
+
+    std::string::size_type n = k;
+    while( n < line.size() && std::isalpha( static_cast< unsigned char >( line[ n ] ) ) ) ++n;
+
+    if( n == k ) return;
+
+    pp_directive d;
+
+    d.name = line.substr( k, n - k );
+    d.operand = line.substr( n );
+    d.text_before = text_lines;
+
+    skip_spaces( d.operand );
+    pp_tokenize( d.operand, d.tokens );
+
+    if( d.name == "pragma" && !d.tokens.empty() && d.tokens[ 0 ].text == "once" )
+    {
+        f.once = true;
+    }
+
+    f.directives.push_back( d );
+}
+
+// the include guard of f: an #ifndef or #if !defined around the whole
+// file, followed by a #define of its macro
+static void pp_find_guard( pp_file & f, unsigned long text_lines )
+{
+    std::vector< pp_directive > const & d = f.directives;
+
+    if( d.size() < 3 || d[ 0 ].text_before != 0 ) return;
+
+    std::vector< pp_token > const & t = d[ 0 ].tokens;
+    std::string guard;
+
+    if( d[ 0 ].name == "ifndef" && t.size() == 1 )
+    {
+        guard = t[ 0 ].text;
+    }
+    else if( d[ 0 ].name == "if" && t.size() == 3 && t[ 0 ].text == "!" && t[ 1 ].text == "defined" )
+    {
+        guard = t[ 2 ].text;
+    }
+    else if( d[ 0 ].name == "if" && t.size() == 5 && t[ 0 ].text == "!" && t[ 1 ].text == "defined" && t[ 2 ].text == "(" && t[ 4 ].text == ")" )
+    {
+        guard = t[ 3 ].text;
+    }
+
+    if( guard.empty() || d[ 1 ].name != "define" || d[ 1 ].tokens.empty() || d[ 1 ].tokens[ 0 ].text != guard ) return;
+
+    int level = 0;
+
+    for( std::size_t i = 0; i < d.size(); ++i )
+    {
+        std::string const & name = d[ i ].name;
+
+        if( name == "if" || name == "ifdef" || name == "ifndef" )
+        {
+            ++level;
+        }
+        else if( ( name == "elif" || name == "else" ) && level == 1 )
+        {
+            return;
+        }
+        else if( name == "endif" && --level == 0 )
+        {
+            if( i + 1 == d.size() && d[ i ].text_before == text_lines )
+            {
+                f.guard = guard;
+            }
+
+            return;
+        }
+    }
+}
+
+// the directives of text, without comments, literals and line continuations
+static void pp_lex_file( std::string const & text, pp_file & f )
+{
+    f.once = false;
+
+    f.size = text_size( text );
+
+    std::string line;
+    unsigned long text_lines = 0;
+
+    for( std::size_t i = 0; i <= text.size(); ++i )
+    {
+        char ch = i < text.size()? text[ i ]: '\n';
+
+        if( ch == '\n' )
+        {
+            pp_lex_line( line, f, text_lines );
+            line.clear();
+
+            continue;
+        }
+
+        char next = i + 1 < text.size()? text[ i + 1 ]: 0;
+
+        if( ch == '\\' && ( next == '\n' || ( next == '\r' && i + 2 < text.size() && text[ i + 2 ] == '\n' ) ) )
+        {
+            i += next == '\n'? 1: 2;
+        }
+        else if( ch == '/' && next == '*' )
+        {
+            std::size_t k = text.find( "*/", i + 2 );
+
+            line += ' ';
+            i = k == std::string::npos? text.size(): k + 1;
+        }
+        else if( ch == '/' && next == '/' )
+        {
+            i = line_comment_end( text, i ) - 1;
+        }
+        else if( ch == '"' || ( ch == '\'' && !is_digit_separator( line, line.size() ) ) )
+        {
+            std::size_t k = pp_literal_end( text, i, ch == '"' && is_raw_prefix( line, line.size() ) );
+
+            // the lines of a raw string are not lines of their own
+            std::string literal = text.substr( i, k - i );
+            std::replace( literal.begin(), literal.end(), '\n', ' ' );
+
+            line += literal;
+            i = k - 1;
+        }
+        else
+        {
+            line += ch;
+        }
+    }
+
+    pp_find_guard( f, text_lines );
+}
+
+// reads the file at path, usually relative to the root
+static bool read_source_file( fs::path const & path, std::string & text )
+{
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+    if( s_context->git_ && !path.is_absolute() )
+    {
+        return s_context->git_->read( path.generic_string(), text );
+    }
+
+#endif
+
+    return read_file( path, text );
+}
+
+// sets the ids of the identifiers in tokens
+static void intern_pp_tokens( preprocessor_cache & cache, std::vector< pp_token > & tokens )
+{
+    for( std::vector< pp_token >::iterator i = tokens.begin(); i != tokens.end(); ++i )
+    {
+        if( i->kind == 'i' ) i->id = cache.intern( i->text );
+    }
+}
+
+// the directives of the file name at path; lexed once
+static pp_file const & load_pp_file( preprocessor_cache & cache, std::string const & name, fs::path const & path )
+{
+    std::map< std::string, pp_file >::iterator i = cache.files.find( name );
+
+    if( i != cache.files.end() ) return i->second;
+
+    pp_file & f = cache.files[ name ];
+
+    std::string text;
+    f.exists = read_source_file( path, text );
+
+    pp_lex_file( text, f );
+
+    for( std::vector< pp_directive >::iterator j = f.directives.begin(); j != f.directives.end(); ++j )
+    {
+        intern_pp_tokens( cache, j->tokens );
+    }
+
+    return f;
+}
+
+// the name and definition of a #define with the given operand
+static bool parse_pp_define( std::vector< pp_token > const & tokens, std::string & name, pp_macro & m )
+{
+    if( tokens.empty() || tokens[ 0 ].kind != 'i' ) return false;
+
+    name = tokens[ 0 ].text;
+
+    m.function = tokens.size() > 1 && tokens[ 1 ].text == "(" && !tokens[ 1 ].space;
+    m.variadic = false;
+
+    std::size_t i = 1;
+
+    if( m.function )
+    {
+        for( i = 2; i < tokens.size() && tokens[ i ].text != ")"; ++i )
+        {
+            if( tokens[ i ].text == "..." )
+            {
+                if( !m.variadic ) m.params.push_back( "__VA_ARGS__" );
+                m.variadic = true;
+            }
+            else if( tokens[ i ].kind == 'i' )
+            {
+                m.params.push_back( tokens[ i ].text );
+            }
+        }
+
+        if( i == tokens.size() ) return false;
+
+        ++i;
+    }
+
+    m.body.assign( tokens.begin() + i, tokens.end() );
+    return true;
+}
+
+// the shared copy of m; equal definitions have the same address
+static pp_macro const * intern_pp_macro( preprocessor_cache & cache, std::string const & name, pp_macro const & m )
+{
+    std::string key = name;
+
+    if( m.function )
+    {
+        key += '(';
+
+        for( std::size_t i = 0; i < m.params.size(); ++i )
+        {
+            key += m.params[ i ] + ',';
+        }
+
+        key += m.variadic? "...)": ")";
+    }
+
+    for( std::size_t i = 0; i < m.body.size(); ++i )
+    {
+        key += ' ';
+        key += m.body[ i ].text;
+    }
+
+    std::map< std::string, pp_macro const * >::const_iterator i = cache.definitions.find( key );
+
+    if( i != cache.definitions.end() ) return i->second;
+
+    cache.macros.push_back( m );
+    return cache.definitions[ key ] = &cache.macros.back();
+}
+
+// the macros of configuration k, or none when k is -1
+static void seed_pp_macros( preprocessor_cache & cache, int k )
+{
+    if( cache.seed_config == k ) return;
+
+    cache.seed.clear();
+    cache.seed_config = k;
+
+    if( k < 0 ) return;
+
+    configuration const & c = s_context->configs_[ k ];
+
+    for( std::map< std::string, macro_definition >::const_iterator i = c.macros.begin(); i != c.macros.end(); ++i )
+    {
+        std::vector< pp_token > tokens;
+
+        pp_tokenize( i->first + ( i->second.function? "(" + i->second.params + ")": std::string() ) + " " + i->second.body, tokens );
+        intern_pp_tokens( cache, tokens );
+
+        std::string name;
+        pp_macro m;
+
+        if( parse_pp_define( tokens, name, m ) )
+        {
+            if( tokens[ 0 ].id >= cache.seed.size() ) cache.seed.resize( cache.names.size() );
+            cache.seed[ tokens[ 0 ].id ] = intern_pp_macro( cache, name, m );
+        }
+    }
+}
+
+// "x/./y/../z" -> "x/z"
+static std::string normalize_include_path( std::string const & path )
+{
+    std::vector< std::string > parts;
+
+    for( std::string::size_type i = 0; i <= path.size(); )
+    {
+        std::string::size_type k = path.find( '/', i );
+        if( k == std::string::npos ) k = path.size();
+
+        std::string const part = path.substr( i, k - i );
+
+        if( part == ".." && !parts.empty() && parts.back() != ".." )
+        {
+            parts.pop_back();
+        }
+        else if( part != "." && ( !part.empty() || parts.empty() ) )
+        {
+            parts.push_back( part );
+        }
+
+        i = k + 1;
+    }
+
+    std::string r;
+
+    for( std::size_t i = 0; i < parts.size(); ++i )
+    {
+        if( i > 0 ) r += '/';
+        r += parts[ i ];
+    }
+
+    return r;
+}
+
+// the <name> or "name" at the start of text
+static bool pp_header_name( std::string const & text, std::string & name, bool & quoted )
+{
+    if( text.empty() || ( text[ 0 ] != '<' && text[ 0 ] != '"' ) ) return false;
+
+    quoted = text[ 0 ] == '"';
+
+    std::string::size_type k = text.find( quoted? '"': '>', 1 );
+
+    if( k == std::string::npos ) return false;
+
+    name = text.substr( 1, k - 1 );
+    return !name.empty();
+}
+
+// preprocesses translation units: expands macros, evaluates conditionals,
+// and follows the #includes that are reached, including computed ones.
+// The result of preprocessing a file is memoized per values of the macros
+// it reads, so that repeated inclusions are nearly free
+class preprocessor
+{
+private:
+
+    preprocessor_cache & cache_;
+
+    // the current definitions, by name index, and the names defined or
+    // undefined since the seed configuration
+    std::vector< pp_macro const * > macros_;
+    std::vector< std::size_t > assigned_;
+
+    // the files being preprocessed, innermost last, and what they did
+    struct frame
+    {
+        std::map< std::size_t, pp_macro const * > reads;
+        std::map< std::size_t, pp_macro const * > writes;
+
+        std::set< std::string > includes;
+        std::vector< std::pair< std::size_t, std::size_t > > children;
+    };
+
+    std::vector< frame > frames_;
+
+    // the memo entries whose #includes have been collected by run
+    std::set< std::pair< std::size_t, std::size_t > > collected_;
+
+    std::set< std::set< std::size_t > > hide_sets_;
+
+    // the macro expansions left for the current directive
+    int budget_;
+
+    // the value of the #once macros that mark the files of #pragma once
+    pp_macro once_;
+
+    preprocessor( preprocessor const & );
+    preprocessor & operator=( preprocessor const & );
+
+    pp_macro const * value( std::size_t id ) const
+    {
+        return id < macros_.size()? macros_[ id ]: 0;
+    }
+
+    void set_value( std::size_t id, pp_macro const * m )
+    {
+        if( id >= macros_.size() ) macros_.resize( cache_.names.size() );
+
+        macros_[ id ] = m;
+        assigned_.push_back( id );
+    }
+
+    pp_macro const * lookup( std::size_t id )
+    {
+        pp_macro const * m = value( id );
+        frame & f = frames_.back();
+
+        if( !f.writes.count( id ) )
+        {
+            f.reads.insert( std::make_pair( id, m ) );
+        }
+
+        return m;
+    }
+
+    void assign( std::size_t id, pp_macro const * m )
+    {
+        set_value( id, m );
+        frames_.back().writes[ id ] = m;
+    }
+
+    // hide sets
+
+    std::set< std::size_t > const * intern( std::set< std::size_t > const & h )
+    {
+        return h.empty()? 0: &*hide_sets_.insert( h ).first;
+    }
+
+    std::set< std::size_t > const * hide_add( std::set< std::size_t > const * h, std::size_t id )
+    {
+        std::set< std::size_t > r;
+
+        if( h ) r = *h;
+        r.insert( id );
+
+        return intern( r );
+    }
+
+    std::set< std::size_t > const * hide_union( std::set< std::size_t > const * a, std::set< std::size_t > const * b )
+    {
+        if( a == 0 || a == b ) return b;
+        if( b == 0 ) return a;
+
+        std::set< std::size_t > r( *a );
+        r.insert( b->begin(), b->end() );
+
+        return intern( r );
+    }
+
+    std::set< std::size_t > const * hide_intersection( std::set< std::size_t > const * a, std::set< std::size_t > const * b )
+    {
+        if( a == 0 || b == 0 ) return 0;
+
+        std::set< std::size_t > r;
+        std::set_intersection( a->begin(), a->end(), b->begin(), b->end(), std::inserter( r, r.begin() ) );
+
+        return intern( r );
+    }
+
+    // macro expansion
+
+    static int parameter( pp_macro const & m, pp_token const & t )
+    {
+        if( t.kind != 'i' ) return -1;
+
+        for( std::size_t i = 0; i < m.params.size(); ++i )
+        {
+            if( m.params[ i ] == t.text ) return static_cast< int >( i );
+        }
+
+        return -1;
+    }
+
+    static pp_token stringize( std::vector< pp_token > const & arg, bool space )
+    {
+        pp_token r;
+
+        r.kind = 's';
+        r.space = space;
+        r.id = 0;
+        r.hide = 0;
+        r.text = "\"";
+
+        for( std::size_t i = 0; i < arg.size(); ++i )
+        {
+            if( i > 0 && arg[ i ].space ) r.text += ' ';
+
+            for( std::string::const_iterator j = arg[ i ].text.begin(); j != arg[ i ].text.end(); ++j )
+            {
+                if( arg[ i ].kind == 's' && ( *j == '"' || *j == '\\' ) ) r.text += '\\';
+                r.text += *j;
+            }
+        }
+
+        r.text += '"';
+        return r;
+    }
+
+    // lhs ## rhs
+    void paste( pp_token & lhs, pp_token const & rhs )
+    {
+        std::string const text = lhs.text + rhs.text;
+
+        std::vector< pp_token > tokens;
+        pp_tokenize( text, tokens );
+
+        lhs.text = text;
+
+        if( !tokens.empty() )
+        {
+            lhs.kind = tokens[ 0 ].kind;
+        }
+
+        if( lhs.kind == 'i' )
+        {
+            lhs.id = cache_.intern( text );
+        }
+    }
+
+    static void append( std::vector< pp_token > & out, std::vector< pp_token > const & tokens, bool space )
+    {
+        std::size_t const n = out.size();
+
+        out.insert( out.end(), tokens.begin(), tokens.end() );
+
+        if( n < out.size() ) out[ n ].space = space;
+    }
+
+    // the body of m, with args substituted for its parameters
+    void substitute( pp_macro const & m, std::vector< std::vector< pp_token > > const & args, std::set< std::size_t > const * hide, bool condition, std::vector< pp_token > & out )
+    {
+        std::vector< pp_token > const & body = m.body;
+        std::size_t const n = body.size();
+
+        for( std::size_t i = 0; i < n; ++i )
+        {
+            pp_token const & t = body[ i ];
+            int const p = parameter( m, t );
+
+            if( m.function && t.text == "#" && i + 1 < n && parameter( m, body[ i + 1 ] ) >= 0 )
+            {
+                out.push_back( stringize( args[ parameter( m, body[ ++i ] ) ], t.space ) );
+            }
+            else if( t.text == "##" && i + 1 < n )
+            {
+                pp_token const & rhs = body[ ++i ];
+                int const q = parameter( m, rhs );
+
+                if( q >= 0 && args[ q ].empty() )
+                {
+                    // , ## __VA_ARGS__ removes the comma when there are no arguments
+                    if( m.variadic && q + 1 == static_cast< int >( m.params.size() ) && !out.empty() && out.back().text == "," )
+                    {
+                        out.pop_back();
+                    }
+                }
+                else if( out.empty() )
+                {
+                    if( q >= 0 ) append( out, args[ q ], rhs.space ); else out.push_back( rhs );
+                }
+                else if( q >= 0 )
+                {
+                    paste( out.back(), args[ q ][ 0 ] );
+                    out.insert( out.end(), args[ q ].begin() + 1, args[ q ].end() );
+                }
+                else
+                {
+                    paste( out.back(), rhs );
+                }
+            }
+            else if( p >= 0 && i + 1 < n && body[ i + 1 ].text == "##" )
+            {
+                // the operands of ## are not expanded
+                append( out, args[ p ], t.space );
+            }
+            else if( p >= 0 )
+            {
+                std::vector< pp_token > x;
+                expand( args[ p ], x, condition );
+
+                append( out, x, t.space );
+            }
+            else
+            {
+                out.push_back( t );
+            }
+        }
+
+        for( std::vector< pp_token >::iterator i = out.begin(); i != out.end(); ++i )
+        {
+            i->hide = hide_union( i->hide, hide );
+        }
+    }
+
+    // expands the macros in tokens; in conditions, the operands of
+    // defined are kept as they are
+    void expand( std::vector< pp_token > const & tokens, std::vector< pp_token > & out, bool condition )
+    {
+        // the tokens left, the next one last
+        std::vector< pp_token > input( tokens.rbegin(), tokens.rend() );
+
+        while( !input.empty() )
+        {
+            pp_token t = input.back();
+            input.pop_back();
+
+            if( t.kind != 'i' || ( t.hide && t.hide->count( t.id ) ) || budget_ <= 0 )
+            {
+                out.push_back( t );
+                continue;
+            }
+
+            if( condition && t.text == "defined" )
+            {
+                out.push_back( t );
+
+                std::size_t n = !input.empty() && input.back().text == "("? 3: 1;
+
+                for( std::size_t k = 0; k < n && !input.empty(); ++k )
+                {
+                    out.push_back( input.back() );
+                    input.pop_back();
+                }
+
+                continue;
+            }
+
+            pp_macro const * m = lookup( t.id );
+
+            if( m == 0 || ( m->function && ( input.empty() || input.back().text != "(" ) ) )
+            {
+                out.push_back( t );
+                continue;
+            }
+
+            if( m->function )
+            {
+                // a call whose ) is missing isn't expanded
+                int level = 0;
+                std::size_t k = input.size();
+
+                while( k > 0 )
+                {
+                    std::string const & a = input[ --k ].text;
+
+                    if( a == "(" ) ++level;
+                    if( a == ")" && --level == 0 ) break;
+                }
+
+                if( level != 0 )
+                {
+                    out.push_back( t );
+                    continue;
+                }
+            }
+
+            --budget_;
+
+            std::vector< std::vector< pp_token > > args;
+            std::set< std::size_t > const * hide = 0;
+
+            if( m->function )
+            {
+                input.pop_back();
+                args.resize( 1 );
+
+                int level = 0;
+
+                for( ;; )
+                {
+                    pp_token a = input.back();
+                    input.pop_back();
+
+                    if( a.text == ")" && level == 0 )
+                    {
+                        hide = a.hide;
+                        break;
+                    }
+
+                    if( a.text == "(" ) ++level;
+                    if( a.text == ")" ) --level;
+
+                    if( a.text == "," && level == 0 && !( m->variadic && args.size() == m->params.size() ) )
+                    {
+                        args.resize( args.size() + 1 );
+                        continue;
+                    }
+
+                    args.back().push_back( a );
+                }
+
+                // the arguments that weren't given are empty
+                args.resize( std::max( args.size(), m->params.size() ) );
+
+                hide = hide_intersection( t.hide, hide );
+            }
+            else
+            {
+                hide = t.hide;
+            }
+
+            std::vector< pp_token > r;
+            substitute( *m, args, hide_add( hide, t.id ), condition, r );
+
+            if( !r.empty() ) r[ 0 ].space = t.space;
+
+            input.insert( input.end(), r.rbegin(), r.rend() );
+        }
+    }
+
+    // the value of an #if or #elif condition in file
+    bool condition( std::vector< pp_token > const & tokens, std::string const & file )
+    {
+        budget_ = 65536;
+
+        std::vector< pp_token > x;
+        expand( tokens, x, true );
+
+        std::string text;
+
+        for( std::size_t i = 0; i < x.size(); ++i )
+        {
+            pp_token const & t = x[ i ];
+
+            if( t.kind == 'i' && t.text == "defined" )
+            {
+                bool const paren = i + 1 < x.size() && x[ i + 1 ].text == "(";
+                std::size_t const k = i + 1 + paren;
+
+                bool r = false;
+
+                if( k < x.size() && x[ k ].kind == 'i' )
+                {
+                    // __has_include and the like are operators, not macros
+                    r = lookup( x[ k ].id ) || x[ k ].text.compare( 0, 6, "__has_" ) == 0;
+                }
+
+                text += r? " 1": " 0";
+                i = k + paren;
+            }
+            else if( t.kind == 'i' && t.text.compare( 0, 6, "__has_" ) == 0 && i + 1 < x.size() && x[ i + 1 ].text == "(" )
+            {
+                std::string operand;
+
+                int level = 1;
+                std::size_t k = i + 2;
+
+                for( ; k < x.size(); ++k )
+                {
+                    if( x[ k ].text == "(" ) ++level;
+                    if( x[ k ].text == ")" && --level == 0 ) break;
+
+                    if( x[ k ].space && !operand.empty() ) operand += ' ';
+                    operand += x[ k ].text;
+                }
+
+                i = k;
+
+                bool r = false;
+
+                std::string name;
+                bool quoted;
+
+                if( ( t.text == "__has_include" || t.text == "__has_include_next" ) && pp_header_name( operand, name, quoted ) )
+                {
+                    std::string key;
+                    fs::path path;
+
+                    // the headers outside Boost are those of the system
+                    r = resolve( name, quoted, file, key, path ) || ( !quoted && name.compare( 0, 6, "boost/" ) != 0 );
+                }
+
+                // attributes, builtins and features are assumed absent
+                text += r? " 1": " 0";
+            }
+            else if( t.kind == 'i' )
+            {
+                text += t.text == "true"? " 1": " 0";
+            }
+            else
+            {
+                text += ' ';
+                text += t.text;
+            }
+        }
+
+        static configuration const no_macros;
+
+        condition_evaluator e( no_macros );
+        return e.may_hold( text );
+    }
+
+    // the file that an #include in includer refers to
+    bool resolve( std::string const & name, bool quoted, std::string const & includer, std::string & key, fs::path & path )
+    {
+        if( quoted )
+        {
+            std::string::size_type k = includer.rfind( '/' );
+            std::string const candidate = normalize_include_path( k == std::string::npos? name: includer.substr( 0, k + 1 ) + name );
+
+            if( std::string const * module = find_header_module( candidate ) )
+            {
+                key = candidate;
+                path = module_include_path( *module ) / candidate;
+
+                return true;
+            }
+
+            if( !find_header_module( includer ) && root_exists( candidate ) )
+            {
+                // next to a source file
+                key = candidate;
+                path = candidate;
+
+                return true;
+            }
+        }
+
+        key = name;
+
+        if( std::string const * module = find_header_module( name ) )
+        {
+            path = module_include_path( *module ) / name;
+            return true;
+        }
+
+        return false;
+    }
+
+    void include( pp_directive const & d, std::string const & file )
+    {
+        std::string name;
+        bool quoted;
+
+        bool const computed = !pp_header_name( d.operand, name, quoted );
+
+        if( computed )
+        {
+            // #include MACRO
+            budget_ = 65536;
+
+            std::vector< pp_token > x;
+            expand( d.tokens, x, false );
+
+            std::string text;
+
+            for( std::size_t i = 0; i < x.size(); ++i )
+            {
+                if( x[ i ].space && !text.empty() ) text += ' ';
+                text += x[ i ].text;
+            }
+
+            if( !pp_header_name( text, name, quoted ) ) return;
+        }
+
+        std::string key;
+        fs::path path;
+
+        bool const found = resolve( name, quoted, file, key, path );
+
+        // a computed #include that names no file usually has macros
+        // left that the includer of file would have defined
+        if( found || !computed )
+        {
+            frames_.back().includes.insert( key );
+        }
+
+        if( found )
+        {
+            include_file( key, path );
+        }
+    }
+
+    void define( std::vector< pp_token > const & tokens )
+    {
+        std::string name;
+        pp_macro m;
+
+        if( parse_pp_define( tokens, name, m ) )
+        {
+            assign( tokens[ 0 ].id, intern_pp_macro( cache_, name, m ) );
+        }
+    }
+
+    void process( std::string const & file, pp_file const & f )
+    {
+        // for each open #if, whether the group around it is active,
+        // and whether one of its branches has been taken
+        std::vector< std::pair< bool, bool > > conditionals;
+        bool active = true;
+
+        for( std::vector< pp_directive >::const_iterator i = f.directives.begin(); i != f.directives.end(); ++i )
+        {
+            std::string const & name = i->name;
+            std::vector< pp_token > const & tokens = i->tokens;
+
+            if( name == "if" || name == "ifdef" || name == "ifndef" )
+            {
+                bool c = false;
+
+                if( active && name == "if" )
+                {
+                    c = condition( tokens, file );
+                }
+                else if( active )
+                {
+                    c = !tokens.empty() && tokens[ 0 ].kind == 'i' && ( lookup( tokens[ 0 ].id ) != 0 ) == ( name == "ifdef" );
+                }
+
+                conditionals.push_back( std::make_pair( active, c ) );
+                active = c;
+            }
+            else if( name == "elif" )
+            {
+                if( conditionals.empty() ) continue;
+
+                active = conditionals.back().first && !conditionals.back().second && condition( tokens, file );
+                conditionals.back().second = conditionals.back().second || active;
+            }
+            else if( name == "else" )
+            {
+                if( conditionals.empty() ) continue;
+
+                active = conditionals.back().first && !conditionals.back().second;
+                conditionals.back().second = true;
+            }
+            else if( name == "endif" )
+            {
+                if( conditionals.empty() ) continue;
+
+                active = conditionals.back().first;
+                conditionals.pop_back();
+            }
+            else if( !active )
+            {
+                continue;
+            }
+            else if( name == "define" )
+            {
+                define( tokens );
+            }
+            else if( name == "undef" )
+            {
+                if( !tokens.empty() && tokens[ 0 ].kind == 'i' ) assign( tokens[ 0 ].id, 0 );
+            }
+            else if( name == "include" || name == "include_next" || name == "import" )
+            {
+                include( *i, file );
+            }
+        }
+    }
+
+    // applies a memoized result of preprocessing file, if one matches
+    // the current definitions
+    bool apply_memo( std::size_t file )
+    {
+        if( file >= cache_.memo.size() ) return false;
+
+        std::vector< pp_memo_entry > const & memo = cache_.memo[ file ];
+
+        for( std::vector< pp_memo_entry >::const_iterator i = memo.begin(); i != memo.end(); ++i )
+        {
+            bool match = true;
+
+            for( pp_macro_values::const_iterator j = i->reads.begin(); match && j != i->reads.end(); ++j )
+            {
+                match = value( j->first ) == j->second;
+            }
+
+            if( !match ) continue;
+
+            frame & f = frames_.back();
+
+            for( pp_macro_values::const_iterator j = i->reads.begin(); j != i->reads.end(); ++j )
+            {
+                if( !f.writes.count( j->first ) )
+                {
+                    f.reads.insert( *j );
+                }
+            }
+
+            for( pp_macro_values::const_iterator j = i->writes.begin(); j != i->writes.end(); ++j )
+            {
+                f.writes[ j->first ] = j->second;
+                set_value( j->first, j->second );
+            }
+
+            f.children.push_back( std::make_pair( file, i - memo.begin() ) );
+            return true;
+        }
+
+        return false;
+    }
+
+    void include_file( std::string const & name, fs::path const & path )
+    {
+        // as deep as compilers allow
+        if( frames_.size() > 200 ) return;
+
+        pp_file const & f = load_pp_file( cache_, name, path );
+
+        if( !f.exists ) return;
+
+        // a header is skipped when its include guard is defined,
+        // or when it has #pragma once and has been included
+        if( !f.guard.empty() && lookup( cache_.intern( f.guard ) ) ) return;
+
+        std::size_t const once = f.once? cache_.intern( "#once " + name ): 0;
+
+        if( f.once && lookup( once ) ) return;
+
+        std::size_t const file = cache_.intern( name );
+
+        if( apply_memo( file ) ) return;
+
+        frames_.push_back( frame() );
+
+        if( f.once ) assign( once, &once_ );
+
+        process( name, f );
+
+        frame done;
+
+        done.reads.swap( frames_.back().reads );
+        done.writes.swap( frames_.back().writes );
+        done.includes.swap( frames_.back().includes );
+        done.children.swap( frames_.back().children );
+
+        frames_.pop_back();
+
+        // the parent did what the file did
+        frame & parent = frames_.back();
+
+        for( std::map< std::size_t, pp_macro const * >::const_iterator i = done.reads.begin(); i != done.reads.end(); ++i )
+        {
+            if( !parent.writes.count( i->first ) )
+            {
+                parent.reads.insert( *i );
+            }
+        }
+
+        for( std::map< std::size_t, pp_macro const * >::const_iterator i = done.writes.begin(); i != done.writes.end(); ++i )
+        {
+            parent.writes[ i->first ] = i->second;
+        }
+
+        if( file >= cache_.memo.size() ) cache_.memo.resize( file + 1 );
+
+        std::vector< pp_memo_entry > & memo = cache_.memo[ file ];
+
+        parent.children.push_back( std::make_pair( file, memo.size() ) );
+
+        memo.push_back( pp_memo_entry() );
+        pp_memo_entry & e = memo.back();
+
+        e.reads.assign( done.reads.begin(), done.reads.end() );
+        e.writes.assign( done.writes.begin(), done.writes.end() );
+        e.includes.swap( done.includes );
+        e.children.swap( done.children );
+    }
+
+public:
+
+    explicit preprocessor( preprocessor_cache & cache ): cache_( cache ), macros_( cache.seed ), budget_( 0 )
+    {
+        once_.function = false;
+        once_.variadic = false;
+    }
+
+    // preprocesses the file name at path as a translation unit, with the
+    // macros of the seed configuration predefined; adds the #includes
+    // reached in each of files to includes
+    void run( std::string const & name, fs::path const & path, std::set< std::string > const & files, std::map< std::string, std::set< std::string > > & includes )
+    {
+        for( std::vector< std::size_t >::const_iterator i = assigned_.begin(); i != assigned_.end(); ++i )
+        {
+            macros_[ *i ] = *i < cache_.seed.size()? cache_.seed[ *i ]: 0;
+        }
+
+        assigned_.clear();
+        hide_sets_.clear();
+
+        frames_.clear();
+        frames_.push_back( frame() );
+
+        include_file( name, path );
+
+        // the memo entries reached, each once
+        std::vector< std::pair< std::size_t, std::size_t > > stack( frames_.back().children );
+
+        while( !stack.empty() )
+        {
+            std::pair< std::size_t, std::size_t > k = stack.back();
+            stack.pop_back();
+
+            if( !collected_.insert( k ).second ) continue;
+
+            pp_memo_entry const & e = cache_.memo[ k.first ][ k.second ];
+            std::string const & file = cache_.names[ k.first ];
+
+            if( files.count( file ) )
+            {
+                includes[ file ].insert( e.includes.begin(), e.includes.end() );
+            }
+
+            stack.insert( stack.end(), e.children.begin(), e.children.end() );
+        }
+    }
+};
+
+struct collect_files_visitor: public module_file_visitor
+{
+    std::vector< std::string > names_;
+    std::vector< fs::path > paths_;
+
+    void file( std::string const & name, fs::path const & path )
+    {
+        names_.push_back( name );
+        paths_.push_back( path );
+    }
+};
+
+// scans the files of module by preprocessing each as a translation unit
+// under the active configuration; the files of other modules that are
+// reached are preprocessed too, but only the #includes of those of
+// module are reported
+static void preprocess_module_files( std::string const & module, bool track_sources, bool track_tests, scan_result & r )
+{
+    collect_files_visitor visitor;
+    walk_module_files( module, track_sources, track_tests, visitor );
+
+    preprocessor_cache & cache = s_context->preprocessor_;
+    seed_pp_macros( cache, s_context->active_config_ );
+
+    preprocessor pp( cache );
+
+    std::set< std::string > const files( visitor.names_.begin(), visitor.names_.end() );
+    std::map< std::string, std::set< std::string > > includes;
+
+    for( std::size_t i = 0; i < visitor.names_.size(); ++i )
+    {
+        pp.run( visitor.names_[ i ], visitor.paths_[ i ], files, includes );
+    }
+
+    for( std::size_t i = 0; i < visitor.names_.size(); ++i )
+    {
+        std::set< std::string > const & inc = includes[ visitor.names_[ i ] ];
+
+        file_includes f;
+
+        pp_file const & pf = load_pp_file( cache, visitor.names_[ i ], visitor.paths_[ i ] );
+
+        f.includes.assign( inc.begin(), inc.end() );
+        f.size = pf.size;
+        f.guarded = !pf.guard.empty() || pf.once;
+
+        ++r.counters.files;
+        add_header_dependencies( visitor.names_[ i ], f, r );
+    }
+}
+
+static void scan_module_files( std::string const & module, bool track_sources, bool track_tests, scan_result & r )
+{
+    if( s_context->preprocess_ )
+    {
+        preprocess_module_files( module, track_sources, track_tests, r );
+    }
+    else if( s_context->reader_ == reader_stream || s_context->git_ )
+    {
+        scan_file_visitor visitor( r, 0 );
+        walk_module_files( module, track_sources, track_tests, visitor );
+    }
+    else
+    {
+        file_reader reader( s_context->reader_ );
+
+        scan_file_visitor visitor( r, &reader );
+
+        walk_module_files( module, track_sources, track_tests, visitor );
+        visitor.flush();
+    }
+}
+
+// removes the includes that don't hold in the --use-config configuration
+void apply_configuration( scan_result & r )
+{
+    if( s_context->active_config_ < 0 || r.conditions.empty() ) return;
+
+    config_mask const bit = static_cast< config_mask >( 1 ) << s_context->active_config_;
+
+    for( std::map< std::pair< std::string, std::string >, std::string >::const_iterator i = r.conditions.begin(); i != r.conditions.end(); ++i )
+    {
+        if( !( condition_mask( i->second ) & bit ) )
+        {
+            r.from[ i->first.second ].erase( i->first.first );
+        }
+    }
+
+    for( std::map< std::string, std::set< std::string > >::iterator i = r.deps.begin(); i != r.deps.end(); )
+    {
+        for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); )
+        {
+            if( r.from[ *j ].empty() )
+            {
+                r.from.erase( *j );
+                i->second.erase( j++ );
+            }
+            else
+            {
+                ++j;
+            }
+        }
+
+        if( i->second.empty() )
+        {
+            r.deps.erase( i++ );
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void report_module_dependencies( std::string const & module, scan_result & r, module_primary_actions & actions, bool include_self )
+{
+    std::map< std::string, std::set< std::string > > & deps = r.deps;
+    std::map< std::string, std::set< std::string > > & from = r.from;
+
+    apply_configuration( r );
+
+    actions.heading( module );
+
+    for( std::map< std::string, std::set< std::string > >::iterator i = deps.begin(); i != deps.end(); ++i )
+    {
+        if( i->first == module && !include_self ) continue;
+
+        actions.module_start( i->first );
+
+        for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
+        {
+            actions.header_start( *j );
+
+            std::set< std::string > const & f = from[ *j ];
+
+            for( std::set< std::string >::const_iterator k = f.begin(); k != f.end(); ++k )
+            {
+                actions.from_header( *k );
+            }
+
+            actions.header_end( *j );
+        }
+
+        actions.module_end( i->first );
+    }
+}
+
+static void scan_module_dependencies( std::string const & module, module_primary_actions & actions, bool track_sources, bool track_tests, bool include_self )
+{
+    scan_result r;
+
+    scan_module_files( module, track_sources, track_tests, r );
+    merge_scan_result( r );
+
+    report_module_dependencies( module, r, actions, include_self );
+}
+
+// adds the scan of module to the dependency maps; with --config, the scan
+// is also kept, for use_configuration
+static void add_module_dependencies( std::string const & module, scan_result & r )
+{
+    if( !s_context->configs_.empty() && !s_context->preprocess_ )
+    {
+        s_context->module_scans_[ module ] = r;
+    }
+
+    build_mdmap_actions actions;
+    report_module_dependencies( module, r, actions, true );
+}
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+// blocks the producers when full and the consumers when empty
+template< class T > class bounded_queue
+{
+private:
+
+    std::deque< T > q_;
+    std::size_t capacity_;
+    bool closed_;
+
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+
+    bounded_queue( bounded_queue const & );
+    bounded_queue & operator=( bounded_queue const & );
+
+public:
+
+    explicit bounded_queue( std::size_t capacity ): capacity_( capacity ), closed_( false )
+    {
+    }
+
+    void push( T const & x )
+    {
+        std::unique_lock< std::mutex > lock( mutex_ );
+
+        while( q_.size() >= capacity_ )
+        {
+            not_full_.wait( lock );
+        }
+
+        q_.push_back( x );
+        not_empty_.notify_one();
+    }
+
+    // returns false when the queue is closed and empty
+    bool pop( T & x )
+    {
+        std::unique_lock< std::mutex > lock( mutex_ );
+
+        while( q_.empty() && !closed_ )
+        {
+            not_empty_.wait( lock );
+        }
+
+        if( q_.empty() ) return false;
+
+        x = q_.front();
+        q_.pop_front();
+
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard< std::mutex > lock( mutex_ );
+
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+};
+
+// a batch of files of a module, or the end of the module, on its way
+// through the pipeline
+struct scan_item
+{
+    std::size_t module_;
+
+    std::vector< std::string > names_;
+    std::vector< fs::path > paths_;
+    std::vector< std::string > texts_;
+    scan_result result_;
+
+    // the end of a module, after files_ files
+    bool end_;
+    std::size_t files_;
+    std::string error_;
+
+    scan_item(): module_(), end_( false ), files_()
+    {
+    }
+};
+
+// the walk stage finds the files of each module, the read stages read
+// them, the parse stages extract their includes, and the merge stage
+// updates the maps in module order
+struct scan_pipeline
+{
+    // the stages scan in the context of the thread that started them
+    context * context_;
+
+    std::vector< std::string > modules_;
+
+    bool track_sources_;
+    bool track_tests_;
+
+    bounded_queue< scan_item * > read_queue_;
+    bounded_queue< scan_item * > parse_queue_;
+    bounded_queue< scan_item * > merge_queue_;
+
+    // the last stage of each kind to finish closes the next queue
+    std::atomic< int > readers_;
+    std::atomic< int > parsers_;
+
+    explicit scan_pipeline( std::size_t capacity ): context_(), track_sources_(), track_tests_(),
+        read_queue_( capacity ), parse_queue_( capacity ), merge_queue_( capacity ), readers_( 0 ), parsers_( 0 )
+    {
+    }
+};
+
+struct walk_stage_visitor: public module_file_visitor
+{
+    scan_pipeline & p_;
+    std::size_t module_;
+    std::size_t files_;
+
+    scan_item * item_;
+
+    walk_stage_visitor( scan_pipeline & p, std::size_t module ): p_( p ), module_( module ), files_( 0 ), item_( 0 )
+    {
+    }
+
+    ~walk_stage_visitor()
+    {
+        delete item_;
+    }
+
+    void file( std::string const & name, fs::path const & path )
+    {
+        if( item_ == 0 )
+        {
+            item_ = new scan_item;
+            item_->module_ = module_;
+        }
+
+        item_->names_.push_back( name );
+        item_->paths_.push_back( path );
+
+        ++files_;
+
+        // passing single files costs more than scanning them
+        if( item_->names_.size() >= read_batch_size )
+        {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if( item_ != 0 )
+        {
+            p_.read_queue_.push( item_ );
+            item_ = 0;
+        }
+    }
+};
+
+static void walk_stage( scan_pipeline * p, int thread )
+{
+    context_scope cs( *p->context_ );
+    profile_scope ps( "scan: walk", "phase", thread );
+
+    for( std::size_t k = 0; k < p->modules_.size(); ++k )
+    {
+        walk_stage_visitor visitor( *p, k );
+
+        scan_item * end = new scan_item;
+
+        try
+        {
+            walk_module_files( p->modules_[ k ], p->track_sources_, p->track_tests_, visitor );
+        }
+        catch( fs::filesystem_error const & x )
+        {
+            end->error_ = x.what();
+        }
+
+        visitor.flush();
+
+        end->module_ = k;
+        end->end_ = true;
+        end->files_ = visitor.files_;
+
+        p->merge_queue_.push( end );
+    }
+
+    p->read_queue_.close();
+}
+
+static void read_stage( scan_pipeline * p, int thread )
+{
+    context_scope cs( *p->context_ );
+    profile_scope ps( "scan: read", "phase", thread );
+
+    scan_item * item;
+
+    file_reader reader( p->context_->reader_ );
+
+    while( p->read_queue_.pop( item ) )
+    {
+        // an exception escaping a stage would terminate the program;
+        // the merge stage reports it along with the module instead
+        try
+        {
+            profile_scope ps2( p->modules_[ item->module_ ], "scan", thread );
+
+            reader.read( item->paths_, item->texts_ );
+            item->result_.counters.files += item->paths_.size();
+        }
+        catch( std::exception const & x )
+        {
+            item->error_ = x.what();
+        }
+
+        p->parse_queue_.push( item );
+    }
+
+    if( --p->readers_ == 0 )
+    {
+        p->parse_queue_.close();
+    }
+}
+
+static void parse_stage( scan_pipeline * p, int thread )
+{
+    context_scope cs( *p->context_ );
+    profile_scope ps( "scan: parse", "phase", thread );
+
+    scan_item * item;
+
+    while( p->parse_queue_.pop( item ) )
+    {
+        // a batch that could not be read is passed on as is
+        if( item->error_.empty() )
+        {
+            try
+            {
+                profile_scope ps2( p->modules_[ item->module_ ], "scan", thread );
+
+                for( std::size_t i = 0; i < item->names_.size(); ++i )
+                {
+                    scan_header_dependencies( item->names_[ i ], item->texts_[ i ], item->result_ );
+                }
+            }
+            catch( std::exception const & x )
+            {
+                item->error_ = x.what();
+            }
+        }
+
+        std::vector< std::string >().swap( item->texts_ );
+
+        p->merge_queue_.push( item );
+    }
+
+    if( --p->parsers_ == 0 )
+    {
+        p->merge_queue_.close();
+    }
+}
+
+static void add_scan_result( scan_result & r, scan_result & r2 )
+{
+    if( r.sizes.empty() )
+    {
+        std::swap( r.deps, r2.deps );
+        std::swap( r.from, r2.from );
+        std::swap( r.conditions, r2.conditions );
+        std::swap( r.sizes, r2.sizes );
+        std::swap( r.unguarded, r2.unguarded );
+        r.counters.add( r2.counters );
+
+        return;
+    }
+
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = r2.deps.begin(); i != r2.deps.end(); ++i )
+    {
+        r.deps[ i->first ].insert( i->second.begin(), i->second.end() );
+    }
+
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = r2.from.begin(); i != r2.from.end(); ++i )
+    {
+        r.from[ i->first ].insert( i->second.begin(), i->second.end() );
+    }
+
+    r.conditions.insert( r2.conditions.begin(), r2.conditions.end() );
+    r.sizes.insert( r2.sizes.begin(), r2.sizes.end() );
+    r.unguarded.insert( r2.unguarded.begin(), r2.unguarded.end() );
+    r.counters.add( r2.counters );
+}
+
+static void run_scan_pipeline( std::vector< std::string > const & modules, bool track_sources, bool track_tests, module_scan_listener * listener )
+{
+    std::size_t const capacity = 256;
+
+    scan_pipeline p( capacity );
+
+    p.context_ = s_context;
+    p.modules_ = modules;
+    p.track_sources_ = track_sources;
+    p.track_tests_ = track_tests;
+
+    int const jobs = s_context->jobs_;
+
+    p.readers_ = jobs;
+    p.parsers_ = jobs;
+
+    std::vector< std::thread > threads;
+
+    threads.push_back( std::thread( walk_stage, &p, 1 ) );
+
+    for( int i = 0; i < jobs; ++i )
+    {
+        threads.push_back( std::thread( read_stage, &p, 2 + i ) );
+        threads.push_back( std::thread( parse_stage, &p, 2 + jobs + i ) );
+    }
+
+    // merge stage; a module is complete when its end has arrived
+    // along with all of its files
+
+    std::size_t const n = p.modules_.size();
+
+    std::vector< scan_result > results( n );
+    std::vector< std::size_t > files( n );
+    std::vector< std::size_t > expected( n, static_cast< std::size_t >( -1 ) );
+    std::vector< std::string > errors( n );
+
+    std::size_t next = 0;
+
+    scan_item * item;
+
+    while( p.merge_queue_.pop( item ) )
+    {
+        std::size_t k = item->module_;
+
+        if( item->end_ )
+        {
+            expected[ k ] = item->files_;
+        }
+        else
+        {
+            add_scan_result( results[ k ], item->result_ );
+            files[ k ] += item->names_.size();
+        }
+
+        if( !item->error_.empty() )
+        {
+            if( !errors[ k ].empty() )
+            {
+                errors[ k ] += '\n';
+            }
+
+            errors[ k ] += item->error_;
+        }
+
+        delete item;
+
+        for( ; next < n && files[ next ] == expected[ next ]; ++next )
+        {
+            if( !errors[ next ].empty() )
+            {
+                std::cout << errors[ next ] << std::endl;
+            }
+
+            merge_scan_result( results[ next ] );
+            add_module_dependencies( p.modules_[ next ], results[ next ] );
+
+            results[ next ] = scan_result();
+
+            if( listener )
+            {
+                listener->module_scanned( p.modules_[ next ] );
+            }
+        }
+    }
+
+    for( std::size_t i = 0; i < threads.size(); ++i )
+    {
+        threads[ i ].join();
+    }
+}
+
+#endif
+
+// scans the given modules into the dependency maps, in order
+void scan_modules( std::vector< std::string > const & modules, bool track_sources, bool track_tests, module_scan_listener * listener )
+{
+#if defined(BOOSTDEP_HAS_THREADS)
+
+    // the files of a --git-rev revision are read one at a time, and
+    // --preprocess shares its cache between the modules
+    if( s_context->jobs_ > 1 && !s_context->git_ && !s_context->preprocess_ )
+    {
+        run_scan_pipeline( modules, track_sources, track_tests, listener );
+        return;
+    }
+
+#endif
+
+    for( std::vector< std::string >::const_iterator i = modules.begin(); i != modules.end(); ++i )
+    {
+        {
+            profile_scope ps( *i, "scan" );
+
+            scan_result r;
+
+            scan_module_files( *i, track_sources, track_tests, r );
+            merge_scan_result( r );
+
+            add_module_dependencies( *i, r );
+        }
+
+        if( listener )
+        {
+            listener->module_scanned( *i );
+        }
+    }
+}
+
+void build_module_dependency_map( bool track_sources, bool track_tests, module_scan_listener * listener)
+{
+    profile_scope ps( "build_module_dependency_map" );
+
+    s_context->complete_ = true;
+
+    std::vector< std::string > modules( s_context->modules_.begin(), s_context->modules_.end() );
+    scan_modules( modules, track_sources, track_tests, listener );
+}
+
+void output_module_primary_report( std::string const & module, module_primary_actions & actions, bool track_sources, bool track_tests )
+{
+    try
+    {
+        scan_module_dependencies( module, actions, track_sources, track_tests, false );
+    }
+    catch( fs::filesystem_error const & x )
+    {
+        std::cout << x.what() << std::endl;
+    }
+}
+
+static void exclude( std::set< std::string > & x, std::set< std::string > const & y )
+{
+    for( std::set< std::string >::const_iterator i = y.begin(); i != y.end(); ++i )
+    {
+        x.erase( *i );
+    }
+}
+
+void output_module_secondary_report( std::string const & module, std::set< std::string> deps, module_secondary_actions & actions )
+{
+    actions.heading( module );
+
+    deps.insert( module );
+
+    // build transitive closure
+
+    for( ;; )
+    {
+        std::set< std::string > deps2( deps );
+
+        for( std::set< std::string >::iterator i = deps.begin(); i != deps.end(); ++i )
+        {
+            std::set< std::string > deps3 = s_context->module_deps_[ *i ];
+
+            exclude( deps3, deps );
+
+            if( deps3.empty() )
+            {
+                continue;
+            }
+
+            actions.module_start( *i );
+
+            for( std::set< std::string >::iterator j = deps3.begin(); j != deps3.end(); ++j )
+            {
+                actions.module_adds( *j );
+            }
+
+            actions.module_end( *i );
+
+            deps2.insert( deps3.begin(), deps3.end() );
+        }
+
+        if( deps == deps2 )
+        {
+            break;
+        }
+        else
+        {
+            deps = deps2;
+        }
+    }
+}
+
+void output_module_secondary_report( std::string const & module, module_secondary_actions & actions )
+{
+    output_module_secondary_report( module, s_context->module_deps_[ module ], actions );
+}
+
+// level_map[ M ] is the level of M, or unknown_level
+void compute_module_levels( std::map< std::string, int > & level_map )
+{
+    profile_scope ps( "compute_module_levels" );
+
+    // build module level map
+
+    level_map.clear();
+
+    for( std::set< std::string >::iterator i = s_context->modules_.begin(); i != s_context->modules_.end(); ++i )
+    {
+        if( s_context->module_deps_[ *i ].empty() )
+        {
+            level_map[ *i ] = 0;
+            // std::cerr << *i << ": " << 0 << std::endl;
+        }
+        else
+        {
+            level_map[ *i ] = unknown_level;
+        }
+    }
+
+    // build transitive closure to see through cycles
+
+    std::map< std::string, std::set< std::string > > deps2 = s_context->module_deps_;
+
+    {
+        bool done;
+
+        do
+        {
+            done = true;
+
+            for( std::map< std::string, std::set< std::string > >::iterator i = deps2.begin(); i != deps2.end(); ++i )
+            {
+                std::set< std::string > tmp = i->second;
+
+                for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
+                {
+                    std::set< std::string > tmp2 = deps2[ *j ];
+                    tmp.insert( tmp2.begin(), tmp2.end() );
+                }
+
+                if( tmp.size() != i->second.size() )
+                {
+                    i->second = tmp;
+                    done = false;
+                }
+            }
+        }
+        while( !done );
+    }
+
+    // compute acyclic levels
+
+    for( int k = 1, n = s_context->modules_.size(); k < n; ++k )
+    {
+        for( std::map< std::string, std::set< std::string > >::iterator i = s_context->module_deps_.begin(); i != s_context->module_deps_.end(); ++i )
+        {
+            // i->first depends on i->second
+
+            if( level_map[ i->first ] >= unknown_level )
+            {
+                int level = 0;
+
+                for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
+                {
+                    level = std::max( level, level_map[ *j ] + 1 );
+                }
+
+                if( level == k )
+                {
+                    level_map[ i->first ] = level;
+                    // std::cerr << i->first << ": " << level << std::endl;
+                }
+            }
+        }
+    }
+
+    // min_level_map[ M ] == L means the level is unknown, but at least L
+    std::map< std::string, int > min_level_map;
+
+    // initialize min_level_map for acyclic dependencies
+
+    for( std::map< std::string, int >::iterator i = level_map.begin(); i != level_map.end(); ++i )
+    {
+        if( i->second < unknown_level )
+        {
+            min_level_map[ i->first ] = i->second;
+        }
+    }
+
+    // compute levels for cyclic modules
+
+    for( int k = 1, n = s_context->modules_.size(); k < n; ++k )
+    {
+        for( std::map< std::string, std::set< std::string > >::iterator i = s_context->module_deps_.begin(); i != s_context->module_deps_.end(); ++i )
+        {
+            if( level_map[ i->first ] >= unknown_level )
+            {
+                int level = 0;
+
+                for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
+                {
+                    int jl = level_map[ *j ];
+
+                    if( jl < unknown_level )
+                    {
+                        level = std::max( level, jl + 1 );
+                    }
+                    else
+                    {
+                        int ml = min_level_map[ *j ];
+
+                        if( deps2[ *j ].count( i->first ) == 0 )
+                        {
+                            // *j does not depend on i->first, so
+                            // the level of i->first is at least
+                            // 1 + the minimum level of *j
+
+                            ++ml;
+                        }
+
+                        level = std::max( level, ml );
+                    }
+                }
+
+                min_level_map[ i->first ] = level;
+            }
+        }
+    }
+
+    // use the minimum level for cyclic modules when known
+
+    for( std::map< std::string, int >::iterator i = level_map.begin(); i != level_map.end(); ++i )
+    {
+        if( i->second >= unknown_level )
+        {
+            int min_level = min_level_map[ i->first ];
+
+            if( min_level != 0 )
+            {
+                i->second = min_level;
+            }
+        }
+    }
+}
+
+void output_module_level_report( module_level_actions & actions )
+{
+    std::map< std::string, int > level_map;
+    compute_module_levels( level_map );
+
+    // reverse level map
+
+    std::map< int, std::set< std::string > > reverse_level_map;
+
+    for( std::map< std::string, int >::iterator i = level_map.begin(); i != level_map.end(); ++i )
+    {
+        reverse_level_map[ i->second ].insert( i->first );
+    }
+
+    // output report
+
+    actions.begin();
+
+    for( std::map< int, std::set< std::string > >::iterator i = reverse_level_map.begin(); i != reverse_level_map.end(); ++i )
+    {
+        actions.level_start( i->first );
+
+        for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); ++j )
+        {
+            actions.module_start( *j );
+
+            std::set< std::string > mdeps = s_context->module_deps_[ *j ];
+
+            for( std::set< std::string >::iterator k = mdeps.begin(); k != mdeps.end(); ++k )
+            {
+                actions.module2( *k, level_map[ *k ] );
+            }
+
+            actions.module_end( *j );
+        }
+
+        actions.level_end( i->first );
+    }
+
+    actions.end();
+}
+
+// gather secondary dependencies of modules
+void compute_secondary_dependencies( std::set< std::string > const & modules, std::map< std::string, std::set< std::string > > & secondary_deps )
+{
+    profile_scope ps( "compute_secondary_dependencies" );
+
+    struct build_secondary_deps: public module_secondary_actions
+    {
+        std::map< std::string, std::set< std::string > > * pm_;
+
+        build_secondary_deps( std::map< std::string, std::set< std::string > > * pm ): pm_( pm )
+        {
+        }
+
+        std::string module_;
+
+        void heading( std::string const & module )
+        {
+            module_ = module;
+        }
+
+        void module_start( std::string const & /*module*/ )
+        {
+        }
+
+        void module_end( std::string const & /*module*/ )
+        {
+        }
+
+        void module_adds( std::string const & module )
+        {
+            (*pm_)[ module_ ].insert( module );
+        }
+    };
+
+    build_secondary_deps bsd( &secondary_deps );
+
+    for( std::set< std::string >::const_iterator i = modules.begin(); i != modules.end(); ++i )
+    {
+        secondary_deps.erase( *i );
+        output_module_secondary_report( *i, bsd );
+    }
+}
+
+void add_module_headers( fs::path const & dir, std::set<std::string> & headers )
+{
+    std::vector< std::string > files;
+    list_module_files( dir, files );
+
+    for( std::vector< std::string >::const_iterator i = files.begin(); i != files.end(); ++i )
+    {
+        // keep the names relative, as in walk_module_path
+        headers.insert( dir.generic_string() + '/' + *i );
+    }
+}
+
+// includes holds the #includes of the files in headers
+// scans file for #includes, unless it has been scanned already
+static void scan_file_lazily( std::string const & file )
+{
+    if( !s_context->lazy_scanned_.insert( file ).second ) return;
+
+    // headers are found in their module, other files relative to the root
+    std::string const * module = find_header_module( file );
+    fs::path path = module? module_include_path( *module ) / file: fs::path( file );
+
+    if( !s_context->git_ && !fs::is_regular_file( root_path( path ) ) ) return;
+
+    scan_result r;
+
+    scan_file( path, file, r );
+    merge_scan_result( r );
+
+    std::set< std::string > & inc = s_context->header_includes_[ file ];
+
+    for( std::map< std::string, std::set< std::string > >::const_iterator j = r.from.begin(); j != r.from.end(); ++j )
+    {
+        inc.insert( j->first );
+    }
+}
+
+// scans the files reachable from files through #includes, stopping at
+// the files already scanned; used when the subset of the graph under a
+// few files is needed, and all modules haven't been scanned yet
+void scan_reachable_files( std::set< std::string > const & files )
+{
+    profile_scope ps( "scan_reachable_files" );
+
+    std::set< std::string > visited( files );
+    std::vector< std::string > stack( files.begin(), files.end() );
+
+    while( !stack.empty() )
+    {
+        std::string file = stack.back();
+        stack.pop_back();
+
+        scan_file_lazily( file );
+
+        std::set< std::string > const & inc = s_context->header_includes_[ file ];
+
+        for( std::set< std::string >::const_iterator i = inc.begin(); i != inc.end(); ++i )
+        {
+            if( visited.insert( *i ).second )
+            {
+                stack.push_back( *i );
+            }
+        }
+    }
+}
+
+void output_module_subset_report_( std::string const & module, std::set<std::string> const & headers, std::map< std::string, std::set<std::string> > const & includes, module_subset_actions & actions )
+{
+    // build header closure
+
+    // header -> (header)*
+    std::map< std::string, std::set<std::string> > inc2;
+
+    // (header, header) -> path
+    std::map< std::pair<std::string, std::string>, std::vector<std::string> > paths;
+
+    for( std::set<std::string>::const_iterator i = headers.begin(); i != headers.end(); ++i )
+    {
+        std::set<std::string> & s = inc2[ *i ];
+
+        std::map< std::string, std::set<std::string> >::const_iterator it = includes.find( *i );
+
+        if( it != includes.end() )
+        {
+            s = it->second;
+        }
+
+        for( std::set<std::string>::const_iterator j = s.begin(); j != s.end(); ++j )
+        {
+            std::vector<std::string> & v = paths[ std::make_pair( *i, *j ) ];
+
+            v.resize( 0 );
+            v.push_back( *i );
+            v.push_back( *j );
+        }
+    }
+
+    for( ;; )
+    {
+        bool r = false;
+
+        for( std::map< std::string, std::set<std::string> >::iterator i = inc2.begin(); i != inc2.end(); ++i )
+        {
+            std::set<std::string> & s2 = i->second;
+
+            for( std::set<std::string>::const_iterator j = s2.begin(); j != s2.end(); ++j )
+            {
+                std::set<std::string> const & s = s_context->header_includes_[ *j ];
+
+                for( std::set<std::string>::const_iterator k = s.begin(); k != s.end(); ++k )
+                {
+                    if( s2.count( *k ) == 0 )
+                    {
+                        s2.insert( *k );
+
+                        std::vector<std::string> const & v1 = paths[ std::make_pair( i->first, *j ) ];
+                        std::vector<std::string> & v2 = paths[ std::make_pair( i->first, *k ) ];
+
+                        v2 = v1;
+                        v2.push_back( *k );
+
+                        r = true;
+                    }
+                }
+            }
+        }
+
+        if( !r ) break;
+    }
+
+    // module -> header -> path [header -> header -> header]
+    std::map< std::string, std::map< std::string, std::vector<std::string> > > subset;
+
+    for( std::set<std::string>::const_iterator i = headers.begin(); i != headers.end(); ++i )
+    {
+        std::set<std::string> const & s = inc2[ *i ];
+
+        for( std::set<std::string>::const_iterator j = s.begin(); j != s.end(); ++j )
+        {
+            std::map< std::string, std::string >::const_iterator im = s_context->header_map_.find( *j );
+
+            if( im == s_context->header_map_.end() || im->second.empty() ) continue;
+
+            std::string const & m = im->second;
+
+            std::vector<std::string> const & path = paths[ std::make_pair( *i, *j ) ];
+
+            if( subset.count( m ) == 0 || subset[ m ].count( *i ) == 0 || subset[ m ][ *i ].size() > path.size() )
+            {
+                subset[ m ][ *i ] = path;
+            }
+        }
+    }
+
+    actions.heading( module );
+
+    for( std::map< std::string, std::map< std::string, std::vector<std::string> > >::const_iterator i = subset.begin(); i != subset.end(); ++i )
+    {
+        if( i->first == module ) continue;
+
+        actions.module_start( i->first );
+
+        int k = 0;
+
+        for( std::map< std::string, std::vector<std::string> >::const_iterator j = i->second.begin(); j != i->second.end() && k < 4; ++j, ++k )
+        {
+            actions.from_path( j->second );
+        }
+
+        actions.module_end( i->first );
+    }
+}
+
+int module_weight( std::string const & module, std::map< std::string, std::set< std::string > > & secondary_deps )
+{
+    return s_context->module_deps_[ module ].size() + secondary_deps[ module ].size();
+}
+
+bool find_boost_root( fs::path & root )
+{
+    fs::path p = fs::current_path();
+
+    for( int i = 0; i < 32; ++i )
+    {
+        if( fs::exists( p / "Jamroot" ) )
+        {
+            root = p;
+            return true;
+        }
+
+        if( p == p.root_path() )
+        {
+            return false;
+        }
+
+        p = p.parent_path();
+    }
+
+    return false;
+}
+
+bool is_boost_root( fs::path const & p )
+{
+    return fs::exists( p / "Jamroot" );
+}
+
+// --watch
+
+void reset_dependency_maps()
+{
+    s_context->header_map_.clear();
+    s_context->module_headers_.clear();
+    s_context->modules_.clear();
+
+    s_context->module_deps_.clear();
+    s_context->header_deps_.clear();
+    s_context->reverse_deps_.clear();
+    s_context->header_includes_.clear();
+    s_context->header_included_by_.clear();
+
+    s_context->complete_ = false;
+    s_context->lazy_scanned_.clear();
+
+    s_context->header_map_complete_ = false;
+    s_context->unresolved_headers_.clear();
+    s_context->module_roots_.clear();
+    s_context->module_roots_loaded_ = false;
+    s_context->directory_entries_.clear();
+    s_context->exceptions_.clear();
+    s_context->exceptions_loaded_ = false;
+
+    s_context->git_indexes_.clear();
+    s_context->module_dirs_.clear();
+    s_context->module_scans_.clear();
+    s_context->preprocessor_.clear();
+}
+
+// replaces what the kept scan r of a module records of file with r2, the
+// scan of file alone
+static void replace_file_scan( scan_result & r, std::string const & file, scan_result const & r2 )
+{
+    for( std::map< std::string, std::set< std::string > >::iterator i = r.deps.begin(); i != r.deps.end(); )
+    {
+        for( std::set< std::string >::iterator j = i->second.begin(); j != i->second.end(); )
+        {
+            std::set< std::string > & f = r.from[ *j ];
+
+            f.erase( file );
+
+            if( f.empty() )
+            {
+                r.from.erase( *j );
+                i->second.erase( j++ );
+            }
+            else
+            {
+                ++j;
+            }
+        }
+
+        if( i->second.empty() )
+        {
+            r.deps.erase( i++ );
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    for( std::map< std::pair< std::string, std::string >, std::string >::iterator i = r.conditions.begin(); i != r.conditions.end(); )
+    {
+        if( i->first.first == file )
+        {
+            r.conditions.erase( i++ );
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    r.sizes.erase( file );
+    r.unguarded.erase( file );
+
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = r2.deps.begin(); i != r2.deps.end(); ++i )
+    {
+        r.deps[ i->first ].insert( i->second.begin(), i->second.end() );
+    }
+
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = r2.from.begin(); i != r2.from.end(); ++i )
+    {
+        r.from[ i->first ].insert( i->second.begin(), i->second.end() );
+    }
+
+    r.conditions.insert( r2.conditions.begin(), r2.conditions.end() );
+    r.sizes.insert( r2.sizes.begin(), r2.sizes.end() );
+    r.unguarded.insert( r2.unguarded.begin(), r2.unguarded.end() );
+}
+
+// removes to from the set of from, and the set when it's left empty, as a
+// scan wouldn't have added it
+static void erase_edge( std::map< std::string, std::set< std::string > > & m, std::string const & from, std::string const & to )
+{
+    std::map< std::string, std::set< std::string > >::iterator i = m.find( from );
+
+    if( i == m.end() ) return;
+
+    i->second.erase( to );
+
+    if( i->second.empty() )
+    {
+        m.erase( i );
+    }
+}
+
+// rescans a single file and replaces its edges in the header maps
+void update_header_dependencies( std::string const & module, std::string const & header, fs::path const & path )
+{
+    // the preprocessed files no longer match
+    s_context->preprocessor_.clear();
+
+    {
+        std::set< std::string > & inc = s_context->header_includes_[ header ];
+
+        for( std::set< std::string >::const_iterator i = inc.begin(); i != inc.end(); ++i )
+        {
+            erase_edge( s_context->header_included_by_, *i, header );
+            erase_edge( s_context->header_deps_, *i, header );
+        }
+    }
+
+    s_context->header_includes_.erase( header );
+
+    scan_result r;
+
+    if( fs::exists( root_path( path ) ) )
+    {
+        std::string text;
+        read_file( path, text );
+
+        ++r.counters.files;
+
+        scan_header_dependencies( header, text, r );
+        merge_scan_result( r );
+    }
+
+    // with --config, the kept scan of the module stays current, so that
+    // --use-config doesn't need to rescan all modules
+    std::map< std::string, scan_result >::iterator k = s_context->module_scans_.find( module );
+
+    if( k != s_context->module_scans_.end() )
+    {
+        replace_file_scan( k->second, header, r );
+    }
+
+    // the maps hold the includes of the --use-config configuration only
+    apply_configuration( r );
+
+    for( std::map< std::string, std::set< std::string > >::const_iterator i = r.deps.begin(); i != r.deps.end(); ++i )
+    {
+        for( std::set< std::string >::const_iterator j = i->second.begin(); j != i->second.end(); ++j )
+        {
+            if( i->first != module )
+            {
+                s_context->header_deps_[ *j ].insert( header );
+            }
+
+            s_context->header_includes_[ header ].insert( *j );
+            s_context->header_included_by_[ *j ].insert( header );
+        }
+    }
+}
+
+static void add_scanned_files( fs::path const & dir, std::set< std::string > & files )
+{
+    std::string const prefix = dir.generic_string() + '/';
+
+    std::map< std::string, std::set< std::string > >::const_iterator i = s_context->header_includes_.lower_bound( prefix );
+
+    for( ; i != s_context->header_includes_.end() && i->first.compare( 0, prefix.size(), prefix ) == 0; ++i )
+    {
+        files.insert( i->first );
+    }
+}
+
+// recomputes the module edges of module from the header edges of its files
+void update_module_dependencies( std::string const & module, bool track_sources, bool track_tests )
+{
+    std::set< std::string > files = s_context->module_headers_[ module ];
+
+    if( track_sources )
+    {
+        add_scanned_files( module_source_path( module ), files );
+    }
+
+    if( track_tests )
+    {
+        add_scanned_files( module_test_path( module ), files );
+    }
+
+    std::set< std::string > deps;
+
+    for( std::set< std::string >::const_iterator i = files.begin(); i != files.end(); ++i )
+    {
+        std::map< std::string, std::set< std::string > >::const_iterator j = s_context->header_includes_.find( *i );
+
+        if( j == s_context->header_includes_.end() ) continue;
+
+        for( std::set< std::string >::const_iterator k = j->second.begin(); k != j->second.end(); ++k )
+        {
+            std::map< std::string, std::string >::const_iterator m = s_context->header_map_.find( *k );
+
+            std::string const & m2 = m != s_context->header_map_.end()? m->second: "(unknown)";
+
+            if( m2 != module )
+            {
+                deps.insert( m2 );
+            }
+        }
+    }
+
+    std::set< std::string > & old = s_context->module_deps_[ module ];
+
+    for( std::set< std::string >::const_iterator i = old.begin(); i != old.end(); ++i )
+    {
+        if( deps.count( *i ) == 0 )
+        {
+            erase_edge( s_context->reverse_deps_, *i, module );
+        }
+    }
+
+    for( std::set< std::string >::const_iterator i = deps.begin(); i != deps.end(); ++i )
+    {
+        s_context->reverse_deps_[ *i ].insert( module );
+    }
+
+    old.swap( deps );
+}
+
+// --history
+
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+
+// appends the commits after from up to and including to, following the
+// first parent, oldest first
+static bool add_history_range( git_repository & repo, std::string const & range, std::vector< history_entry > & entries )
+{
+    std::string::size_type k = range.find( ".." );
+
+    std::string from, to;
+
+    if( !repo.resolve( range.substr( 0, k ), from ) || !repo.resolve( range.substr( k + 2 ), to ) )
+    {
+        return false;
+    }
+
+    git_commit_info c;
+
+    if( !repo.read_commit( from, c ) ) return false;
+
+    from = c.id;
+
+    std::vector< history_entry > range_entries;
+
+    for( std::string id = to; id != from; )
+    {
+        history_entry e;
+
+        if( !repo.read_commit( id, e.commit ) ) return false;
+
+        e.revision = git_hex( e.commit.id );
+        range_entries.push_back( e );
+
+        if( e.commit.parents.empty() ) break;
+
+        id = e.commit.parents.front();
+    }
+
+    entries.insert( entries.end(), range_entries.rbegin(), range_entries.rend() );
+    return true;
+}
+
+// revisions is a comma-separated list of revisions and <from>..<to>
+// ranges, or @file with one per line
+static bool read_history_revisions( git_repository & repo, std::string const & revisions, std::vector< history_entry > & entries )
+{
+    std::vector< std::string > revs;
+
+    if( !revisions.empty() && revisions[ 0 ] == '@' )
+    {
+        fs::ifstream is( root_path( revisions.substr( 1 ) ) );
+
+        if( !is )
+        {
+            std::cerr << "'" << revisions.substr( 1 ) << "': could not open file.\n";
+            return false;
+        }
+
+        std::string line;
+
+        while( std::getline( is, line ) )
+        {
+            if( !line.empty() && line[ line.size() - 1 ] == '\r' )
+            {
+                line.erase( line.size() - 1 );
+            }
+
+            if( !line.empty() && line[ 0 ] != '#' )
+            {
+                revs.push_back( line );
+            }
+        }
+    }
+    else
+    {
+        std::istringstream is( revisions );
+        std::string rev;
+
+        while( std::getline( is, rev, ',' ) )
+        {
+            if( !rev.empty() ) revs.push_back( rev );
+        }
+    }
+
+    for( std::vector< std::string >::const_iterator i = revs.begin(); i != revs.end(); ++i )
+    {
+        if( i->find( ".." ) != std::string::npos )
+        {
+            if( !add_history_range( repo, *i, entries ) )
+            {
+                std::cerr << "'" << *i << "': not a valid revision range.\n";
+                return false;
+            }
+
+            continue;
+        }
+
+        history_entry e;
+        e.revision = *i;
+
+        std::string id;
+
+        if( !repo.resolve( *i, id ) || !repo.read_commit( id, e.commit ) )
+        {
+            std::cerr << "'" << *i << "': not a valid revision.\n";
+            return false;
+        }
+
+        entries.push_back( e );
+    }
+
+    return true;
+}
+
+// scans the revision of e in a context of its own; the parsed files
+// are shared through the store
+static void compute_history_entry( git_store & store, fs::path const & root, bool track_sources, bool track_tests, history_entry & e, int thread )
+{
+    profile_scope ps( e.revision, "revision", thread );
+
+    git_revision rev( store, e.commit.tree );
+
+    if( !rev.valid() || !rev.exists( "Jamroot" ) )
+    {
+        e.error = "'" + e.revision + "': not a valid Boost root.";
+        return;
+    }
+
+    context ctx;
+
+    ctx.root_ = root;
+    ctx.git_ = &rev;
+
+    context_scope cs( ctx );
+
+    enable_header_map();
+    build_module_dependency_map( track_sources, track_tests );
+
+    compute_module_levels( e.levels );
+
+    std::map< std::string, std::set< std::string > > secondary_deps;
+    compute_secondary_dependencies( ctx.modules_, secondary_deps );
+
+    for( std::set< std::string >::const_iterator i = ctx.modules_.begin(); i != ctx.modules_.end(); ++i )
+    {
+        e.weights[ *i ] = module_weight( *i, secondary_deps );
+    }
+
+    e.counters = ctx.scan_counters_;
+}
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+struct history_state
+{
+    git_store * store_;
+    fs::path root_;
+
+    bool track_sources_;
+    bool track_tests_;
+
+    std::vector< history_entry > * entries_;
+
+    std::mutex mutex_;
+    std::size_t next_;
+};
+
+static void history_worker( history_state * p, int thread )
+{
+    for( ;; )
+    {
+        std::size_t k;
+
+        {
+            std::lock_guard< std::mutex > lock( p->mutex_ );
+
+            if( p->next_ == p->entries_->size() ) return;
+
+            k = p->next_++;
+        }
+
+        compute_history_entry( *p->store_, p->root_, p->track_sources_, p->track_tests_, ( *p->entries_ )[ k ], thread );
+    }
+}
+
+#endif
+
+bool compute_history( fs::path const & root, std::string const & revisions, bool track_sources, bool track_tests, std::vector< history_entry > & entries )
+{
+    git_store store;
+
+    if( !store.open( root ) )
+    {
+        std::cerr << "'" << root.string() << "': not a git repository.\n";
+        return false;
+    }
+
+    if( !read_history_revisions( store.superproject(), revisions, entries ) ) return false;
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+    std::size_t jobs = s_context->jobs_ > 1? s_context->jobs_: 1;
+
+    if( jobs > entries.size() )
+    {
+        jobs = entries.size();
+    }
+
+    if( jobs > 1 )
+    {
+        history_state p;
+
+        p.store_ = &store;
+        p.root_ = root;
+        p.track_sources_ = track_sources;
+        p.track_tests_ = track_tests;
+        p.entries_ = &entries;
+        p.next_ = 0;
+
+        std::vector< std::thread > threads;
+
+        for( std::size_t i = 0; i < jobs; ++i )
+        {
+            threads.push_back( std::thread( history_worker, &p, static_cast< int >( i + 1 ) ) );
+        }
+
+        for( std::size_t i = 0; i < threads.size(); ++i )
+        {
+            threads[ i ].join();
+        }
+    }
+    else
+
+#endif
+
+    {
+        for( std::size_t i = 0; i < entries.size(); ++i )
+        {
+            compute_history_entry( store, root, track_sources, track_tests, entries[ i ], 0 );
+        }
+    }
+
+    return true;
+}
+
+#endif // defined(BOOSTDEP_HAS_ZLIB)
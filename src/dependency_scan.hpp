@@ -0,0 +1,867 @@
+// dependency_scan.hpp - the scanning and dependency graph code of boostdep,
+// shared by the tool and the library
+//
+// Copyright 2014-2017 Peter Dimov
+//
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt
+
+#ifndef BOOSTDEP_DEPENDENCY_SCAN_HPP_INCLUDED
+#define BOOSTDEP_DEPENDENCY_SCAN_HPP_INCLUDED
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/config.hpp>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <queue>
+#include <algorithm>
+#include <climits>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <streambuf>
+#include <sstream>
+#include <iomanip>
+#include <new>
+#include <exception>
+
+#include <ctime>
+
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_HDR_MUTEX) && !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_HDR_CONDITION_VARIABLE) && !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+# define BOOSTDEP_HAS_THREADS
+# define BOOSTDEP_THREAD_LOCAL thread_local
+# include <thread>
+# include <mutex>
+# include <atomic>
+# include <condition_variable>
+#else
+# define BOOSTDEP_THREAD_LOCAL
+#endif
+
+namespace fs = boost::filesystem;
+
+// timing
+
+double wall_time_ms();
+
+// CPU time of the calling thread, or of the whole process
+double cpu_time_ms( bool thread );
+
+// peak resident set size of the process so far
+long peak_rss_kb();
+
+// --mem-stats; the counters are updated by the allocation functions
+// of the tool
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+typedef std::atomic< long long > memory_counter;
+
+#else
+
+typedef long long memory_counter;
+
+#endif
+
+extern bool s_mem_stats;
+
+extern memory_counter s_mem_allocations;
+extern memory_counter s_mem_allocated;
+extern memory_counter s_mem_live;
+extern memory_counter s_mem_peak;
+
+// raises s_mem_peak to live when that is higher; with --jobs, several
+// threads allocate at the same time
+inline void raise_mem_peak( long long live )
+{
+#if defined(BOOSTDEP_HAS_THREADS)
+
+    long long peak = s_mem_peak.load();
+
+    while( live > peak && !s_mem_peak.compare_exchange_weak( peak, live ) )
+    {
+    }
+
+#else
+
+    if( live > s_mem_peak )
+    {
+        s_mem_peak = live;
+    }
+
+#endif
+}
+
+// --profile
+
+struct profile_event
+{
+    std::string name;
+
+    // "phase", "command" or "scan"
+    std::string category;
+
+    // 0 is the main thread
+    int thread;
+
+    // milliseconds; start is relative to s_profile_start
+    double start;
+    double wall;
+    double cpu;
+
+    // --mem-stats; exact for the main thread only, since the
+    // allocation counters are shared between threads
+    long long allocations;
+    long long allocated;
+    long long live;
+    long long peak;
+
+    // peak RSS of the process at the end, in KB
+    long rss;
+};
+
+extern bool s_profile;
+extern double s_profile_start;
+
+extern std::vector< profile_event > s_profile_events;
+
+#if defined(BOOSTDEP_HAS_THREADS)
+
+extern std::mutex s_profile_mutex;
+
+#endif
+
+// --bench
+extern bool s_bench;
+
+// records the time and memory spent in its scope when profiling is enabled
+class profile_scope
+{
+private:
+
+    bool enabled_;
+    profile_event e_;
+
+    long long peak_;
+
+public:
+
+    explicit profile_scope( std::string const & name, char const * category = "phase", int thread = 0 ): enabled_( s_profile || s_mem_stats || s_bench )
+    {
+        if( enabled_ )
+        {
+            e_.name = name;
+            e_.category = category;
+            e_.thread = thread;
+
+            e_.allocations = s_mem_allocations;
+            e_.allocated = s_mem_allocated;
+            e_.live = s_mem_live;
+
+            // track the peak of this scope, restore the outer one on exit
+            peak_ = s_mem_peak;
+            s_mem_peak = e_.live;
+
+            e_.start = wall_time_ms();
+            e_.cpu = cpu_time_ms( thread != 0 );
+        }
+    }
+
+    ~profile_scope()
+    {
+        if( enabled_ )
+        {
+            e_.wall = wall_time_ms() - e_.start;
+            e_.cpu = cpu_time_ms( e_.thread != 0 ) - e_.cpu;
+            e_.start -= s_profile_start;
+
+            e_.allocations = s_mem_allocations - e_.allocations;
+            e_.allocated = s_mem_allocated - e_.allocated;
+            e_.live = s_mem_live - e_.live;
+            e_.peak = s_mem_peak;
+
+            e_.rss = peak_rss_kb();
+
+            raise_mem_peak( peak_ );
+
+#if defined(BOOSTDEP_HAS_THREADS)
+            std::lock_guard< std::mutex > lock( s_profile_mutex );
+#endif
+
+            s_profile_events.push_back( e_ );
+        }
+    }
+};
+
+struct file_size
+{
+    unsigned long bytes;
+    unsigned long lines;
+};
+
+struct scan_counters
+{
+    unsigned long files;
+    unsigned long bytes;
+    unsigned long includes;
+
+    // header map lookups, successful lookups
+    unsigned long lookups;
+    unsigned long hits;
+
+    scan_counters(): files(), bytes(), includes(), lookups(), hits()
+    {
+    }
+
+    void add( scan_counters const & c )
+    {
+        files += c.files;
+        bytes += c.bytes;
+        includes += c.includes;
+        lookups += c.lookups;
+        hits += c.hits;
+    }
+};
+
+// the results of scanning files; kept apart from the context so
+// that scans can proceed in parallel
+struct scan_result
+{
+    // module -> [ header, header... ]
+    std::map< std::string, std::set< std::string > > deps;
+
+    // header -> included from [ header, header... ]
+    std::map< std::string, std::set< std::string > > from;
+
+    // ( file, header ) -> the preprocessor condition under which file
+    // includes header, for conditional includes; kept with --config
+    std::map< std::pair< std::string, std::string >, std::string > conditions;
+
+    // file -> size
+    std::map< std::string, file_size > sizes;
+
+    // the files without an include guard or #pragma once
+    std::set< std::string > unguarded;
+
+    scan_counters counters;
+};
+
+// --config
+
+// a bit per configuration
+typedef unsigned long long config_mask;
+
+struct macro_definition
+{
+    // function-like macros can't be evaluated, but are expanded by
+    // --preprocess; params is the text between their parentheses
+    bool function;
+    std::string params;
+    std::string body;
+};
+
+// a named set of macro definitions, under which #if conditions are evaluated
+struct configuration
+{
+    std::string name;
+    std::map< std::string, macro_definition > macros;
+};
+
+// --preprocess
+
+// a preprocessing token of a directive
+struct pp_token
+{
+    std::string text;
+
+    // 'i'dentifier, 'n'umber, 's'tring or character literal, 'p'unctuator
+    char kind;
+
+    // preceded by white space
+    bool space;
+
+    // of identifiers, the index of the text in preprocessor_cache::names
+    std::size_t id;
+
+    // the macros that are not expanded again in the token, because it
+    // results from their expansion; interned, 0 when empty
+    std::set< std::size_t > const * hide;
+};
+
+struct pp_directive
+{
+    // include, define, if...
+    std::string name;
+
+    // the operand, without comments, as text and as tokens
+    std::string operand;
+    std::vector< pp_token > tokens;
+
+    // the number of non-empty lines before the directive that aren't
+    // directives
+    unsigned long text_before;
+};
+
+// the directives of a file; the other lines don't affect its #includes
+struct pp_file
+{
+    bool exists;
+    std::vector< pp_directive > directives;
+
+    // the macro of an #ifndef around the whole file, if any
+    std::string guard;
+
+    // #pragma once
+    bool once;
+
+    file_size size;
+};
+
+struct pp_macro
+{
+    bool function;
+    bool variadic;
+
+    // __VA_ARGS__, or the name before ..., is the last parameter of a
+    // variadic macro
+    std::vector< std::string > params;
+    std::vector< pp_token > body;
+};
+
+// macros, as indices into preprocessor_cache::names, and their
+// definitions, 0 when undefined
+typedef std::vector< std::pair< std::size_t, pp_macro const * > > pp_macro_values;
+
+// what preprocessing a file did, given the values of the macros it read
+struct pp_memo_entry
+{
+    // the macros read, before the file defined them, and the macros
+    // defined or undefined, with their values afterwards
+    pp_macro_values reads;
+    pp_macro_values writes;
+
+    // the headers the file included
+    std::set< std::string > includes;
+
+    // what preprocessing them did, as ( file, index into memo[ file ] )
+    std::vector< std::pair< std::size_t, std::size_t > > children;
+};
+
+// kept across the translation units of a scan; a copy starts empty,
+// since the macros are referred to by address
+struct preprocessor_cache
+{
+    // file -> its directives
+    std::map< std::string, pp_file > files;
+
+    // the names of the macros and files, and their indices
+    std::vector< std::string > names;
+    std::map< std::string, std::size_t > name_ids;
+
+    // the distinct macro definitions, and their text -> definition
+    std::deque< pp_macro > macros;
+    std::map< std::string, pp_macro const * > definitions;
+
+    // the macros of the configuration seed_config, by name index
+    int seed_config;
+    std::vector< pp_macro const * > seed;
+
+    // file name index -> the ways the file has been preprocessed
+    std::deque< std::vector< pp_memo_entry > > memo;
+
+    preprocessor_cache(): seed_config( -2 )
+    {
+    }
+
+    preprocessor_cache( preprocessor_cache const & ): seed_config( -2 )
+    {
+    }
+
+    preprocessor_cache & operator=( preprocessor_cache const & )
+    {
+        clear();
+        return *this;
+    }
+
+    void clear()
+    {
+        files.clear();
+        names.clear();
+        name_ids.clear();
+        macros.clear();
+        definitions.clear();
+        seed_config = -2;
+        seed.clear();
+        memo.clear();
+    }
+
+    std::size_t intern( std::string const & name )
+    {
+        std::map< std::string, std::size_t >::const_iterator i = name_ids.find( name );
+
+        if( i != name_ids.end() ) return i->second;
+
+        names.push_back( name );
+        return name_ids[ name ] = names.size() - 1;
+    }
+};
+
+// how the scans read files (--reader)
+enum reader_kind
+{
+    reader_stream,
+    reader_pread,
+    reader_io_uring
+};
+
+class git_revision;
+
+// a directory watched by --watch
+struct watched_directory
+{
+    std::string module_;
+
+    // the include, src or test directory the directory is under
+    fs::path root_;
+
+    // files under include/ are named relative to root_
+    bool include_;
+
+    // libs/ or a directory directly under it, watched only for the
+    // modules and their include, src and test directories
+    bool tree_;
+
+    fs::path path_;
+
+    watched_directory(): include_( false ), tree_( false )
+    {
+    }
+};
+
+// the state of one analysis of a Boost tree; several contexts can be
+// used at the same time from different threads
+struct context
+{
+    // relative paths such as libs/<module>/include are resolved against it
+    fs::path root_;
+
+    // --git-rev; when set, the files under the root are read from this
+    // revision instead of from the work tree
+    git_revision * git_;
+
+    // number of parallel jobs; 0 when not given
+    int jobs_;
+
+    reader_kind reader_;
+
+    // header -> module
+    std::map< std::string, std::string > header_map_;
+
+    // module -> headers
+    std::map< std::string, std::set<std::string> > module_headers_;
+
+    std::set< std::string > modules_;
+
+    // module depends on [ module, module... ]
+    std::map< std::string, std::set< std::string > > module_deps_;
+
+    // header is included by [header, header...]
+    std::map< std::string, std::set< std::string > > header_deps_;
+
+    // [ module, module... ] depend on module
+    std::map< std::string, std::set< std::string > > reverse_deps_;
+
+    // header includes [header, header...]
+    std::map< std::string, std::set< std::string > > header_includes_;
+
+    // header is included by [header, header...], including same-module inclusions
+    std::map< std::string, std::set< std::string > > header_included_by_;
+
+    // file -> size
+    std::map< std::string, file_size > file_sizes_;
+
+    // the files without an include guard or #pragma once
+    std::set< std::string > unguarded_files_;
+
+    scan_counters scan_counters_;
+
+    // all modules have been scanned, and the maps above are complete
+    bool complete_;
+
+    // header_map_, module_headers_ and modules_ are complete; until then,
+    // headers are resolved on demand
+    bool header_map_complete_;
+
+    // headers that have been found not to belong to a module
+    std::set< std::string > unresolved_headers_;
+
+    // module -> the names at the top of its include directory, for the
+    // modules that scan_submodules would find
+    std::map< std::string, std::set< std::string > > module_roots_;
+    bool module_roots_loaded_;
+
+    // directory -> its entries, and whether they are directories; for
+    // comparing the names of headers exactly, as the header map does
+    std::map< std::string, std::map< std::string, bool > > directory_entries_;
+
+    // header -> module, for the headers that don't follow the naming
+    // conventions (--list-exceptions)
+    std::map< std::string, std::string > exceptions_;
+    bool exceptions_loaded_;
+
+    // files whose #includes have been scanned on demand
+    std::set< std::string > lazy_scanned_;
+
+    // --use-git-index; the files of a module are those tracked by git,
+    // instead of those found in its directories
+    bool use_git_index_;
+
+    // work tree -> tracked files, sorted, relative to the work tree
+    std::map< std::string, std::vector< std::string > > git_indexes_;
+
+    // module -> absolute directory, for the modules of --overlay-root
+    std::map< std::string, fs::path > module_dirs_;
+
+    // --config; the configurations, and the one the dependency maps
+    // are built for, or -1 for all includes regardless of conditions
+    std::vector< configuration > configs_;
+    int active_config_;
+
+    // condition -> the configurations in which it holds
+    std::map< std::string, config_mask > condition_masks_;
+
+    // module -> the result of its scan, kept with --config so that the
+    // dependency maps can be built for another configuration
+    std::map< std::string, scan_result > module_scans_;
+
+    // --preprocess; the modules are scanned by preprocessing their files
+    // under the active configuration
+    bool preprocess_;
+    preprocessor_cache preprocessor_;
+
+    // --watch; the inotify descriptor, or -1, and watch descriptor ->
+    // the directory it watches
+    int watch_fd_;
+    std::map< int, watched_directory > watched_dirs_;
+
+    context(): git_( 0 ), jobs_( 0 ), reader_( reader_stream ), complete_( false ), header_map_complete_( false ), module_roots_loaded_( false ), exceptions_loaded_( false ), use_git_index_( false ), active_config_( -1 ), preprocess_( false ), watch_fd_( -1 )
+    {
+    }
+};
+
+// the context of the calling thread
+extern BOOSTDEP_THREAD_LOCAL context * s_context;
+
+// makes c the context of the calling thread for the duration of a scope
+class context_scope
+{
+private:
+
+    context * old_;
+
+    context_scope( context_scope const & );
+    context_scope & operator=( context_scope const & );
+
+public:
+
+    explicit context_scope( context & c ): old_( s_context )
+    {
+        s_context = &c;
+    }
+
+    ~context_scope()
+    {
+        s_context = old_;
+    }
+};
+
+// the headers a file includes, in order, with the conditions under which
+// they are included, its size, and whether it can be included only once
+struct file_includes
+{
+    std::vector< std::string > includes;
+
+    // the #if, #ifdef, #elif and #else conditions around each #include,
+    // joined with &&; empty when unconditional, or when not tracked
+    std::vector< std::string > conditions;
+
+    file_size size;
+
+    // the file has an include guard or #pragma once
+    bool guarded;
+};
+
+struct module_primary_actions
+{
+    virtual void heading( std::string const & module ) = 0;
+
+    virtual void module_start( std::string const & module ) = 0;
+    virtual void module_end( std::string const & module ) = 0;
+
+    virtual void header_start( std::string const & header ) = 0;
+    virtual void header_end( std::string const & header ) = 0;
+
+    virtual void from_header( std::string const & header ) = 0;
+};
+
+struct build_mdmap_actions: public module_primary_actions
+{
+    std::string module_;
+    std::string module2_;
+    std::string header_;
+
+    void heading( std::string const & module )
+    {
+        module_ = module;
+    }
+
+    void module_start( std::string const & module )
+    {
+        if( module != module_ )
+        {
+            s_context->module_deps_[ module_ ].insert( module );
+            s_context->reverse_deps_[ module ].insert( module_ );
+        }
+
+        module2_ = module;
+    }
+
+    void module_end( std::string const & /*module*/ )
+    {
+    }
+
+    void header_start( std::string const & header )
+    {
+        header_ = header;
+    }
+
+    void header_end( std::string const & /*header*/ )
+    {
+    }
+
+    void from_header( std::string const & header )
+    {
+        if( module_ != module2_ )
+        {
+            s_context->header_deps_[ header_ ].insert( header );
+        }
+
+        s_context->header_includes_[ header ].insert( header_ );
+        s_context->header_included_by_[ header_ ].insert( header );
+    }
+};
+
+// notified in module order as build_module_dependency_map scans the modules
+struct module_scan_listener
+{
+    virtual void module_scanned( std::string const & module ) = 0;
+};
+
+struct module_secondary_actions
+{
+    virtual void heading( std::string const & module ) = 0;
+
+    virtual void module_start( std::string const & module ) = 0;
+    virtual void module_end( std::string const & module ) = 0;
+
+    virtual void module_adds( std::string const & module ) = 0;
+};
+
+struct module_subset_actions
+{
+    virtual void heading( std::string const & module ) = 0;
+
+    virtual void module_start( std::string const & module ) = 0;
+    virtual void module_end( std::string const & module ) = 0;
+
+    virtual void from_path( std::vector<std::string> const & path ) = 0;
+};
+
+struct module_level_actions
+{
+    virtual void begin() = 0;
+    virtual void end() = 0;
+
+    virtual void level_start( int level ) = 0;
+    virtual void level_end( int level ) = 0;
+
+    virtual void module_start( std::string const & module ) = 0;
+    virtual void module_end( std::string const & module ) = 0;
+
+    virtual void module2( std::string const & module, int level ) = 0;
+};
+
+// paths
+
+// resolves a path relative to the Boost root
+fs::path root_path( fs::path const & p );
+
+fs::path module_include_path( std::string const & module );
+fs::path module_source_path( std::string const & module );
+fs::path module_build_path( std::string const & module );
+fs::path module_test_path( std::string const & module );
+
+// whether the file or directory at path, relative to the root, exists
+bool root_exists( fs::path const & path );
+
+bool find_boost_root( fs::path & root );
+bool is_boost_root( fs::path const & p );
+
+// the header map
+
+// adds the headers in the include directory of module to the header map
+void map_module_headers( std::string const & module );
+
+void build_header_map();
+void enable_header_map();
+
+// is module a module; until the header map is complete, it's enough for
+// scan_submodules to find it
+bool is_module( std::string const & module );
+
+// makes the headers of module known, without walking all modules
+void enable_module_headers( std::string const & module );
+
+// #include directives
+
+// reads the file at path, usually relative to the root, from the file
+// system
+bool read_file( fs::path const & path, std::string & text );
+
+// the #include directives of the file at path, usually relative to the
+// root
+void scan_file_includes( fs::path const & path, file_includes & f );
+
+void add_header_dependencies( std::string const & header, file_includes const & f, scan_result & r );
+void scan_header_dependencies( std::string const & header, std::string const & text, scan_result & r );
+
+// scans the file at path, usually relative to the root, as header
+void scan_file( fs::path const & path, std::string const & header, scan_result & r );
+
+// reads a configuration from the #define lines in fn, as written by
+// the -dM option of GCC and Clang
+bool add_configuration( std::string const & name, std::string const & fn );
+
+// the dependency maps
+
+void merge_scan_result( scan_result const & r );
+void apply_configuration( scan_result & r );
+
+void report_module_dependencies( std::string const & module, scan_result & r, module_primary_actions & actions, bool include_self );
+
+// scans the given modules into the dependency maps, in order
+void scan_modules( std::vector< std::string > const & modules, bool track_sources, bool track_tests, module_scan_listener * listener );
+
+void build_module_dependency_map( bool track_sources, bool track_tests, module_scan_listener * listener = 0 );
+
+void add_module_headers( fs::path const & dir, std::set<std::string> & headers );
+
+// scans the files reachable from files through #includes, stopping at
+// the files already scanned; used when the subset of the graph under a
+// few files is needed, and all modules haven't been scanned yet
+void scan_reachable_files( std::set< std::string > const & files );
+
+// the module graph
+
+void output_module_primary_report( std::string const & module, module_primary_actions & actions, bool track_sources, bool track_tests );
+
+void output_module_secondary_report( std::string const & module, std::set< std::string> deps, module_secondary_actions & actions );
+void output_module_secondary_report( std::string const & module, module_secondary_actions & actions );
+
+int const unknown_level = INT_MAX / 2;
+
+// level_map[ M ] is the level of M, or unknown_level
+void compute_module_levels( std::map< std::string, int > & level_map );
+
+void output_module_level_report( module_level_actions & actions );
+
+// gather secondary dependencies of modules
+void compute_secondary_dependencies( std::set< std::string > const & modules, std::map< std::string, std::set< std::string > > & secondary_deps );
+
+int module_weight( std::string const & module, std::map< std::string, std::set< std::string > > & secondary_deps );
+
+void output_module_subset_report_( std::string const & module, std::set<std::string> const & headers, std::map< std::string, std::set<std::string> > const & includes, module_subset_actions & actions );
+
+// --watch
+
+// clears the maps for a rescan, with what has been resolved and scanned
+// on demand
+void reset_dependency_maps();
+
+// rescans a single file and replaces its edges in the header maps
+void update_header_dependencies( std::string const & module, std::string const & header, fs::path const & path );
+
+// recomputes the module edges of module from the header edges of its files
+void update_module_dependencies( std::string const & module, bool track_sources, bool track_tests );
+
+#if defined(BOOSTDEP_HAS_ZLIB)
+
+// --git-rev
+
+class git_store;
+
+struct git_commit_info
+{
+    std::string id;
+    std::string tree;
+    std::vector< std::string > parents;
+
+    // committer time, in seconds since the epoch
+    long long time;
+};
+
+std::string git_hex( std::string const & id );
+
+// the revision of --git-rev, and the repository it is read from; they
+// are deleted on exit from main
+class git_revision_root
+{
+private:
+
+    git_store * store_;
+    git_revision * revision_;
+
+    git_revision_root( git_revision_root const & );
+    git_revision_root & operator=( git_revision_root const & );
+
+public:
+
+    git_revision_root();
+    ~git_revision_root();
+
+    // the revision rev of the repository at root, or 0 after printing
+    // an error
+    git_revision * open( fs::path const & root, std::string const & rev );
+};
+
+// --history
+
+struct history_entry
+{
+    std::string revision;
+    git_commit_info commit;
+
+    // empty when the revision could not be scanned
+    std::string error;
+
+    std::map< std::string, int > levels;
+    std::map< std::string, int > weights;
+
+    scan_counters counters;
+};
+
+// resolves revisions, as given to --history, in the repository at root,
+// and scans each of them; returns false after printing an error
+bool compute_history( fs::path const & root, std::string const & revisions, bool track_sources, bool track_tests, std::vector< history_entry > & entries );
+
+#endif // defined(BOOSTDEP_HAS_ZLIB)
+
+#endif // #ifndef BOOSTDEP_DEPENDENCY_SCAN_HPP_INCLUDED
@@ -0,0 +1,39 @@
+# Copyright 2026 agent
+# Distributed under the Boost Software License, Version 1.0.
+# See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+# Runs BOOSTDEP with --bench and --bench-cold on the FIXTURE tree, and
+# checks the summaries; the times vary, the rows and the scan counters
+# don't
+
+function( check_bench expected )
+  execute_process( COMMAND ${BOOSTDEP} --boost-root ${FIXTURE} ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE errors )
+
+  if( NOT result EQUAL 0 )
+    message( FATAL_ERROR "boostdep ${ARGN} failed: ${result}\n${errors}" )
+  endif()
+
+  # the times, with two decimals; the rest of a line is matched as is
+  set( t "[ ]+[0-9]+\\.[0-9][0-9]" )
+
+  foreach( line IN LISTS expected )
+    string( REPLACE "(" "\\(" line "${line}" )
+    string( REPLACE ")" "\\)" line "${line}" )
+    string( REPLACE "<times>" "${t}${t}${t}" line "${line}" )
+
+    if( NOT output MATCHES "(^|\n)${line}\n" )
+      message( FATAL_ERROR "boostdep ${ARGN}: no line matches '${line}' in\n${output}" )
+    endif()
+  endforeach()
+
+  # the output of the measured runs is discarded
+  if( output MATCHES "Level 0:|Primary dependencies" )
+    message( FATAL_ERROR "boostdep ${ARGN}: the output of the runs is shown\n${output}" )
+  endif()
+endfunction()
+
+# the first run scans all modules, the others reuse the maps
+check_bench( "Benchmark: 5 warm run(s) of --module-levels;(run)<times>;--module-levels<times>    peak RSS [0-9]+ KB;build_module_dependency_map<times>    peak RSS [0-9]+ KB;Scanned 8 files, 1163 bytes: .*" --bench 5 --module-levels )
+
+# each run scans the one header of beta again
+check_bench( "Benchmark: 3 cold run(s) of --primary beta;(run)<times>;build_header_map<times>    peak RSS [0-9]+ KB;Scanned 3 files, 300 bytes: .*" --bench-cold 3 --primary beta )
@@ -0,0 +1,88 @@
+// Copyright 2026 agent
+//
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt
+
+#include <boostdep/dependency_graph.hpp>
+#include <boost/core/lightweight_test.hpp>
+#include <stdexcept>
+
+static std::set< std::string > set_of( char const * s1, char const * s2 = 0 )
+{
+    std::set< std::string > r;
+
+    r.insert( s1 );
+    if( s2 ) r.insert( s2 );
+
+    return r;
+}
+
+// the argument is the path of test/fixture
+int main( int argc, char const* argv[] )
+{
+    BOOST_TEST_GE( argc, 2 );
+
+    if( argc < 2 ) return boost::report_errors();
+
+    BOOST_TEST_THROWS( boostdep::dependency_graph( std::string( argv[ 1 ] ) + "/libs" ), std::runtime_error );
+
+    boostdep::dependency_graph g( argv[ 1 ] );
+
+    // modules and headers
+
+    std::set< std::string > modules = set_of( "alpha", "beta" );
+    modules.insert( "core" );
+    modules.insert( "gamma" );
+
+    BOOST_TEST( g.modules() == modules );
+
+    BOOST_TEST( g.module_headers( "core" ) == set_of( "boost/core.hpp", "boost/core/detail/base.hpp" ) );
+
+    BOOST_TEST_EQ( g.header_module( "boost/alpha/first.hpp" ), "alpha" );
+    BOOST_TEST_EQ( g.header_module( "boost/core/detail/base.hpp" ), "core" );
+    BOOST_TEST_EQ( g.header_module( "boost/none.hpp" ), "" );
+
+    BOOST_TEST( g.header_includes( "boost/alpha.hpp" ) == set_of( "boost/alpha/first.hpp", "boost/core.hpp" ) );
+    BOOST_TEST( g.header_included_by( "boost/alpha/first.hpp" ) == set_of( "boost/alpha.hpp", "boost/alpha/second.hpp" ) );
+
+    // module dependencies
+
+    BOOST_TEST( g.primary( "beta" ) == set_of( "alpha" ) );
+    BOOST_TEST( g.primary( "core" ).empty() );
+
+    BOOST_TEST( g.secondary( "beta" ) == set_of( "core" ) );
+    BOOST_TEST( g.secondary( "alpha" ).empty() );
+
+    BOOST_TEST( g.reverse( "core" ) == set_of( "alpha", "gamma" ) );
+    BOOST_TEST( g.reverse( "beta" ) == set_of( "gamma" ) );
+    BOOST_TEST( g.reverse( "gamma" ).empty() );
+
+    std::map< std::string, int > levels = g.levels();
+
+    BOOST_TEST_EQ( levels[ "core" ], 0 );
+    BOOST_TEST_EQ( levels[ "alpha" ], 1 );
+    BOOST_TEST_EQ( levels[ "beta" ], 2 );
+
+    std::map< std::string, int > weights = g.weights();
+
+    BOOST_TEST_EQ( weights[ "core" ], 0 );
+    BOOST_TEST_EQ( weights[ "alpha" ], 1 );
+    BOOST_TEST_EQ( weights[ "beta" ], 2 );
+
+    std::map< std::string, std::vector< std::vector< std::string > > > subset = g.subset( "beta" );
+
+    BOOST_TEST_EQ( subset.size(), 2u );
+    BOOST_TEST_EQ( subset[ "core" ].size(), 1u );
+
+    if( subset[ "core" ].size() == 1 )
+    {
+        std::vector< std::string > const & path = subset[ "core" ][ 0 ];
+
+        BOOST_TEST_EQ( path.size(), 3u );
+        BOOST_TEST_EQ( path.front(), "boost/beta.hpp" );
+        BOOST_TEST_EQ( path.back(), "boost/core.hpp" );
+    }
+
+    return boost::report_errors();
+}
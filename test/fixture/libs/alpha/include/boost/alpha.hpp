@@ -0,0 +1,8 @@
+#ifndef BOOST_ALPHA_HPP_INCLUDED
+#define BOOST_ALPHA_HPP_INCLUDED
+
+// <boost/core.hpp> is redundant, <boost/alpha/first.hpp> includes it
+#include <boost/alpha/first.hpp>
+#include <boost/core.hpp>
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef BOOST_ALPHA_FIRST_HPP_INCLUDED
+#define BOOST_ALPHA_FIRST_HPP_INCLUDED
+
+// <boost/alpha/second.hpp> includes this header back, so it
+// reaches <boost/core.hpp> only through this one
+#include <boost/alpha/second.hpp>
+#include <boost/core.hpp>
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef BOOST_ALPHA_SECOND_HPP_INCLUDED
+#define BOOST_ALPHA_SECOND_HPP_INCLUDED
+
+#include <boost/alpha/first.hpp>
+
+#endif
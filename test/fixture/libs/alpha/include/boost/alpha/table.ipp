@@ -0,0 +1,2 @@
+// included more than once, without a guard
+#include <boost/core/detail/base.hpp>
@@ -0,0 +1,6 @@
+#ifndef BOOST_BETA_HPP_INCLUDED
+#define BOOST_BETA_HPP_INCLUDED
+
+#include <boost/alpha.hpp>
+
+#endif
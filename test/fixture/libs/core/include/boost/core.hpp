@@ -0,0 +1,6 @@
+#ifndef BOOST_CORE_HPP_INCLUDED
+#define BOOST_CORE_HPP_INCLUDED
+
+#include <boost/core/detail/base.hpp>
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef BOOST_CORE_DETAIL_BASE_HPP_INCLUDED
+#define BOOST_CORE_DETAIL_BASE_HPP_INCLUDED
+
+#include <cstddef>
+
+#endif
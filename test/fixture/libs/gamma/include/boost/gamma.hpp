@@ -0,0 +1,10 @@
+#ifndef BOOST_GAMMA_HPP_INCLUDED
+#define BOOST_GAMMA_HPP_INCLUDED
+
+#include <boost/core.hpp>
+
+#if defined(BOOST_GAMMA_USE_BETA)
+# include <boost/beta.hpp>
+#endif
+
+#endif
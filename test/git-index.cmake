@@ -0,0 +1,64 @@
+# Copyright 2026 agent
+# Distributed under the Boost Software License, Version 1.0.
+# See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+# Copies the FIXTURE tree to WORK, adds it to the index of a new git
+# repository, and checks that BOOSTDEP reports with --use-git-index what
+# it reports walking the tree, and that it skips the untracked files
+
+function( run_boostdep output )
+  execute_process( COMMAND ${BOOSTDEP} --boost-root ${WORK} ${ARGN} --module-overview --header-cost RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE err )
+
+  if( NOT result EQUAL 0 )
+    message( FATAL_ERROR "boostdep ${ARGN} failed: ${result}\n${err}" )
+  endif()
+
+  set( ${output} "${out}" PARENT_SCOPE )
+endfunction()
+
+function( run_git )
+  execute_process( COMMAND ${GIT} ${ARGN} WORKING_DIRECTORY ${WORK} RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE err )
+
+  if( NOT result EQUAL 0 )
+    message( FATAL_ERROR "git ${ARGN} failed: ${result}\n${err}" )
+  endif()
+endfunction()
+
+file( REMOVE_RECURSE ${WORK} )
+file( COPY ${FIXTURE}/ DESTINATION ${WORK} )
+
+run_git( init -q )
+run_git( add . )
+
+run_boostdep( walked )
+run_boostdep( indexed --use-git-index )
+
+if( NOT indexed STREQUAL walked )
+  message( FATAL_ERROR "--use-git-index reports\n${indexed}\n---\nwalking the tree reports\n${walked}" )
+endif()
+
+# an untracked header, as a build artifact would be
+file( WRITE ${WORK}/libs/gamma/include/boost/gamma/extra.hpp "#include <boost/alpha.hpp>\n" )
+
+run_boostdep( indexed2 --use-git-index )
+
+if( NOT indexed2 STREQUAL walked )
+  message( FATAL_ERROR "--use-git-index scans the untracked header:\n${indexed2}" )
+endif()
+
+run_boostdep( walked2 )
+
+if( walked2 STREQUAL walked )
+  message( FATAL_ERROR "walking the tree doesn't find the untracked header" )
+endif()
+
+# once added, the header is scanned
+run_git( add libs/gamma/include/boost/gamma/extra.hpp )
+
+run_boostdep( indexed3 --use-git-index )
+
+if( NOT indexed3 STREQUAL walked2 )
+  message( FATAL_ERROR "--use-git-index reports\n${indexed3}\n---\nwalking the tree reports\n${walked2}" )
+endif()
+
+file( REMOVE_RECURSE ${WORK} )
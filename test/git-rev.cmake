@@ -0,0 +1,92 @@
+# Copyright 2026 agent
+# Distributed under the Boost Software License, Version 1.0.
+# See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+# Commits the FIXTURE tree to a new git repository in WORK, commits a
+# change on top, and checks that BOOSTDEP reports with --git-rev what it
+# reports on a checkout of each revision, from loose objects and from a
+# packfile
+
+function( run_boostdep output )
+  execute_process( COMMAND ${BOOSTDEP} --boost-root ${WORK} ${ARGN} --module-overview --header-cost --secondary gamma RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE err )
+
+  if( NOT result EQUAL 0 )
+    message( FATAL_ERROR "boostdep ${ARGN} failed: ${result}\n${err}" )
+  endif()
+
+  set( ${output} "${out}" PARENT_SCOPE )
+endfunction()
+
+function( run_git )
+  execute_process( COMMAND ${GIT} -c user.name=boostdep -c user.email=boostdep@localhost ${ARGN} WORKING_DIRECTORY ${WORK} RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE err OUTPUT_STRIP_TRAILING_WHITESPACE )
+
+  if( NOT result EQUAL 0 )
+    message( FATAL_ERROR "git ${ARGN} failed: ${result}\n${err}" )
+  endif()
+
+  set( git_output "${out}" PARENT_SCOPE )
+endfunction()
+
+# the output for each revision is that on its checkout
+function( check_revisions )
+  foreach( rev IN LISTS ARGN )
+    run_boostdep( scanned --git-rev ${rev} )
+
+    if( NOT scanned STREQUAL "${checkout_${rev}}" )
+      message( FATAL_ERROR "--git-rev ${rev} reports\n${scanned}\n---\nthe checkout reports\n${checkout_${rev}}" )
+    endif()
+  endforeach()
+endfunction()
+
+file( REMOVE_RECURSE ${WORK} )
+file( COPY ${FIXTURE}/ DESTINATION ${WORK} )
+
+run_git( init -q )
+run_git( add . )
+run_git( commit -q -m first )
+
+# beta includes core instead of alpha, gamma gets a header that includes
+# alpha, and alpha loses one
+file( WRITE ${WORK}/libs/beta/include/boost/beta.hpp "#include <boost/core.hpp>\n" )
+file( WRITE ${WORK}/libs/gamma/include/boost/gamma/extra.hpp "#include <boost/alpha/first.hpp>\n" )
+file( REMOVE ${WORK}/libs/alpha/include/boost/alpha/table.ipp )
+
+run_git( add -A )
+run_git( commit -q -m second )
+
+run_boostdep( second )
+
+run_git( checkout -q HEAD~1 )
+run_boostdep( first )
+run_git( checkout -q - )
+
+if( first STREQUAL second )
+  message( FATAL_ERROR "the second revision reports as the first" )
+endif()
+
+# the first revision by its id, full and abbreviated, and relative to HEAD
+run_git( rev-parse HEAD~1 )
+string( SUBSTRING "${git_output}" 0 7 abbrev )
+
+set( checkout_HEAD~1 "${first}" )
+set( checkout_HEAD^ "${first}" )
+set( checkout_HEAD~0^1 "${first}" )
+set( checkout_${git_output} "${first}" )
+set( checkout_${abbrev} "${first}" )
+set( checkout_HEAD "${second}" )
+
+check_revisions( HEAD~1 HEAD^ HEAD~0^1 ${git_output} ${abbrev} HEAD )
+
+# the objects, packed and deltified
+run_git( gc -q )
+
+check_revisions( HEAD~1 HEAD )
+
+# a revision that doesn't exist is an error
+execute_process( COMMAND ${BOOSTDEP} --boost-root ${WORK} --git-rev HEAD~2 --module-overview RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET )
+
+if( result EQUAL 0 )
+  message( FATAL_ERROR "--git-rev HEAD~2 succeeds" )
+endif()
+
+file( REMOVE_RECURSE ${WORK} )
@@ -0,0 +1,202 @@
+// Copyright 2026 agent
+//
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt
+
+// the on demand resolution of headers to modules, checked against the
+// header map
+
+#include "../src/dependency_scan.hpp"
+#include <boost/core/lightweight_test.hpp>
+
+static void copy_tree( fs::path const & from, fs::path const & to )
+{
+    fs::create_directories( to );
+
+    fs::directory_iterator it( from ), last;
+
+    for( ; it != last; ++it )
+    {
+        fs::path const p = to / it->path().filename();
+
+        if( it->status().type() == fs::directory_file )
+        {
+            copy_tree( it->path(), p );
+        }
+        else
+        {
+            fs::copy_file( it->path(), p );
+        }
+    }
+}
+
+static void write_file( fs::path const & p, char const * text )
+{
+    fs::create_directories( p.parent_path() );
+
+    fs::ofstream os( p );
+    os << text;
+}
+
+// the primary report, as "module: header <- file" lines
+struct primary_actions: public module_primary_actions
+{
+    std::set< std::string > lines_;
+
+    std::string module_;
+    std::string header_;
+
+    void heading( std::string const & )
+    {
+    }
+
+    void module_start( std::string const & module )
+    {
+        module_ = module;
+    }
+
+    void module_end( std::string const & )
+    {
+    }
+
+    void header_start( std::string const & header )
+    {
+        header_ = header;
+    }
+
+    void header_end( std::string const & )
+    {
+    }
+
+    void from_header( std::string const & header )
+    {
+        lines_.insert( module_ + ": " + header_ + " <- " + header );
+    }
+};
+
+// the primary report of module, with the headers resolved on demand
+// when lazy is true, and from the header map otherwise
+static std::set< std::string > primary_report( fs::path const & root, std::string const & module, bool lazy, bool & complete )
+{
+    context c;
+    c.root_ = root;
+
+    context_scope scope( c );
+
+    if( !lazy )
+    {
+        build_header_map();
+    }
+
+    primary_actions actions;
+    output_module_primary_report( module, actions, false, false );
+
+    // the headers resolved on demand agree with the header map
+    if( lazy )
+    {
+        context c2;
+        c2.root_ = root;
+
+        {
+            context_scope scope2( c2 );
+            build_header_map();
+        }
+
+        for( std::map< std::string, std::string >::const_iterator i = c.header_map_.begin(); i != c.header_map_.end(); ++i )
+        {
+            BOOST_TEST_EQ( i->second, c2.header_map_[ i->first ] );
+        }
+
+        for( std::set< std::string >::const_iterator i = c.unresolved_headers_.begin(); i != c.unresolved_headers_.end(); ++i )
+        {
+            BOOST_TEST_EQ( c2.header_map_.count( *i ), 0u );
+        }
+    }
+
+    complete = c.header_map_complete_;
+    return actions.lines_;
+}
+
+// the report of each module is the same either way; returns whether the
+// full header map was built on demand for one of them
+static bool test_modules( fs::path const & root )
+{
+    char const * modules[] = { "alpha", "beta", "core", "gamma" };
+
+    bool walked = false;
+
+    for( std::size_t i = 0; i < sizeof( modules ) / sizeof( modules[ 0 ] ); ++i )
+    {
+        bool complete;
+
+        std::set< std::string > lazy = primary_report( root, modules[ i ], true, complete );
+        walked = walked || complete;
+
+        std::set< std::string > full = primary_report( root, modules[ i ], false, complete );
+
+        BOOST_TEST( !full.empty() || std::string( modules[ i ] ) == "core" );
+        BOOST_TEST( lazy == full );
+    }
+
+    return walked;
+}
+
+// the argument is the path of test/fixture, which is copied to a
+// temporary directory before headers are added
+int main( int argc, char const* argv[] )
+{
+    BOOST_TEST_GE( argc, 2 );
+
+    if( argc < 2 ) return boost::report_errors();
+
+    fs::path const root = fs::temp_directory_path() / fs::unique_path( "boostdep-headers-%%%%-%%%%" );
+
+    copy_tree( argv[ 1 ], root );
+
+    // a header named after no module, and headers outside boost/, in a
+    // module and not
+    write_file( root / "libs/core/include/boost/detail/core_fwd.hpp", "" );
+    write_file( root / "libs/alpha/include/alpha/config.h", "" );
+
+    write_file( root / "libs/gamma/include/boost/gamma/impl.hpp",
+        "#include <boost/detail/core_fwd.hpp>\n"
+        "#include <alpha/config.h>\n"
+        "#include <alpha/none.h>\n" );
+
+    write_file( root / "tools/boostdep/depinst/exceptions.txt", "core:\n  boost/detail/core_fwd.hpp\n" );
+
+    // everything is resolved from the conventions and the exceptions
+    BOOST_TEST( !test_modules( root ) );
+
+    {
+        bool complete;
+        std::set< std::string > lines = primary_report( root, "gamma", true, complete );
+
+        BOOST_TEST( lines.count( "core: boost/detail/core_fwd.hpp <- boost/gamma/impl.hpp" ) );
+        BOOST_TEST( lines.count( "alpha: alpha/config.h <- boost/gamma/impl.hpp" ) );
+    }
+
+    // headers in boost/ that the conventions and the exceptions don't
+    // place, or that the header map can't contain, are left to the walk
+    write_file( root / "libs/core/include/boost/detail/core_impl.hpp", "" );
+
+    write_file( root / "libs/beta/include/boost/beta/impl.hpp",
+        "#include <boost/detail/core_impl.hpp>\n"
+        "#include <boost/alpha/none.hpp>\n"
+        "#include <boost/none.hpp>\n"
+        "#include <boost/Alpha.hpp>\n"
+        "#include <boost/alpha/./first.hpp>\n" );
+
+    BOOST_TEST( test_modules( root ) );
+
+    // without the exceptions, only the walk is reliable
+    fs::remove( root / "libs/beta/include/boost/beta/impl.hpp" );
+    fs::remove( root / "tools/boostdep/depinst/exceptions.txt" );
+
+    BOOST_TEST( test_modules( root ) );
+
+    fs::remove_all( root );
+
+    return boost::report_errors();
+}
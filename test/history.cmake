@@ -0,0 +1,117 @@
+# Copyright 2026 agent
+# Distributed under the Boost Software License, Version 1.0.
+# See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+# Commits the FIXTURE tree and two changes to it to a new git repository
+# in WORK, and checks that the levels and weights BOOSTDEP reports for
+# each revision with --history are those of --git-rev
+
+function( run_boostdep output )
+  execute_process( COMMAND ${BOOSTDEP} --boost-root ${WORK} ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE err )
+
+  if( NOT result EQUAL 0 )
+    message( FATAL_ERROR "boostdep ${ARGN} failed: ${result}\n${err}" )
+  endif()
+
+  set( ${output} "${out}" PARENT_SCOPE )
+endfunction()
+
+function( run_git )
+  execute_process( COMMAND ${GIT} -c user.name=boostdep -c user.email=boostdep@localhost ${ARGN} WORKING_DIRECTORY ${WORK} RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE err )
+
+  if( NOT result EQUAL 0 )
+    message( FATAL_ERROR "git ${ARGN} failed: ${result}\n${err}" )
+  endif()
+endfunction()
+
+# the "module,level,weight" rows of the --module-levels and
+# --module-weights reports of commit
+function( git_rev_rows output commit )
+  run_boostdep( report --git-rev ${commit} --module-levels --module-weights )
+
+  string( REPLACE "\n" ";" lines "${report}" )
+
+  foreach( line IN LISTS lines )
+    if( line MATCHES "^(Level|Weight) ([0-9]+):$" )
+      set( kind ${CMAKE_MATCH_1} )
+      set( n ${CMAKE_MATCH_2} )
+    elseif( line MATCHES "^    ([a-z]+)" )
+      set( ${kind}_${CMAKE_MATCH_1} ${n} )
+      list( APPEND modules ${CMAKE_MATCH_1} )
+    endif()
+  endforeach()
+
+  list( REMOVE_DUPLICATES modules )
+  list( SORT modules )
+
+  set( rows "" )
+
+  foreach( m IN LISTS modules )
+    list( APPEND rows "${m},${Level_${m}},${Weight_${m}}" )
+  endforeach()
+
+  set( ${output} "${rows}" PARENT_SCOPE )
+endfunction()
+
+file( REMOVE_RECURSE ${WORK} )
+file( COPY ${FIXTURE}/ DESTINATION ${WORK} )
+
+run_git( init -q )
+run_git( add . )
+run_git( commit -q -m first )
+
+# beta includes core instead of alpha
+file( WRITE ${WORK}/libs/beta/include/boost/beta.hpp "#include <boost/core.hpp>\n" )
+run_git( commit -q -a -m second )
+
+# gamma includes alpha instead of beta and core
+file( WRITE ${WORK}/libs/gamma/include/boost/gamma.hpp "#include <boost/alpha.hpp>\n" )
+run_git( commit -q -a -m third )
+
+# the commits after the first
+run_boostdep( history --history HEAD~2..HEAD )
+
+string( REPLACE "\n" ";" lines "${history}" )
+list( REMOVE_AT lines 0 )
+
+set( commits "" )
+
+foreach( line IN LISTS lines )
+  if( line MATCHES "^[^,]*,([0-9a-f]+),[0-9]+,(.*)$" )
+    list( APPEND commits ${CMAKE_MATCH_1} )
+    list( APPEND rows_${CMAKE_MATCH_1} "${CMAKE_MATCH_2}" )
+  endif()
+endforeach()
+
+list( REMOVE_DUPLICATES commits )
+list( LENGTH commits n )
+
+if( NOT n EQUAL 2 )
+  message( FATAL_ERROR "--history HEAD~2..HEAD doesn't report two revisions:\n${history}" )
+endif()
+
+foreach( commit IN LISTS commits )
+  git_rev_rows( expected ${commit} )
+
+  if( NOT rows_${commit} STREQUAL expected )
+    message( FATAL_ERROR "--history reports for ${commit}\n${rows_${commit}}\n---\n--git-rev reports\n${expected}" )
+  endif()
+endforeach()
+
+# a list of revisions, given directly, in a file relative to the root,
+# and scanned in parallel
+file( WRITE ${WORK}/revisions.txt "# the revisions\nHEAD~2\r\nHEAD~1\nHEAD\n" )
+
+run_boostdep( listed --history HEAD~2,HEAD~1,HEAD )
+run_boostdep( from_file --history @revisions.txt )
+run_boostdep( parallel --jobs 3 --history HEAD~2,HEAD~1,HEAD )
+
+if( NOT from_file STREQUAL listed )
+  message( FATAL_ERROR "--history @revisions.txt reports\n${from_file}\n---\n--history HEAD~2,HEAD~1,HEAD reports\n${listed}" )
+endif()
+
+if( NOT parallel STREQUAL listed )
+  message( FATAL_ERROR "--jobs 3 --history reports\n${parallel}\n---\nwithout --jobs\n${listed}" )
+endif()
+
+file( REMOVE_RECURSE ${WORK} )
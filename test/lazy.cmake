@@ -0,0 +1,43 @@
+# Copyright 2026 agent
+# Distributed under the Boost Software License, Version 1.0.
+# See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+# Runs BOOSTDEP on the FIXTURE tree with commands that scan on demand,
+# and checks that they report what they report after --module-levels
+# has scanned all modules, while opening only the files they reach
+
+function( run_boostdep output errors )
+  execute_process( COMMAND ${BOOSTDEP} --boost-root ${FIXTURE} ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE err )
+
+  if( NOT result EQUAL 0 )
+    message( FATAL_ERROR "boostdep ${ARGN} failed: ${result}\n${err}" )
+  endif()
+
+  set( ${output} "${out}" PARENT_SCOPE )
+  set( ${errors} "${err}" PARENT_SCOPE )
+endfunction()
+
+run_boostdep( levels errors --module-levels )
+
+function( check_lazy files )
+  run_boostdep( lazy errors --profile ${ARGN} )
+  run_boostdep( full errors2 --module-levels ${ARGN} )
+
+  if( NOT full STREQUAL "${levels}${lazy}" )
+    message( FATAL_ERROR "boostdep ${ARGN}: the output differs from that after a full scan:\n${lazy}\n---\n${full}" )
+  endif()
+
+  if( NOT errors MATCHES "\nFiles opened: ${files}\n" )
+    message( FATAL_ERROR "boostdep ${ARGN}: ${files} files were to be opened\n${errors}" )
+  endif()
+endfunction()
+
+# beta reaches six of the eight files of the tree
+check_lazy( 6 --subset beta )
+check_lazy( 6 --subset-for libs/beta/include )
+
+# the files that gamma reaches are scanned once
+check_lazy( 7 --subset gamma --subset beta )
+
+# the files that include a header can only be found by scanning all
+check_lazy( 8 --header boost/alpha/first.hpp )
@@ -0,0 +1,31 @@
+// #include directives hidden in comments and literals, which name a
+// header of no module, and real ones written in unusual ways
+
+/*
+#include <boost/hidden.hpp>
+*/
+
+// a line comment continued onto the next line \
+#include <boost/hidden.hpp>
+
+# /* a comment before the name */ include <boost/core.hpp>
+
+#inc\
+lude <boost/alpha/second.hpp>
+
+char const * s1 = "#include <boost/hidden.hpp>";
+char const * s2 = "\"\\ /*";
+#include <boost/beta.hpp> // not in a comment: the string above has ended
+
+char const * s3 = "a string continued onto the next line \
+#include <boost/hidden.hpp>";
+
+char const * s4 = R"x(
+#include <boost/hidden.hpp>
+)" )x";
+
+char const c1 = '"';
+int const n1 = 1'000;
+#include <boost/gamma.hpp> // neither of the quotes above starts a literal
+
+/* #include <boost/hidden.hpp> */ #define X
@@ -0,0 +1,6 @@
+#ifndef BOOST_DELTA_HPP_INCLUDED
+#define BOOST_DELTA_HPP_INCLUDED
+
+#include <boost/beta.hpp>
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef BOOST_EPSILON_HPP_INCLUDED
+#define BOOST_EPSILON_HPP_INCLUDED
+
+#include <boost/epsilon/detail.hpp>
+#include <boost/core.hpp>
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef BOOST_EPSILON_DETAIL_HPP_INCLUDED
+#define BOOST_EPSILON_DETAIL_HPP_INCLUDED
+
+#include <boost/delta.hpp>
+
+#endif
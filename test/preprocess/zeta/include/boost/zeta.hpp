@@ -0,0 +1,16 @@
+#ifndef BOOST_ZETA_HPP_INCLUDED
+#define BOOST_ZETA_HPP_INCLUDED
+
+#include <boost/zeta/config.hpp>
+
+#include BOOST_ZETA_HEADER
+
+#if 0
+# include <boost/beta.hpp>
+#endif
+
+#ifdef BOOST_ZETA_NO_SUCH_MACRO
+# include <boost/gamma.hpp>
+#endif
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef BOOST_ZETA_CONFIG_HPP_INCLUDED
+#define BOOST_ZETA_CONFIG_HPP_INCLUDED
+
+#define BOOST_ZETA_HEADER <boost/alpha/second.hpp>
+
+#endif
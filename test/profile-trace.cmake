@@ -0,0 +1,56 @@
+# Copyright 2026 agent
+# Distributed under the Boost Software License, Version 1.0.
+# See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt
+
+# Runs BOOSTDEP with --profile=TRACE on the FIXTURE tree, and checks the
+# summary and the Chrome trace; the times vary, the events and the
+# counters don't
+
+cmake_minimum_required( VERSION 3.19 )
+
+execute_process( COMMAND ${BOOSTDEP} --boost-root ${FIXTURE} --profile=${TRACE} --jobs 2 --module-levels RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE summary )
+
+if( NOT result EQUAL 0 )
+  message( FATAL_ERROR "boostdep failed: ${result}" )
+endif()
+
+foreach( line "Files opened: 8" "Bytes read: 1163" "Includes parsed: 11" "Header map lookups: 11 (10 hits)" )
+  string( FIND "${summary}" "${line}" k )
+
+  if( k LESS 0 )
+    message( FATAL_ERROR "'${line}' is not in the summary:\n${summary}" )
+  endif()
+endforeach()
+
+file( READ ${TRACE} trace )
+
+# fails if the trace isn't valid JSON
+string( JSON n LENGTH "${trace}" traceEvents )
+math( EXPR last "${n} - 1" )
+
+set( events "" )
+
+foreach( i RANGE ${last} )
+  string( JSON ph GET "${trace}" traceEvents ${i} ph )
+
+  if( ph STREQUAL "X" )
+    string( JSON name GET "${trace}" traceEvents ${i} name )
+    string( JSON cat GET "${trace}" traceEvents ${i} cat )
+    string( JSON dur GET "${trace}" traceEvents ${i} dur )
+
+    if( dur LESS 0 )
+      message( FATAL_ERROR "'${name}' has a negative duration" )
+    endif()
+
+    list( APPEND events "${cat}:${name}" )
+  elseif( ph STREQUAL "M" )
+    string( JSON name GET "${trace}" traceEvents ${i} args name )
+    list( APPEND events "thread:${name}" )
+  endif()
+endforeach()
+
+foreach( event "command:--module-levels" "phase:build_header_map" "phase:build_module_dependency_map" "phase:compute_module_levels" "scan:alpha" "scan:beta" "scan:core" "scan:gamma" "thread:main" )
+  if( NOT event IN_LIST events )
+    message( FATAL_ERROR "'${event}' is not in the trace: ${events}" )
+  endif()
+endforeach()
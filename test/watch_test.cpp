@@ -0,0 +1,144 @@
+// Copyright 2026 agent
+//
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt
+
+// the incremental updates of --watch, checked against a fresh scan
+
+#include "../src/dependency_scan.hpp"
+#include <boost/core/lightweight_test.hpp>
+
+static void copy_tree( fs::path const & from, fs::path const & to )
+{
+    fs::create_directories( to );
+
+    fs::directory_iterator it( from ), last;
+
+    for( ; it != last; ++it )
+    {
+        fs::path const p = to / it->path().filename();
+
+        if( it->status().type() == fs::directory_file )
+        {
+            copy_tree( it->path(), p );
+        }
+        else
+        {
+            fs::copy_file( it->path(), p );
+        }
+    }
+}
+
+static void write_file( fs::path const & p, char const * text )
+{
+    fs::create_directories( p.parent_path() );
+
+    fs::ofstream os( p );
+    os << text;
+}
+
+static void scan( context & c, fs::path const & root )
+{
+    context_scope scope( c );
+
+    c.root_ = root;
+
+    build_header_map();
+    build_module_dependency_map( false, false );
+}
+
+// the header of module m, in the directory of --watch
+static void update( std::string const & m, std::string const & header )
+{
+    update_header_dependencies( m, header, module_include_path( m ) / header );
+    update_module_dependencies( m, false, false );
+}
+
+static void test_maps( context const & c, context const & c2 )
+{
+    BOOST_TEST( c.header_map_ == c2.header_map_ );
+    BOOST_TEST( c.modules_ == c2.modules_ );
+
+    BOOST_TEST( c.module_deps_ == c2.module_deps_ );
+    BOOST_TEST( c.reverse_deps_ == c2.reverse_deps_ );
+    BOOST_TEST( c.header_deps_ == c2.header_deps_ );
+    BOOST_TEST( c.header_includes_ == c2.header_includes_ );
+    BOOST_TEST( c.header_included_by_ == c2.header_included_by_ );
+}
+
+// the argument is the path of test/fixture, which is copied to a
+// temporary directory before the files are changed
+int main( int argc, char const* argv[] )
+{
+    BOOST_TEST_GE( argc, 2 );
+
+    if( argc < 2 ) return boost::report_errors();
+
+    fs::path const root = fs::temp_directory_path() / fs::unique_path( "boostdep-watch-%%%%-%%%%" );
+
+    copy_tree( argv[ 1 ], root );
+
+    context c;
+    scan( c, root );
+
+    {
+        context_scope scope( c );
+
+        // beta includes core instead of alpha
+        write_file( root / "libs/beta/include/boost/beta.hpp", "#include <boost/core.hpp>\n" );
+        update( "beta", "boost/beta.hpp" );
+
+        // first no longer includes core, second includes beta
+        write_file( root / "libs/alpha/include/boost/alpha/first.hpp", "#include <boost/alpha/second.hpp>\n" );
+        update( "alpha", "boost/alpha/first.hpp" );
+
+        write_file( root / "libs/alpha/include/boost/alpha/second.hpp", "#include <boost/alpha/first.hpp>\n#include <boost/beta.hpp>\n" );
+        update( "alpha", "boost/alpha/second.hpp" );
+    }
+
+    {
+        context c2;
+        scan( c2, root );
+
+        test_maps( c, c2 );
+    }
+
+    {
+        context_scope scope( c );
+
+        // alpha.hpp includes nothing
+        write_file( root / "libs/alpha/include/boost/alpha.hpp", "" );
+        update( "alpha", "boost/alpha.hpp" );
+    }
+
+    {
+        context c2;
+        scan( c2, root );
+
+        test_maps( c, c2 );
+    }
+
+    {
+        // the rescan after a header has been added
+        write_file( root / "libs/gamma/include/boost/gamma/extra.hpp", "#include <boost/alpha.hpp>\n" );
+
+        context_scope scope( c );
+
+        reset_dependency_maps();
+
+        build_header_map();
+        build_module_dependency_map( false, false );
+    }
+
+    {
+        context c2;
+        scan( c2, root );
+
+        test_maps( c, c2 );
+    }
+
+    fs::remove_all( root );
+
+    return boost::report_errors();
+}